@@ -0,0 +1,126 @@
+// Each kernel works through its input in fixed-size blocks. Results are first
+// written to local buffers, which the compiler knows cannot alias the inputs,
+// so that the arithmetic loops vectorize without runtime alias checks, and so
+// that the outputs are allowed to overwrite the inputs. The blocks are large
+// enough that the copy out of the buffers, which stay in L1, costs little next
+// to reading the inputs.
+
+#include <math.h>
+#include <string.h>
+#include "quat_batch.h"
+#include "trig.h"
+
+namespace geometry {
+namespace batch {
+
+namespace {
+  const size_t block = 256;
+
+  inline size_t min(size_t a, size_t b) { return a < b ? a : b; }
+
+  //! copy m results from local buffers into the output arrays
+  void store(const quat_array &out, size_t i0, size_t m,
+             const float *x, const float *y, const float *z, const float *w) {
+    memcpy(out.x + i0, x, m * sizeof(float));
+    memcpy(out.y + i0, y, m * sizeof(float));
+    memcpy(out.z + i0, z, m * sizeof(float));
+    memcpy(out.w + i0, w, m * sizeof(float));
+  }
+}
+
+void multiply(const quat_array &a, const quat_array &b, const quat_array &out,
+              size_t n) {
+  float x[block], y[block], z[block], w[block];
+
+  for (size_t i0 = 0; i0 < n; i0 += block) {
+    const size_t m = min(block, n - i0);
+    const float *ax = a.x + i0, *ay = a.y + i0, *az = a.z + i0, *aw = a.w + i0;
+    const float *bx = b.x + i0, *by = b.y + i0, *bz = b.z + i0, *bw = b.w + i0;
+
+    // same expressions as quat::operator*, with this = a and q = b
+    for (size_t j = 0; j < m; j++) {
+      x[j] = bx[j]*ax[j] - by[j]*ay[j] - bz[j]*az[j] - bw[j]*aw[j];
+      y[j] = bx[j]*ay[j] + by[j]*ax[j] + bz[j]*aw[j] - bw[j]*az[j];
+      z[j] = bx[j]*az[j] - by[j]*aw[j] + bz[j]*ax[j] + bw[j]*ay[j];
+      w[j] = bx[j]*aw[j] + by[j]*az[j] - bz[j]*ay[j] + bw[j]*ax[j];
+    }
+    store(out, i0, m, x, y, z, w);
+  }
+}
+
+void exp(const quat_array &q, const quat_array &out, size_t n) {
+  float x[block], y[block], z[block], w[block];
+  float nn[block], c[block], s[block], e[block];
+
+  for (size_t i0 = 0; i0 < n; i0 += block) {
+    const size_t m = min(block, n - i0);
+    const float *qx = q.x + i0, *qy = q.y + i0, *qz = q.z + i0, *qw = q.w + i0;
+
+    for (size_t j = 0; j < m; j++) {
+      nn[j] = sqrt(qy[j]*qy[j] + qz[j]*qz[j] + qw[j]*qw[j]);
+    }
+
+    // the transcendental functions only vectorize with a vector math library
+    for (size_t j = 0; j < m; j++) {
+      c[j] = trig::cos(nn[j]);
+      s[j] = trig::sin(nn[j]);
+      e[j] = trig::exp(qx[j]);
+    }
+
+    // same order of operations as geometry::exp
+    for (size_t j = 0; j < m; j++) {
+      float sn = nn[j] == 0 ? 0 : s[j] / nn[j];
+      x[j] = c[j] * e[j];
+      y[j] = (qy[j] * sn) * e[j];
+      z[j] = (qz[j] * sn) * e[j];
+      w[j] = (qw[j] * sn) * e[j];
+    }
+    store(out, i0, m, x, y, z, w);
+  }
+}
+
+void normalize(const quat_array &q, size_t n) {
+  float x[block], y[block], z[block], w[block];
+
+  for (size_t i0 = 0; i0 < n; i0 += block) {
+    const size_t m = min(block, n - i0);
+    const float *qx = q.x + i0, *qy = q.y + i0, *qz = q.z + i0, *qw = q.w + i0;
+
+    // as quat::normalize, but with one division rather than four, which would
+    // otherwise take longer than everything else here
+    for (size_t j = 0; j < m; j++) {
+      float inv = 1 / sqrt(qx[j]*qx[j] + qy[j]*qy[j] + qz[j]*qz[j] + qw[j]*qw[j]);
+      x[j] = qx[j] * inv;
+      y[j] = qy[j] * inv;
+      z[j] = qz[j] * inv;
+      w[j] = qw[j] * inv;
+    }
+    store(q, i0, m, x, y, z, w);
+  }
+}
+
+// see euler_angles<213>::euler_angles(const quat&)
+template<>
+void to_euler<213>(const quat_array &q, const euler_array &out, size_t n) {
+  float phi[block], theta[block], psi[block];
+
+  for (size_t i0 = 0; i0 < n; i0 += block) {
+    const size_t m = min(block, n - i0);
+    const float *qx = q.x + i0, *qy = q.y + i0, *qz = q.z + i0, *qw = q.w + i0;
+
+    // with GEOMETRY_FAST_TRIG, the trig functions are inline polynomials, so
+    // this whole loop vectorizes
+    for (size_t j = 0; j < m; j++) {
+      detail::euler_213_terms<float> t = quat(qx[j], qy[j], qz[j], qw[j]);
+      phi[j]   = trig::atan2(t.phi_s, t.phi_c);
+      theta[j] = trig::asin(t.theta_s);
+      psi[j]   = trig::atan2(t.psi_s, t.psi_c);
+    }
+    memcpy(out.phi + i0, phi, m * sizeof(float));
+    memcpy(out.theta + i0, theta, m * sizeof(float));
+    memcpy(out.psi + i0, psi, m * sizeof(float));
+  }
+}
+
+}
+}
@@ -0,0 +1,68 @@
+/**
+ * Batched versions of the quaternion operations in quat.h and euler.h, for
+ * processing many samples at once (such as when replaying recorded rollouts
+ * on a PC). They are not part of the firmware, whose block buffers would not
+ * fit on its stack.
+ *
+ * The data is stored as a structure of arrays, so that each loop touches
+ * contiguous memory and can be auto-vectorized by the compiler. The arithmetic
+ * in each kernel is written in the same order as the scalar version, so the
+ * results match those of the scalar path:
+ *
+ *  - multiply matches to within 2 ULP. It is bit-identical unless the
+ *    compiler contracts the sums into fused multiply-adds differently in the
+ *    two paths (GCC does this by default with -march targets that have FMA).
+ *  - normalize multiplies by the reciprocal of the norm, rather than dividing
+ *    by it, so matches to within 2 ULP.
+ *  - exp and to_euler additionally call the trig functions, and are
+ *    bit-identical to the scalar path unless vector math library variants are
+ *    used (-ffast-math with glibc's libmvec), when they match to within 4 ULP.
+ *
+ * Vectorizing the sqrt in normalize requires -fno-math-errno. to_euler only
+ * vectorizes with GEOMETRY_FAST_TRIG, whose trig functions are inline; exp
+ * still calls ::exp.
+ */
+#pragma once
+
+#include <stddef.h>
+
+#include "quat.h"
+#include "euler.h"
+
+namespace geometry {
+namespace batch {
+
+//! A view onto n quaternions, stored as separate arrays of each component
+struct quat_array {
+  float *x, *y, *z, *w;
+
+  quat get(size_t i) const { return quat(x[i], y[i], z[i], w[i]); }
+  void set(size_t i, const quat &q) const {
+    x[i] = q.x; y[i] = q.y; z[i] = q.z; w[i] = q.w;
+  }
+};
+
+//! A view onto n sets of euler angles, stored as separate arrays of each angle
+struct euler_array {
+  float *phi, *theta, *psi;
+};
+
+//! out[i] = a[i] * b[i]. out may alias a or b
+void multiply(const quat_array &a, const quat_array &b, const quat_array &out,
+              size_t n);
+
+//! out[i] = exp(q[i]). out may alias q
+void exp(const quat_array &q, const quat_array &out, size_t n);
+
+//! q[i].normalize()
+void normalize(const quat_array &q, size_t n);
+
+//! out[i] = euler_angles<order>(q[i])
+template<int order>
+void to_euler(const quat_array &q, const euler_array &out, size_t n);
+
+template<>
+void to_euler<213>(const quat_array &q, const euler_array &out, size_t n);
+
+}
+}
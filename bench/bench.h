@@ -0,0 +1,71 @@
+/**
+ * Helpers shared by the host benchmarks
+ */
+#pragma once
+
+#include <chrono>
+#include <random>
+#include <vector>
+#include <stddef.h>
+
+#include <quat.h>
+
+namespace bench {
+
+//! Prevent the compiler from optimizing away a computed value
+template<typename T>
+inline void keep(const T &value) {
+  asm volatile("" : : "g"(&value) : "memory");
+}
+
+//! Run f() repeatedly, and return the best time taken in nanoseconds
+template<typename F>
+double time_ns(F f, int repeats = 20) {
+  using clock = std::chrono::steady_clock;
+  double best = 1e300;
+  for (int r = 0; r < repeats; r++) {
+    auto start = clock::now();
+    f();
+    auto end = clock::now();
+    double ns = std::chrono::duration<double, std::nano>(end - start).count();
+    if (ns < best) best = ns;
+  }
+  return best;
+}
+
+//! Deterministic source of random inputs
+inline std::mt19937 &rng() {
+  static std::mt19937 gen(12345);
+  return gen;
+}
+
+//! A uniformly distributed random unit quaternion
+inline geometry::quat random_unit_quat() {
+  std::normal_distribution<float> d;
+  geometry::quat q(d(rng()), d(rng()), d(rng()), d(rng()));
+  q.normalize();
+  return q;
+}
+
+//! A random pure quaternion, with components in [-scale, scale]
+inline geometry::quat random_pure_quat(float scale) {
+  std::uniform_real_distribution<float> d(-scale, scale);
+  return geometry::quat(0, d(rng()), d(rng()), d(rng()));
+}
+
+//! Storage for the arrays underlying a quat_array
+struct quat_storage {
+  std::vector<float> x, y, z, w;
+  explicit quat_storage(size_t n) : x(n), y(n), z(n), w(n) {}
+};
+
+//! Distance between two floats, in units in the last place
+inline long ulp_diff(float a, float b) {
+  union { float f; int i; } ua = {a}, ub = {b};
+  if (a == b) return 0;
+  if ((ua.i < 0) != (ub.i < 0)) return ulp_diff(a, 0) + ulp_diff(0, b);
+  long d = long(ua.i) - long(ub.i);
+  return d < 0 ? -d : d;
+}
+
+}
@@ -0,0 +1,177 @@
+/**
+ * Accuracy and size of the CompactLogEntry encoding of lib/messages/compact_log.cpp.
+ *
+ * Random entries within the range of each field are packed and expanded, and
+ * must come back to within half a step, while those outside it saturate. This
+ * exits with an error unless that holds, the compact entries are at most a
+ * third of the size of the full ones on the wire, and entries with only some
+ * fields sent are smaller still, and expand back to just those fields.
+ */
+#include <stdio.h>
+#include <math.h>
+
+#include <messages.pb.h>
+#include <messages.fields.h>
+
+#include "compact_log.h"
+#include "bench.h"
+
+namespace {
+
+//! A float field of LogEntry, and the range and step it is packed with
+struct float_field {
+  float LogEntry::* value;
+  int bits;
+  int step;
+};
+
+#define FLOAT_FIELD(f) {&LogEntry::f, CompactLogBits_BITS_##f, CompactLogStep_STEP_##f}
+const float_field float_fields[] = {
+  FLOAT_FIELD(droll), FLOAT_FIELD(dyaw), FLOAT_FIELD(dAngleW), FLOAT_FIELD(dpitch),
+  FLOAT_FIELD(dAngleTT), FLOAT_FIELD(xOrigin), FLOAT_FIELD(yOrigin), FLOAT_FIELD(roll),
+  FLOAT_FIELD(yaw), FLOAT_FIELD(pitch), FLOAT_FIELD(x), FLOAT_FIELD(y),
+  FLOAT_FIELD(AngleW), FLOAT_FIELD(AngleTT), FLOAT_FIELD(TurntableInput),
+  FLOAT_FIELD(WheelInput), FLOAT_FIELD(ddx), FLOAT_FIELD(ddy), FLOAT_FIELD(ddz),
+  FLOAT_FIELD(lead), FLOAT_FIELD(latency),
+};
+#undef FLOAT_FIELD
+
+//! The largest value a field can hold
+double field_max(const float_field &f) {
+  return ldexp(1, f.bits - 1 - f.step);
+}
+
+size_t varint_size(uint64_t v) {
+  size_t n = 1;
+  while (v >>= 7) n++;
+  return n;
+}
+
+//! The encoded size of a message with every field set, from its host fields
+size_t encoded_size(const pb_host_msg &m, const void *msg) {
+  size_t n = 0;
+  for (size_t i = 0; i < m.n_fields; i++) {
+    const pb_host_field &f = m.fields[i];
+    const char *p = static_cast<const char *>(msg) + f.offset;
+    size_t count = f.count_offset == PB_HOST_NONE
+      ? 1 : *reinterpret_cast<const pb_size_t *>(static_cast<const char *>(msg) + f.count_offset);
+    size_t data = 0;
+    for (size_t j = 0; j < count; j++) {
+      if (f.kind == PB_HOST_FIXED32) data += 4;
+      else if (f.kind == PB_HOST_VARINT) data += varint_size(*reinterpret_cast<const uint32_t *>(p + j*f.size));
+    }
+    size_t key = varint_size(f.tag << 3);
+    // repeated scalars are packed
+    n += f.count_offset == PB_HOST_NONE ? key + data : key + varint_size(data) + data;
+  }
+  return n;
+}
+
+//! The size of a RobotMessage holding a message of the given size
+size_t robot_message_size(size_t n) {
+  return 1 + varint_size(n) + n;
+}
+
+const uint32_t all_fields = ~uint32_t(0);
+
+}
+
+int main() {
+  const size_t n = 10000;
+  double max_err[sizeof(float_fields) / sizeof(float_fields[0])] = {};
+  bool ints_ok = true;
+
+  for (size_t i = 0; i < n; i++) {
+    LogEntry l = {};
+    for (const float_field &f : float_fields) {
+      std::uniform_real_distribution<float> d(-field_max(f), field_max(f));
+      l.*f.value = d(bench::rng());
+    }
+    l.tick = bench::rng()() % 1000;
+    l.policy_version = bench::rng()() % 16;
+    l.policy_slot = bench::rng()() % 5;
+
+    CompactLogEntry c;
+    compactLogEntry(l, all_fields, c);
+    LogEntry e = {};
+    expandLogEntry(c, all_fields, e);
+
+    for (size_t k = 0; k < sizeof(float_fields) / sizeof(float_fields[0]); k++) {
+      const float_field &f = float_fields[k];
+      double err = fabs(e.*f.value - l.*f.value) / ldexp(1, -f.step);
+      // the top of the range is a step short of its limit
+      if (l.*f.value < field_max(f) - ldexp(1, -f.step)) max_err[k] = fmax(max_err[k], err);
+    }
+    ints_ok &= e.tick == l.tick && e.policy_version == l.policy_version &&
+               e.policy_slot == l.policy_slot;
+  }
+
+  // out of range values saturate, other than the angles, which wrap
+  LogEntry big = {};
+  big.droll = 1e6;
+  big.WheelInput = -1e6;
+  big.lead = NAN;
+  CompactLogEntry c;
+  compactLogEntry(big, all_fields, c);
+  LogEntry e = {};
+  expandLogEntry(c, all_fields, e);
+  const float_field &droll = float_fields[0], &wheel = float_fields[15];
+  bool saturates = e.droll == float(field_max(droll) - ldexp(1, -droll.step)) &&
+                   e.WheelInput == float(-field_max(wheel)) && e.lead == 0;
+
+  double worst = 0;
+  for (size_t k = 0; k < sizeof(float_fields) / sizeof(float_fields[0]); k++) {
+    worst = fmax(worst, max_err[k]);
+  }
+
+  // the sizes of entries with every field nonzero
+  LogEntry full = {};
+  for (const float_field &f : float_fields) full.*f.value = 1;
+  full.tick = 1000;
+  full.policy_version = 1;
+  full.policy_slot = 1;
+  compactLogEntry(full, all_fields, c);
+  size_t full_size = robot_message_size(encoded_size(LogEntry_host_msg, &full));
+  size_t compact_size = robot_message_size(encoded_size(CompactLogEntry_host_msg, &c));
+  double ratio = double(full_size) / compact_size;
+
+  // an entry of the attitude alone, as sent by `go ... fields roll,yaw,pitch`
+  const uint32_t attitude = 1 << (LogEntry_roll_tag - 1) | 1 << (LogEntry_yaw_tag - 1) |
+                            1 << (LogEntry_pitch_tag - 1);
+  CompactLogEntry a;
+  compactLogEntry(full, attitude, a);
+  size_t attitude_size = robot_message_size(encoded_size(CompactLogEntry_host_msg, &a));
+  LogEntry ea = {};
+  expandLogEntry(a, attitude, ea);
+  bool masked = attitude_size < compact_size && a.packed_count == 2 &&
+                ea.tick == full.tick && ea.roll == full.roll && ea.yaw == full.yaw &&
+                ea.pitch == full.pitch && ea.droll == 0 && ea.policy_slot == 0;
+
+  printf("max error %.3f steps, over %zu random entries\n", worst, n);
+  printf("single_log %zu bytes, compact_log %zu bytes, %.2fx smaller\n",
+         full_size, compact_size, ratio);
+  printf("roll, yaw and pitch only: compact_log %zu bytes\n", attitude_size);
+  printf("at 57600 baud: %.0f entries/s full, %.0f entries/s compact, before COBS\n",
+         57600 / 10.0 / full_size, 57600 / 10.0 / compact_size);
+
+  if (worst > 0.5 + 1e-3) {
+    printf("FAIL: an entry in range did not round trip to within half a step\n");
+    return 1;
+  }
+  if (!ints_ok) {
+    printf("FAIL: an integer field did not round trip\n");
+    return 1;
+  }
+  if (!saturates) {
+    printf("FAIL: out of range values did not saturate\n");
+    return 1;
+  }
+  if (ratio < 3) {
+    printf("FAIL: the compact encoding is not a third of the size\n");
+    return 1;
+  }
+  if (!masked) {
+    printf("FAIL: an entry with fewer fields did not shrink, or did not round trip\n");
+    return 1;
+  }
+}
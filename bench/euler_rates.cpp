@@ -0,0 +1,162 @@
+/**
+ * Regression test and timing of euler_rates_213, from both a quaternion and an
+ * attitude_cache.
+ *
+ * The reference is a central difference of the euler angles in double
+ * precision, over a step small enough that its truncation and rounding errors
+ * are both far below a float ULP of the rates. The analytic rates must then
+ * agree with it to a few float epsilons of their own magnitude, which catches
+ * a sign or a swapped term anywhere in the inverted kinematic equation. This
+ * exits with an error if they do not.
+ *
+ * The timing is against the finite-difference method that intAngVel
+ * previously used: integrating a second quaternion over dt/10, converting it
+ * to euler angles, and differencing.
+ */
+#include <stdio.h>
+#include <math.h>
+#include <float.h>
+#include <vector>
+
+#include <quat.h>
+#include <euler.h>
+#include <attitude.h>
+
+#include "intAngVel.h"
+#include "bench.h"
+
+using namespace geometry;
+
+// normally defined in main.cpp
+extern const float dt = 50e-3f;
+
+namespace {
+
+float unwrap_angle(float next, float last) {
+  return last + remainder(next - last, 2*M_PI);
+}
+
+//! The previous implementation, from intAngVel
+joint_angles finite_difference_rates(const quat &q, const joint_angles &orient,
+                                     const Vector3<float> &w) {
+  float dt_small = dt/10;
+  quat q1 = integrate_quat(QuatIntegrator::Exp, q, w, dt_small);
+  q1.normalize();
+
+  // phi is unwrapped too, as the random attitudes include pitches near pi
+  joint_angles e1 = q1;
+  e1.phi = unwrap_angle(e1.phi, orient.phi);
+  e1.psi = unwrap_angle(e1.psi, orient.psi);
+  joint_angles dorient;
+  dorient.phi   = (e1.phi   - orient.phi)/dt_small;
+  dorient.theta = (e1.theta - orient.theta)/dt_small;
+  dorient.psi   = (e1.psi   - orient.psi)/dt_small;
+  return dorient;
+}
+
+//! The (2,1,3) euler angles of q, in double precision
+void euler_213(const basic_quat<double> &q, double e[3]) {
+  detail::euler_213_terms<double> t = q;
+  e[0] = atan2(t.phi_s, t.phi_c);
+  e[1] = asin(t.theta_s);
+  e[2] = atan2(t.psi_s, t.psi_c);
+}
+
+//! q rotated for a time h at the rate w, as integrate_quat does
+basic_quat<double> rotate(const quat &q, const Vector3<float> &w, double h) {
+  Vector3<double> v(w.x * h / 2, w.y * h / 2, w.z * h / 2);
+  double a = sqrt(v.squaredNorm());
+  double s = a > 0 ? sin(a) / a : 1;
+  return basic_quat<double>(cos(a), v.x * s, v.y * s, v.z * s) * basic_quat<double>(q);
+}
+
+/**
+ * The euler rates by a central difference over +-h in double precision. With
+ * h = 1e-6 s the truncation error, h^2/6 of the third derivative, is below
+ * 1e-6 * |w|^3 / cos(theta)^5 * 1e-12, and the rounding error is about
+ * 1e-16 / h = 1e-10; both are far below a float epsilon of the rates.
+ */
+Vector3<double> reference_rates(const quat &q, const Vector3<float> &w) {
+  const double h = 1e-6;
+  double ep[3], em[3];
+  euler_213(rotate(q, w, h), ep);
+  euler_213(rotate(q, w, -h), em);
+  return Vector3<double>(remainder(ep[0] - em[0], 2*M_PI) / (2*h),
+                         remainder(ep[1] - em[1], 2*M_PI) / (2*h),
+                         remainder(ep[2] - em[2], 2*M_PI) / (2*h));
+}
+
+//! The largest error of the analytic rates a against the reference r
+double rates_error(const joint_angles &a, const Vector3<double> &r) {
+  return fmax(fabs(a.phi - r.x), fmax(fabs(a.theta - r.y), fabs(a.psi - r.z)));
+}
+
+}
+
+int main() {
+  const size_t n = 100000;
+  const float max_theta = 80 * M_PI / 180;
+
+  // random attitudes away from gimbal lock, and rates of up to 5 rad/s
+  std::vector<quat> qs;
+  std::vector<joint_angles> orients;
+  std::vector<Vector3<float>> ws;
+  while (qs.size() < n) {
+    quat q = bench::random_unit_quat();
+    joint_angles e = q;
+    if (fabs(e.theta) > max_theta) continue;
+    qs.push_back(q);
+    orients.push_back(e);
+    ws.push_back(bench::random_pure_quat(5).v());
+  }
+
+  // the rates are up to |w| / cos(theta)^2 in size, and each is a few float
+  // operations on the terms of the quaternion, so should be correct to a few
+  // float epsilons of that
+  double max_err = 0, max_err_45 = 0, max_ratio = 0;
+  for (size_t i = 0; i < n; i++) {
+    Vector3<double> r = reference_rates(qs[i], ws[i]);
+    double err = fmax(rates_error(euler_rates_213(qs[i], ws[i]), r),
+                      rates_error(euler_rates_213(attitude_cache(qs[i]), ws[i]), r));
+    double c = cos(orients[i].theta);
+    double scale = sqrt(ws[i].squaredNorm()) / (c*c);
+    double bound = 4 * FLT_EPSILON * scale;
+    max_err = fmax(max_err, err);
+    if (c > cos(M_PI / 4)) max_err_45 = fmax(max_err_45, err);
+    max_ratio = fmax(max_ratio, err / bound);
+  }
+  printf("max |analytic - double precision central difference|, for |w| < 5 rad/s:\n");
+  printf("  |theta| < 45 deg: %.3e rad/s\n", max_err_45);
+  printf("  |theta| < 80 deg: %.3e rad/s, which is %.2f of 4 float epsilons of |w| / cos(theta)^2\n",
+         max_err, max_ratio);
+
+  std::vector<joint_angles> out(n);
+  double t_fd = bench::time_ns([&]{
+    for (size_t i = 0; i < n; i++) out[i] = finite_difference_rates(qs[i], orients[i], ws[i]);
+    bench::keep(out);
+  }, 5);
+  double t_an = bench::time_ns([&]{
+    for (size_t i = 0; i < n; i++) out[i] = euler_rates_213(qs[i], ws[i]);
+    bench::keep(out);
+  }, 5);
+  printf("finite difference %.2f ns/op, analytic %.2f ns/op, speedup %.1fx\n",
+         t_fd / n, t_an / n, t_fd / t_an);
+
+  std::vector<attitude_cache> atts;
+  for (const quat &q : qs) atts.push_back(attitude_cache(q));
+  double t_cache = bench::time_ns([&]{
+    for (size_t i = 0; i < n; i++) out[i] = euler_rates_213(atts[i], ws[i]);
+    bench::keep(out);
+  }, 5);
+  double t_build = bench::time_ns([&]{
+    for (size_t i = 0; i < n; i++) atts[i] = attitude_cache(qs[i]);
+    bench::keep(atts);
+  }, 5);
+  printf("from an attitude_cache %.2f ns/op, building the cache %.2f ns/op\n",
+         t_cache / n, t_build / n);
+
+  if (max_ratio > 1) {
+    printf("FAIL: the analytic rates are wrong by more than float rounding\n");
+    return 1;
+  }
+}
@@ -0,0 +1,138 @@
+/**
+ * Accuracy and speed of the fixed-point attitude pipeline (ATTITUDE_FIXED_POINT)
+ * compared with the float one.
+ *
+ * Both versions of intAngVel are run side by side on the same gyro trace. Pass
+ * the name of a text file with one "wx wy wz" reading in rad/s per line (at the
+ * control rate) to use a recorded trace; otherwise a synthetic trace of a
+ * wobbling, spinning robot with sensor noise is used.
+ */
+#include <stdio.h>
+#include <math.h>
+#include <vector>
+
+#include <quat.h>
+#include <euler.h>
+#include <fixed.h>
+
+#include "intAngVel.h"
+#include "bench.h"
+
+using namespace geometry;
+
+// normally defined in main.cpp
+extern const float dt = 50e-3f;
+
+namespace {
+
+std::vector<Vector3<float>> read_trace(const char *fname) {
+  std::vector<Vector3<float>> trace;
+  FILE *f = fopen(fname, "r");
+  if (!f) {
+    perror(fname);
+    return trace;
+  }
+  float x, y, z;
+  while (fscanf(f, "%f %f %f", &x, &y, &z) == 3) {
+    trace.push_back(Vector3<float>(x, y, z));
+  }
+  fclose(f);
+  return trace;
+}
+
+//! A couple of minutes of the robot wobbling about upright while spinning
+std::vector<Vector3<float>> synthetic_trace(size_t n) {
+  std::normal_distribution<float> noise(0, 0.01f);
+  std::vector<Vector3<float>> trace;
+  for (size_t i = 0; i < n; i++) {
+    float t = i * dt;
+    trace.push_back(Vector3<float>(
+      0.8f * sinf(1.3f * t)        + noise(bench::rng()),
+      0.5f * sinf(0.7f * t + 1.0f) + noise(bench::rng()),
+      2.0f + 1.5f * sinf(0.1f * t) + noise(bench::rng())));
+  }
+  return trace;
+}
+
+double angle_diff(double a, double b) {
+  return fabs(remainder(a - b, 2*M_PI));
+}
+
+struct error_stats {
+  double max = 0, sum_sq = 0;
+  size_t n = 0;
+  void update(double err) {
+    if (err > max) max = err;
+    sum_sq += err * err;
+    n++;
+  }
+  double rms() const { return sqrt(sum_sq / n); }
+};
+
+}
+
+int main(int argc, char **argv) {
+  std::vector<Vector3<float>> trace = argc > 1 ? read_trace(argv[1])
+                                               : synthetic_trace(2400);
+  if (trace.empty()) return 1;
+  printf("Integrating %zu gyro readings (%s)\n", trace.size(),
+         argc > 1 ? argv[1] : "synthetic");
+
+  // the same readings, as gyroRead<q16_16> would produce them
+  std::vector<Vector3<q16_16>> trace_fixed;
+  for (const Vector3<float> &w : trace) trace_fixed.push_back(w);
+
+  quat qf(1, 0, 0, 0);
+  basic_quat<q2_29> qx(1, 0, 0, 0);
+  Vector3<float> w0f = Vector3<float>::Zero();
+  Vector3<q16_16> w0x = Vector3<q16_16>::Zero();
+  attitude_cache af(qf), ax(qx);
+  joint_angles dof, dox;
+
+  error_stats angle[3], rate[3], q_err;
+  for (size_t i = 0; i < trace.size(); i++) {
+    intAngVel(qf, w0f, trace[i], af, dof);
+    intAngVel(qx, w0x, trace_fixed[i], ax, dox);
+
+    const joint_angles &of = af.angles, &ox = ax.angles;
+    float fa[3] = {of.phi, of.theta, of.psi}, xa[3] = {ox.phi, ox.theta, ox.psi};
+    float fr[3] = {dof.phi, dof.theta, dof.psi}, xr[3] = {dox.phi, dox.theta, dox.psi};
+    for (int j = 0; j < 3; j++) {
+      angle[j].update(angle_diff(fa[j], xa[j]));
+      rate[j].update(fabs(fr[j] - xr[j]));
+    }
+    quat d = quat(qx) - qf;
+    q_err.update(d.norm());
+  }
+
+  const char *names[3] = {"phi", "theta", "psi"};
+  printf("deviation of fixed-point from float\n");
+  printf("           angle (rad)           rate (rad/s)\n");
+  printf("           max       rms         max       rms\n");
+  for (int j = 0; j < 3; j++) {
+    printf("  %-6s   %.2e  %.2e    %.2e  %.2e\n", names[j],
+           angle[j].max, angle[j].rms(), rate[j].max, rate[j].rms());
+  }
+  printf("  |q - q_float|: max %.2e, rms %.2e\n", q_err.max, q_err.rms());
+
+  // speed, although on the host the float version has hardware support
+  double t_float = bench::time_ns([&]{
+    for (size_t i = 0; i < trace.size(); i++) intAngVel(qf, w0f, trace[i], af, dof);
+    bench::keep(qf);
+  }, 5);
+  double t_fixed = bench::time_ns([&]{
+    for (size_t i = 0; i < trace.size(); i++) intAngVel(qx, w0x, trace_fixed[i], ax, dox);
+    bench::keep(qx);
+  }, 5);
+  printf("intAngVel: float %.0f ns/op, fixed %.0f ns/op (host FPU, not indicative of the MCU)\n",
+         t_float / trace.size(), t_fixed / trace.size());
+
+  // exp saturates, rather than overflowing, at the limits of the format
+  typedef fixed<16> q16_16;
+  const q16_16 q_max = q16_16::from_raw(detail::fixed_max), q_min = q16_16::from_raw(detail::fixed_min);
+  if (trig::exp(q_max) != q_max || trig::exp(q_min) != q16_16(0) ||
+      fabs(float(trig::exp(q16_16(1.0f))) - M_E) > 1e-4) {
+    printf("FAIL: fixed point exp does not saturate at the limits of its range\n");
+    return 1;
+  }
+}
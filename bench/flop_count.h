@@ -0,0 +1,95 @@
+/**
+ * A float which counts the operations done on it, for projecting the cost of
+ * the geometry library on the PIC32, where every one of them is a call into
+ * the soft-float library.
+ *
+ * Include this before quat.h, so that the trig overloads below are visible to
+ * the templates there.
+ */
+#pragma once
+
+#include <math.h>
+
+#include <trig.h>
+
+namespace bench {
+
+//! The number of each soft-float operation done
+struct flop_counts {
+  double add, mul, div, cmp, sqrt, sin, cos, atan2, asin, exp;
+
+  flop_counts &operator/=(double n) {
+    add /= n; mul /= n; div /= n; cmp /= n; sqrt /= n;
+    sin /= n; cos /= n; atan2 /= n; asin /= n; exp /= n;
+    return *this;
+  }
+
+  /**
+   * Rough cycle counts for each operation on the 80MHz PIC32MX, which has no
+   * FPU. These are estimates for the compiler's soft-float library, and should
+   * be calibrated against a build with -DPROFILE_UPDATE.
+   */
+  double pic32_cycles() const {
+    return 60*add + 55*mul + 140*div + 25*cmp + 350*sqrt
+         + 1600*(sin + cos) + 2400*atan2 + 2200*asin + 1700*exp;
+  }
+};
+
+//! The counts since the last reset
+inline flop_counts &counts() {
+  static flop_counts c;
+  return c;
+}
+
+inline void reset_counts() {
+  counts() = flop_counts();
+}
+
+/**
+ * A float which records each arithmetic operation and comparison in counts().
+ * Negation is not counted, as it only flips the sign bit. Construction from a
+ * constant is not counted either, as on the target it is folded.
+ */
+struct counted {
+  float v;
+  counted() {}
+  constexpr counted(float v) : v(v) {}
+  explicit operator float() const { return v; }
+
+  friend counted operator+(counted a, counted b) { counts().add++; return a.v + b.v; }
+  friend counted operator-(counted a, counted b) { counts().add++; return a.v - b.v; }
+  friend counted operator*(counted a, counted b) { counts().mul++; return a.v * b.v; }
+  friend counted operator/(counted a, counted b) { counts().div++; return a.v / b.v; }
+  friend counted operator-(counted a)            { return -a.v; }
+
+  counted &operator+=(counted b) { return *this = *this + b; }
+  counted &operator-=(counted b) { return *this = *this - b; }
+  counted &operator*=(counted b) { return *this = *this * b; }
+  counted &operator/=(counted b) { return *this = *this / b; }
+
+  friend bool operator< (counted a, counted b) { counts().cmp++; return a.v <  b.v; }
+  friend bool operator> (counted a, counted b) { counts().cmp++; return a.v >  b.v; }
+  friend bool operator<=(counted a, counted b) { counts().cmp++; return a.v <= b.v; }
+  friend bool operator>=(counted a, counted b) { counts().cmp++; return a.v >= b.v; }
+  friend bool operator==(counted a, counted b) { counts().cmp++; return a.v == b.v; }
+  friend bool operator!=(counted a, counted b) { counts().cmp++; return a.v != b.v; }
+
+  // for Vector3::normalize, which finds sqrt by argument-dependent lookup
+  friend counted sqrt(counted x) { counts().sqrt++; return ::sqrtf(x.v); }
+};
+
+}
+
+namespace geometry {
+namespace trig {
+  inline bench::counted sqrt(bench::counted x) { bench::counts().sqrt++; return ::sqrtf(x.v); }
+  inline bench::counted exp(bench::counted x)  { bench::counts().exp++;  return ::expf(x.v); }
+  inline bench::counted sin(bench::counted x)  { bench::counts().sin++;  return ::sinf(x.v); }
+  inline bench::counted cos(bench::counted x)  { bench::counts().cos++;  return ::cosf(x.v); }
+  inline bench::counted asin(bench::counted x) { bench::counts().asin++; return ::asinf(x.v); }
+  inline bench::counted atan2(bench::counted y, bench::counted x) {
+    bench::counts().atan2++;
+    return ::atan2f(y.v, x.v);
+  }
+}
+}
@@ -0,0 +1,163 @@
+/**
+ * Micro-benchmarks of the kernels in lib/geometry which the control loop uses,
+ * each run over randomized inputs.
+ *
+ * usage: geometry [--count]
+ *
+ * By default, this reports the time per call on this machine. With --count,
+ * it instead runs each kernel on a counting float type, and reports the
+ * average number of each soft-float operation per call, along with a rough
+ * projection of the time this takes on the PIC32.
+ */
+#include "flop_count.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <vector>
+
+#include <quat.h>
+#include <euler.h>
+
+#include "bench.h"
+
+using namespace geometry;
+
+namespace {
+
+const size_t n = 4096;
+const double pic32_hz = 80e6;
+
+//! Randomized inputs, in a given scalar type
+template<typename T>
+struct inputs {
+  std::vector<basic_quat<T>> a, b;  // random unit quaternions
+  std::vector<basic_quat<T>> c;     // random quaternions, with components in [-1, 1]
+  std::vector<Vector3<T>> u, v;     // random vectors, with components in [-1, 1]
+  std::vector<Vector3<T>> h;        // half the rotation of one 50ms tick, at up to 5 rad/s
+  std::vector<T> phi, theta, psi;   // random euler angles
+
+  inputs() {}
+
+  template<typename U>
+  explicit inputs(const inputs<U> &o) {
+    auto vec = [](const Vector3<U> &x) { return Vector3<T>(T(x.x), T(x.y), T(x.z)); };
+    for (size_t i = 0; i < n; i++) {
+      a.push_back(basic_quat<T>(o.a[i]));
+      b.push_back(basic_quat<T>(o.b[i]));
+      c.push_back(basic_quat<T>(o.c[i]));
+      u.push_back(vec(o.u[i]));
+      v.push_back(vec(o.v[i]));
+      h.push_back(vec(o.h[i]));
+      phi.push_back(T(o.phi[i]));
+      theta.push_back(T(o.theta[i]));
+      psi.push_back(T(o.psi[i]));
+    }
+  }
+};
+
+inputs<float> random_inputs() {
+  std::uniform_real_distribution<float> unit(-1, 1), angle(-M_PI, M_PI);
+  inputs<float> in;
+  for (size_t i = 0; i < n; i++) {
+    in.a.push_back(bench::random_unit_quat());
+    in.b.push_back(bench::random_unit_quat());
+    float k = unit(bench::rng());
+    in.c.push_back(quat(k, bench::random_pure_quat(1).v()));
+    in.u.push_back(bench::random_pure_quat(1).v());
+    in.v.push_back(bench::random_pure_quat(1).v());
+    in.h.push_back(bench::random_pure_quat(5 * 50e-3f / 2 / sqrtf(3)).v());
+    in.phi.push_back(angle(bench::rng()));
+    in.theta.push_back(angle(bench::rng()) / 2);
+    in.psi.push_back(angle(bench::rng()));
+  }
+  return in;
+}
+
+/**
+ * Call measure(name, f) for each kernel, where f(i) runs the kernel on the
+ * i-th input. The euler_angles<213> members are only defined for float, so
+ * these use the detail:: functions which the members forward to.
+ */
+template<typename T, typename Measure>
+void each_kernel(const inputs<T> &in, Measure &&measure) {
+  measure("quat * quat", [&](size_t i) {
+    return in.a[i] * in.b[i];
+  });
+  measure("exp", [&](size_t i) {
+    return exp(in.c[i]);
+  });
+  measure("exp_pure (tick)", [&](size_t i) {
+    return exp_pure(in.h[i]);
+  });
+  measure("normalize", [&](size_t i) {
+    basic_quat<T> q = in.c[i];
+    q.normalize();
+    return q;
+  });
+  measure("renormalize", [&](size_t i) {
+    basic_quat<T> q = in.a[i];
+    q.renormalize();
+    return q;
+  });
+  measure("between", [&](size_t i) {
+    return basic_quat<T>::between(in.u[i], in.v[i]);
+  });
+  measure("quat -> euler<213>", [&](size_t i) {
+    euler_angles<213> e;
+    detail::to_euler_213(in.a[i], e.phi, e.theta, e.psi);
+    return e;
+  });
+  measure("remove_psi", [&](size_t i) {
+    return detail::remove_psi_213(in.a[i]);
+  });
+  measure("euler<213> -> quat", [&](size_t i) {
+    return detail::from_euler_213(in.phi[i], in.theta[i], in.psi[i]);
+  });
+}
+
+struct time_kernel {
+  template<typename F>
+  void operator()(const char *name, F f) {
+    std::vector<decltype(f(0))> out(n);
+    double t = bench::time_ns([&]{
+      for (size_t i = 0; i < n; i++) out[i] = f(i);
+      bench::keep(out);
+    }) / n;
+    printf("  %-20s %8.2f %10.2f\n", name, t, 1e3 / t);
+  }
+};
+
+struct count_kernel {
+  template<typename F>
+  void operator()(const char *name, F f) {
+    bench::reset_counts();
+    for (size_t i = 0; i < n; i++) bench::keep(f(i));
+    bench::flop_counts c = bench::counts();
+    c /= n;
+    double cycles = c.pic32_cycles();
+    printf("  %-20s %5.1f %5.1f %5.1f %5.1f %5.2f %5.2f %5.2f %5.2f %5.2f %5.2f %8.0f %7.1f\n",
+           name, c.add, c.mul, c.div, c.cmp, c.sqrt,
+           c.sin, c.cos, c.atan2, c.asin, c.exp, cycles, cycles / pic32_hz * 1e6);
+  }
+};
+
+}
+
+int main(int argc, char *argv[]) {
+  bool count = argc > 1 && strcmp(argv[1], "--count") == 0;
+  inputs<float> in = random_inputs();
+
+  if (!count) {
+    printf("  %-20s %8s %10s\n", "kernel", "ns/op", "Mops/s");
+    each_kernel(in, time_kernel());
+  }
+  else {
+    printf("average soft-float operations per call, and projected cost at %.0f MHz\n",
+           pic32_hz / 1e6);
+    printf("  %-20s %5s %5s %5s %5s %5s %5s %5s %5s %5s %5s %8s %7s\n", "kernel",
+           "add", "mul", "div", "cmp", "sqrt", "sin", "cos", "atan2", "asin", "exp",
+           "cycles", "us");
+    each_kernel(inputs<bench::counted>(in), count_kernel());
+  }
+}
@@ -0,0 +1,160 @@
+/**
+ * Accuracy and speed of the fused raw-to-SI conversion in imuCalibration.h.
+ *
+ * Random corrections and offsets are applied to random raw readings, and the
+ * result compared to the same affine map in double precision. This exits with
+ * an error if any component is off by more than the q16_16 rounding.
+ *
+ * The host has an FPU, so the timings here favour the float passes. The cost
+ * on the PIC32 is projected from the soft-float calls each float version
+ * makes, and the instructions of the integer one.
+ */
+#include <stdio.h>
+#include <math.h>
+#include <vector>
+
+#include "imuCalibration.h"
+#include "bench.h"
+#include "flop_count.h"
+
+using namespace geometry;
+
+namespace {
+
+// the gyro sensitivity and chip-to-robot rotation, from gyroAccel.cpp
+const float RAD_PER_LSB_S = (M_PI / 180) / 14.375;
+const float nominal[3][3] = {
+  {0,             0,              -RAD_PER_LSB_S},
+  {RAD_PER_LSB_S, 0,              0             },
+  {0,             -RAD_PER_LSB_S, 0             }
+};
+
+//! correction * nominal * (raw - raw_offset) - bias, in double precision
+void reference(const ImuCorrection &c, const Vector3<float> &raw_offset,
+               const Vector3<int16_t> &raw, double out[3]) {
+  double v[3];
+  for (int i = 0; i < 3; i++) {
+    v[i] = 0;
+    for (int j = 0; j < 3; j++) v[i] += double(nominal[i][j]) * (raw[j] - double(raw_offset[j]));
+  }
+  for (int i = 0; i < 3; i++) {
+    out[i] = -double(c.bias[i]);
+    for (int j = 0; j < 3; j++) out[i] += double(c.matrix[i][j]) * v[j];
+  }
+}
+
+//! The previous conversion: subtract the offset, scale, then permute
+Vector3<float> three_pass(const Vector3<int16_t> &raw, const Vector3<float> &raw_offset) {
+  Vector3<float> v = (raw - raw_offset) * RAD_PER_LSB_S;
+  return Vector3<float>(-v.z, v.x, -v.y);
+}
+
+//! The same, followed by the correction, as the fused pass replaces
+Vector3<float> corrected_passes(const Vector3<int16_t> &raw, const Vector3<float> &raw_offset,
+                                const ImuCorrection &c) {
+  Vector3<float> v = three_pass(raw, raw_offset), out;
+  for (int i = 0; i < 3; i++) {
+    out[i] = c.matrix[i][0] * v.x + c.matrix[i][1] * v.y + c.matrix[i][2] * v.z - c.bias[i];
+  }
+  return out;
+}
+
+/**
+ * The projected PIC32 cycles of the fused pass to q16_16: a few loads and a
+ * MADD per gain, and moving the sum out of the accumulator, a 64-bit shift and
+ * a saturation per row, all in single-cycle instructions.
+ */
+double fused_cycles() {
+  return 12 * 3 + 5 * 9;
+}
+
+}
+
+int main() {
+  const size_t n_cal = 200, n = 4096;
+  std::uniform_real_distribution<float> misalign(-0.05f, 0.05f), offset(-200, 200), bias(-0.1f, 0.1f);
+  std::uniform_int_distribution<int> lsb(-32768, 32767);
+
+  std::vector<Vector3<int16_t>> raws(n);
+  for (auto &r : raws) {
+    int x = lsb(bench::rng()), y = lsb(bench::rng()), z = lsb(bench::rng());
+    r = Vector3<int16_t>(x, y, z);
+  }
+
+  // rounding to q16_16, and float rounding of the folded offset
+  const double tol_q16_16 = ldexp(1, -17) + 1e-6;
+  double max_err_f = 0, max_err_q = 0;
+  for (size_t k = 0; k < n_cal; k++) {
+    ImuCorrection c = ImuCorrection::identity();
+    for (int i = 0; i < 3; i++) {
+      for (int j = 0; j < 3; j++) c.matrix[i][j] += misalign(bench::rng());
+      c.bias[i] = bias(bench::rng());
+    }
+    Vector3<float> raw_offset;
+    for (int i = 0; i < 3; i++) raw_offset[i] = offset(bench::rng());
+
+    RawToSI cal(nominal);
+    cal.setCorrection(c);
+    cal.setRawOffset(raw_offset);
+
+    for (const auto &raw : raws) {
+      double ref[3];
+      reference(c, raw_offset, raw, ref);
+      Vector3<float> f = cal.apply<float>(raw);
+      Vector3<q16_16> q = cal.apply<q16_16>(raw);
+      for (int i = 0; i < 3; i++) {
+        max_err_f = fmax(max_err_f, fabs(f[i] - ref[i]));
+        max_err_q = fmax(max_err_q, fabs(double(q[i]) - ref[i]));
+      }
+    }
+  }
+  printf("max error vs double precision, over %zu calibrations: float %.2e, q16_16 %.2e rad/s,"
+         " of %.2e rad/s per LSB\n", n_cal, max_err_f, max_err_q, RAD_PER_LSB_S);
+
+  // speed, although on the host the three-pass version has a hardware FPU
+  RawToSI cal(nominal);
+  Vector3<float> raw_offset(12.5f, -30.25f, 4);
+  ImuCorrection c = ImuCorrection::identity();
+  c.matrix[0][1] = 0.02f;
+  c.bias = Vector3<float>(0.01f, -0.02f, 0.03f);
+  cal.setRawOffset(raw_offset);
+  cal.setCorrection(c);
+  std::vector<Vector3<float>> out(n);
+  std::vector<Vector3<q16_16>> out_q(n);
+  double t_three = bench::time_ns([&]{
+    for (size_t i = 0; i < n; i++) out[i] = three_pass(raws[i], raw_offset);
+    bench::keep(out);
+  });
+  double t_corrected = bench::time_ns([&]{
+    for (size_t i = 0; i < n; i++) out[i] = corrected_passes(raws[i], raw_offset, c);
+    bench::keep(out);
+  });
+  double t_fused = bench::time_ns([&]{
+    for (size_t i = 0; i < n; i++) out[i] = cal.apply<float>(raws[i]);
+    bench::keep(out);
+  });
+  double t_fused_q = bench::time_ns([&]{
+    for (size_t i = 0; i < n; i++) out_q[i] = cal.apply<q16_16>(raws[i]);
+    bench::keep(out_q);
+  });
+  printf("three passes %.2f ns/op, with the correction %.2f ns/op, fused to float %.2f ns/op,"
+         " fused to q16_16 %.2f ns/op (host FPU, not indicative of the MCU)\n",
+         t_three / n, t_corrected / n, t_fused / n, t_fused_q / n);
+
+  // the soft-float operations of each version, other than the three int to
+  // float conversions that all but the q16_16 one make
+  bench::flop_counts three = {}, corrected = {}, fused_f = {};
+  three.add = 3; three.mul = 3;                    // subtract the offset, scale
+  corrected = three;
+  corrected.add += 9; corrected.mul += 9;          // and the matrix and bias
+  fused_f.mul = 3;                                 // q16_16 to float
+  printf("projected PIC32 cycles: three passes %.0f, with the correction %.0f,"
+         " fused to float %.0f, fused to q16_16 %.0f\n",
+         three.pic32_cycles(), corrected.pic32_cycles(),
+         fused_cycles() + fused_f.pic32_cycles(), fused_cycles());
+
+  if (fmax(max_err_f, max_err_q) > tol_q16_16) {
+    printf("FAIL: error larger than the q16_16 rounding of %.2e\n", tol_q16_16);
+    return 1;
+  }
+}
@@ -0,0 +1,119 @@
+/**
+ * Accuracy and speed of the QuatIntegrator strategies in intAngVel.cpp, and of
+ * quat::renormalize against quat::normalize.
+ *
+ * Each strategy takes a single step from a random attitude, with the rotation
+ * per step ranging from that of a slow wobble to that of a fast spin at the
+ * 50ms control rate. The result is compared to a double-precision reference.
+ */
+#include <stdio.h>
+#include <math.h>
+#include <vector>
+
+#include <quat.h>
+
+#include "intAngVel.h"
+#include "bench.h"
+
+using namespace geometry;
+
+// normally defined in main.cpp
+extern const float dt = 50e-3f;
+
+namespace {
+
+//! exp(0.5 w dt) * q0, in double precision
+void reference_step(const quat &q0, const Vector3<float> &w, float dt,
+                    double out[4]) {
+  double h[3] = {w.x * dt / 2.0, w.y * dt / 2.0, w.z * dt / 2.0};
+  double n = sqrt(h[0]*h[0] + h[1]*h[1] + h[2]*h[2]);
+  double s = n == 0 ? 1 : sin(n) / n;
+  double e[4] = {cos(n), h[0] * s, h[1] * s, h[2] * s};
+  double q[4] = {q0.x, q0.y, q0.z, q0.w};
+
+  // the same product as quat::operator*, with this = e and q = q0
+  out[0] = q[0]*e[0] - q[1]*e[1] - q[2]*e[2] - q[3]*e[3];
+  out[1] = q[0]*e[1] + q[1]*e[0] + q[2]*e[3] - q[3]*e[2];
+  out[2] = q[0]*e[2] - q[1]*e[3] + q[2]*e[0] + q[3]*e[1];
+  out[3] = q[0]*e[3] + q[1]*e[2] - q[2]*e[1] + q[3]*e[0];
+}
+
+struct strategy {
+  const char *name;
+  QuatIntegrator method;
+};
+
+const strategy strategies[] = {
+  {"Exp",        QuatIntegrator::Exp},
+  {"Taylor",     QuatIntegrator::Taylor},
+  {"FirstOrder", QuatIntegrator::FirstOrder},
+  {"Aleksi",     QuatIntegrator::Aleksi},
+};
+
+}
+
+int main() {
+  const size_t n = 4096;
+  const float rates[] = {0.5f, 2, 5, 10, 20, 35};  // rad/s
+
+  std::vector<quat> q0(n);
+  std::vector<Vector3<float>> axes(n);
+  for (size_t i = 0; i < n; i++) {
+    q0[i] = bench::random_unit_quat();
+    axes[i] = bench::random_unit_quat().v().normalized();
+  }
+
+  printf("max error of one renormalized %.0f ms step, vs double precision\n", dt * 1e3);
+  printf("  rad/s  angle   ");
+  for (const strategy &s : strategies) printf(" %-10s", s.name);
+  printf("\n");
+  for (float rate : rates) {
+    printf("  %5.1f  %.4f  ", rate, rate * dt / 2);
+    for (const strategy &s : strategies) {
+      double max_err = 0;
+      for (size_t i = 0; i < n; i++) {
+        Vector3<float> w = axes[i] * rate;
+        quat q = integrate_quat(s.method, q0[i], w, dt);
+        q.renormalize();
+        double ref[4];
+        reference_step(q0[i], w, dt, ref);
+        double err = fabs(q.x - ref[0]) + fabs(q.y - ref[1])
+                   + fabs(q.z - ref[2]) + fabs(q.w - ref[3]);
+        if (err > max_err) max_err = err;
+      }
+      printf(" %.2e  ", max_err);
+    }
+    printf("\n");
+  }
+
+  // speed at a typical rate, where Taylor uses its 4th-order series
+  std::vector<Vector3<float>> ws(n);
+  for (size_t i = 0; i < n; i++) ws[i] = axes[i] * 5.0f;
+  std::vector<quat> out(n);
+  printf("integrate_quat + renormalize at 5 rad/s\n");
+  for (const strategy &s : strategies) {
+    double t = bench::time_ns([&]{
+      for (size_t i = 0; i < n; i++) {
+        out[i] = integrate_quat(s.method, q0[i], ws[i], dt);
+        out[i].renormalize();
+      }
+      bench::keep(out);
+    });
+    printf("  %-10s  %6.2f ns/op\n", s.name, t / n);
+  }
+
+  // renormalizing a quaternion which is almost unit already
+  for (size_t i = 0; i < n; i++) out[i] = integrate_quat(QuatIntegrator::Taylor, q0[i], ws[i], dt);
+  std::vector<quat> tmp(n);
+  double t_norm = bench::time_ns([&]{
+    tmp = out;
+    for (quat &q : tmp) q.normalize();
+    bench::keep(tmp);
+  });
+  double t_renorm = bench::time_ns([&]{
+    tmp = out;
+    for (quat &q : tmp) q.renormalize();
+    bench::keep(tmp);
+  });
+  printf("normalize %.2f ns/op, renormalize %.2f ns/op\n", t_norm / n, t_renorm / n);
+}
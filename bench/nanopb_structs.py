@@ -0,0 +1,227 @@
+#! python3
+"""
+Write C headers with the same structs, enums and tag macros as nanopb
+generates for a set of .proto files, so that code using the messages (like
+src/policy.cpp) can be compiled and run on a PC.
+
+Only the layout is generated, without any field descriptors, so the messages
+cannot be encoded or decoded. Strings, bytes and repeated fields without a
+static size become pb_callback_t, as they do in nanopb.
+
+usage: nanopb_structs.py descriptor_set out_dir [options_dir]
+
+where descriptor_set is written by `protoc -o ... --include_imports`. The
+max_count of repeated fields is read from the `<name>.options` files in
+options_dir, as nanopb does. No other options are supported.
+
+Alongside each `<name>.pb.h`, this also writes a `<name>.fields.h`, with the
+tables that pb_host.h needs to decode the messages into the structs.
+"""
+import sys
+from pathlib import Path
+
+from google.protobuf import descriptor_pb2
+
+FD = descriptor_pb2.FieldDescriptorProto
+
+c_types = {
+    FD.TYPE_FLOAT: 'float',
+    FD.TYPE_DOUBLE: 'double',
+    FD.TYPE_INT32: 'int32_t',
+    FD.TYPE_SINT32: 'int32_t',
+    FD.TYPE_SFIXED32: 'int32_t',
+    FD.TYPE_UINT32: 'uint32_t',
+    FD.TYPE_FIXED32: 'uint32_t',
+    FD.TYPE_INT64: 'int64_t',
+    FD.TYPE_SINT64: 'int64_t',
+    FD.TYPE_SFIXED64: 'int64_t',
+    FD.TYPE_UINT64: 'uint64_t',
+    FD.TYPE_FIXED64: 'uint64_t',
+    FD.TYPE_BOOL: 'bool',
+}
+
+prelude = """\
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifndef PB_HOST_STRUCTS
+#define PB_HOST_STRUCTS
+typedef uint_least16_t pb_size_t;
+typedef struct pb_callback_s {
+    void *funcs;
+    void *arg;
+} pb_callback_t;
+#endif
+"""
+
+
+def read_options(path):
+    """ The max_count of each `Message.field` in a nanopb options file """
+    counts = {}
+    if not path.exists():
+        return counts
+    for line in path.read_text().splitlines():
+        parts = line.split('#')[0].split()
+        if not parts:
+            continue
+        for opt in parts[1:]:
+            key, _, value = opt.partition(':')
+            if key == 'max_count':
+                counts[parts[0]] = int(value)
+    return counts
+
+
+def field_type(f):
+    """ The C type of a field, or None if nanopb would use a callback """
+    if f.label == FD.LABEL_REPEATED or f.type in (FD.TYPE_STRING, FD.TYPE_BYTES):
+        return None
+    if f.type in (FD.TYPE_MESSAGE, FD.TYPE_ENUM):
+        return f.type_name.lstrip('.')
+    return c_types[f.type]
+
+
+def message_struct(m, max_counts):
+    lines = ['typedef struct _{} {{'.format(m.name)]
+    oneofs = {}
+    for f in sorted(m.field, key=lambda f: f.number):
+        if f.HasField('oneof_index'):
+            oneofs.setdefault(f.oneof_index, []).append(f)
+            if len(oneofs[f.oneof_index]) > 1:
+                continue
+            name = m.oneof_decl[f.oneof_index].name
+            lines.append('    pb_size_t which_{};'.format(name))
+            lines.append('    union {')
+            for g in sorted(m.field, key=lambda g: g.number):
+                if g.HasField('oneof_index') and g.oneof_index == f.oneof_index:
+                    lines.append('        {} {};'.format(field_type(g), g.name))
+            lines.append('    }} {};'.format(name))
+            continue
+        t = field_type(f)
+        count = max_counts.get('{}.{}'.format(m.name, f.name))
+        if f.label == FD.LABEL_REPEATED and count is not None:
+            f_single = FD()
+            f_single.CopyFrom(f)
+            f_single.label = FD.LABEL_OPTIONAL
+            lines.append('    pb_size_t {}_count;'.format(f.name))
+            lines.append('    {} {}[{}];'.format(field_type(f_single), f.name, count))
+        elif t is None:
+            lines.append('    pb_callback_t {};'.format(f.name))
+        else:
+            if f.type == FD.TYPE_MESSAGE:
+                # proto3 submessages still get a has_ field
+                lines.append('    bool has_{};'.format(f.name))
+            lines.append('    {} {};'.format(t, f.name))
+    if not m.field:
+        lines.append('    char dummy_field;')
+    lines.append('}} {};'.format(m.name))
+
+    for f in m.field:
+        lines.append('#define {}_{}_tag {}'.format(m.name, f.name, f.number))
+    return '\n'.join(lines)
+
+
+kinds = {
+    FD.TYPE_FLOAT: 'PB_HOST_FIXED32',
+    FD.TYPE_FIXED32: 'PB_HOST_FIXED32',
+    FD.TYPE_SFIXED32: 'PB_HOST_FIXED32',
+    FD.TYPE_DOUBLE: 'PB_HOST_FIXED64',
+    FD.TYPE_FIXED64: 'PB_HOST_FIXED64',
+    FD.TYPE_SFIXED64: 'PB_HOST_FIXED64',
+    FD.TYPE_SINT32: 'PB_HOST_SVARINT',
+    FD.TYPE_SINT64: 'PB_HOST_SVARINT',
+    FD.TYPE_MESSAGE: 'PB_HOST_SUBMSG',
+}
+
+
+def message_fields(m, max_counts):
+    """ The pb_host_msg describing the fields of a message """
+    none = 'PB_HOST_NONE'
+    entries = []
+    for f in sorted(m.field, key=lambda f: f.number):
+        count = max_counts.get('{}.{}'.format(m.name, f.name))
+        repeated = f.label == FD.LABEL_REPEATED
+        if (repeated and count is None) or f.type in (FD.TYPE_STRING, FD.TYPE_BYTES):
+            entries.append('{{{}, PB_HOST_SKIP, 0, 0, {n}, {n}, 0, {n}, NULL}}'.format(f.number, n=none))
+            continue
+
+        member = f.name
+        which = has = count_offset = none
+        if f.HasField('oneof_index'):
+            oneof = m.oneof_decl[f.oneof_index].name
+            member = '{}.{}'.format(oneof, f.name)
+            which = 'offsetof({}, which_{})'.format(m.name, oneof)
+        elif f.type == FD.TYPE_MESSAGE and not repeated:
+            has = 'offsetof({}, has_{})'.format(m.name, f.name)
+        if repeated:
+            count_offset = 'offsetof({}, {}_count)'.format(m.name, f.name)
+
+        offset = 'offsetof({}, {})'.format(m.name, member)
+        size = 'sizeof((({} *)0)->{}{})'.format(m.name, member, '[0]' if repeated else '')
+        submsg = 'NULL'
+        if f.type == FD.TYPE_MESSAGE:
+            submsg = '&{}_host_msg'.format(f.type_name.lstrip('.'))
+        entries.append('{{{}, {}, {}, {}, {}, {}, {}, {}, {}}}'.format(
+            f.number, kinds.get(f.type, 'PB_HOST_VARINT'), offset, size, has,
+            count_offset, count or 0, which, submsg))
+
+    lines = ['static const pb_host_field {}_host_fields[] = {{'.format(m.name)]
+    lines += ['    {},'.format(e) for e in entries]
+    if not entries:
+        lines.append('    {0, PB_HOST_SKIP, 0, 0, 0, 0, 0, 0, NULL},')
+    lines.append('};')
+    lines.append('static const pb_host_msg {0}_host_msg = {{{0}_host_fields, {1}}};'.format(
+        m.name, len(entries)))
+    return '\n'.join(lines)
+
+
+def dependency_order(messages):
+    """ Order the messages so that each comes after those it contains """
+    by_name = {m.name: m for m in messages}
+    ordered, seen = [], set()
+
+    def visit(m):
+        if m.name in seen:
+            return
+        seen.add(m.name)
+        for f in m.field:
+            sub = by_name.get(f.type_name.lstrip('.'))
+            if f.type == FD.TYPE_MESSAGE and sub is not None:
+                visit(sub)
+        ordered.append(m)
+
+    for m in messages:
+        visit(m)
+    return ordered
+
+
+def enum_decl(e):
+    values = ',\n'.join(
+        '    {}_{} = {}'.format(e.name, v.name, v.number) for v in e.value)
+    return 'typedef enum _{0} {{\n{1}\n}} {0};'.format(e.name, values)
+
+
+def main(descriptor_set, out_dir, options_dir=None):
+    fds = descriptor_pb2.FileDescriptorSet()
+    fds.ParseFromString(Path(descriptor_set).read_bytes())
+    for f in fds.file:
+        stem = Path(f.name).stem
+        max_counts = {}
+        if options_dir is not None:
+            max_counts = read_options(Path(options_dir) / '{}.options'.format(stem))
+        parts = [prelude]
+        parts += ['#include "{}.pb.h"'.format(Path(d).stem) for d in f.dependency]
+        parts += [enum_decl(e) for e in f.enum_type]
+        parts += [message_struct(m, max_counts) for m in f.message_type]
+        (Path(out_dir) / '{}.pb.h'.format(stem)).write_text('\n\n'.join(parts) + '\n')
+
+        parts = ['#pragma once', '#include <stddef.h>', '#include "pb_host.h"',
+                 '#include "{}.pb.h"'.format(stem)]
+        parts += ['#include "{}.fields.h"'.format(Path(d).stem) for d in f.dependency]
+        parts += [message_fields(m, max_counts) for m in dependency_order(f.message_type)]
+        (Path(out_dir) / '{}.fields.h'.format(stem)).write_text('\n\n'.join(parts) + '\n')
+
+
+if __name__ == '__main__':
+    main(*sys.argv[1:])
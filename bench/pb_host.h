@@ -0,0 +1,191 @@
+/**
+ * A minimal protobuf decoder for the host structs of nanopb_structs.py, so
+ * that the benchmarks can read messages captured from the robot without the
+ * nanopb runtime.
+ *
+ * nanopb_structs.py writes a `<name>.fields.h` for each .proto, with a
+ * pb_host_msg describing where each field of each message lives. Only the
+ * field types used by our messages are supported. Fields that nanopb would
+ * decode through a callback are skipped, and can be read with pb_host_next
+ * instead.
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+//! How a field is stored, and how it is encoded
+enum pb_host_kind {
+  PB_HOST_VARINT,   //!< bool, enums, and the int and uint types
+  PB_HOST_SVARINT,  //!< the zigzag-encoded sint types
+  PB_HOST_FIXED32,  //!< float, fixed32 and sfixed32
+  PB_HOST_FIXED64,  //!< double, fixed64 and sfixed64
+  PB_HOST_SUBMSG,   //!< an embedded message
+  PB_HOST_SKIP,     //!< strings, bytes and repeated fields without a size
+};
+
+//! An offset for fields which are not in a oneof, or not repeated
+const size_t PB_HOST_NONE = ~size_t(0);
+
+struct pb_host_msg;
+
+struct pb_host_field {
+  uint32_t tag;
+  pb_host_kind kind;
+  size_t offset;        //!< of the value, or the first element
+  size_t size;          //!< of the value, or of each element
+  size_t has_offset;    //!< of the bool has_ field of submessages
+  size_t count_offset;  //!< of the pb_size_t _count field of repeated fields
+  size_t max_count;
+  size_t which_offset;  //!< of the pb_size_t which_ field of a oneof
+  const pb_host_msg *submsg;
+};
+
+struct pb_host_msg {
+  const pb_host_field *fields;
+  size_t n_fields;
+};
+
+//! A view of the bytes of an encoded message
+struct pb_host_stream {
+  const uint8_t *p;
+  const uint8_t *end;
+};
+
+namespace pb_host_detail {
+  inline bool read_varint(pb_host_stream &s, uint64_t &v) {
+    v = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+      if (s.p == s.end) return false;
+      uint8_t b = *s.p++;
+      v |= uint64_t(b & 0x7f) << shift;
+      if (!(b & 0x80)) return true;
+    }
+    return false;
+  }
+
+  inline bool read_bytes(pb_host_stream &s, void *dest, size_t n) {
+    if (size_t(s.end - s.p) < n) return false;
+    memcpy(dest, s.p, n);
+    s.p += n;
+    return true;
+  }
+
+  //! Store the low bytes of v, for a little-endian host
+  inline void store(void *dest, uint64_t v, size_t size) {
+    memcpy(dest, &v, size);
+  }
+
+  //! Decode one scalar value of a field
+  inline bool read_scalar(pb_host_stream &s, const pb_host_field &f, void *dest) {
+    uint64_t v;
+    switch (f.kind) {
+      case PB_HOST_VARINT:
+        if (!read_varint(s, v)) return false;
+        store(dest, v, f.size);
+        return true;
+      case PB_HOST_SVARINT:
+        if (!read_varint(s, v)) return false;
+        store(dest, (v >> 1) ^ (~(v & 1) + 1), f.size);
+        return true;
+      case PB_HOST_FIXED32:
+        return read_bytes(s, dest, 4);
+      case PB_HOST_FIXED64:
+        return read_bytes(s, dest, 8);
+      default:
+        return false;
+    }
+  }
+
+  inline bool skip(pb_host_stream &s, uint32_t wire_type) {
+    uint64_t v;
+    switch (wire_type) {
+      case 0: return read_varint(s, v);
+      case 1: if (s.end - s.p < 8) return false; s.p += 8; return true;
+      case 2:
+        if (!read_varint(s, v) || uint64_t(s.end - s.p) < v) return false;
+        s.p += v;
+        return true;
+      case 5: if (s.end - s.p < 4) return false; s.p += 4; return true;
+      default: return false;
+    }
+  }
+
+  inline const pb_host_field *find(const pb_host_msg &m, uint32_t tag) {
+    for (size_t i = 0; i < m.n_fields; i++) {
+      if (m.fields[i].tag == tag) return &m.fields[i];
+    }
+    return nullptr;
+  }
+
+  template<typename T>
+  T &at(void *base, size_t offset) {
+    return *reinterpret_cast<T *>(static_cast<uint8_t *>(base) + offset);
+  }
+}
+
+/**
+ * Read the next field of a message, returning its tag and wire type, and
+ * skipping over its encoded value, which is returned in `value`. For
+ * length-delimited fields, this excludes the length.
+ */
+inline bool pb_host_next(pb_host_stream &s, uint32_t &tag, uint32_t &wire_type,
+                         pb_host_stream &value) {
+  uint64_t key;
+  if (!pb_host_detail::read_varint(s, key)) return false;
+  tag = uint32_t(key >> 3);
+  wire_type = uint32_t(key & 7);
+  value.p = s.p;
+  if (!pb_host_detail::skip(s, wire_type)) return false;
+  value.end = s.p;
+  if (wire_type == 2) {
+    uint64_t n;
+    pb_host_detail::read_varint(value, n);
+  }
+  return true;
+}
+
+/**
+ * Decode a message into its host struct, which should already be zeroed.
+ * Returns false if the message is malformed, or has more elements in a
+ * repeated field than its max_count.
+ */
+inline bool pb_host_decode(pb_host_stream s, const pb_host_msg &m, void *dest) {
+  using namespace pb_host_detail;
+  while (s.p != s.end) {
+    uint32_t tag, wire_type;
+    pb_host_stream value;
+    if (!pb_host_next(s, tag, wire_type, value)) return false;
+
+    const pb_host_field *f = find(m, tag);
+    if (!f || f->kind == PB_HOST_SKIP) continue;
+
+    if (f->which_offset != PB_HOST_NONE) {
+      at<uint16_t>(dest, f->which_offset) = tag;
+    }
+    if (f->has_offset != PB_HOST_NONE) {
+      at<bool>(dest, f->has_offset) = true;
+    }
+
+    // a length-delimited scalar field is a packed array of them
+    bool packed = wire_type == 2 && f->kind != PB_HOST_SUBMSG;
+    if (packed && value.p == value.end) continue;
+    while (true) {
+      void *elem = static_cast<uint8_t *>(dest) + f->offset;
+      if (f->count_offset != PB_HOST_NONE) {
+        uint16_t &count = at<uint16_t>(dest, f->count_offset);
+        if (count == f->max_count) return false;
+        elem = static_cast<uint8_t *>(elem) + count * f->size;
+        count++;
+      }
+      if (f->kind == PB_HOST_SUBMSG) {
+        if (!pb_host_decode(value, *f->submsg, elem)) return false;
+        break;
+      }
+      if (!read_scalar(value, *f, elem)) return false;
+      if (!packed || value.p == value.end) break;
+    }
+  }
+  return true;
+}
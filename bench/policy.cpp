@@ -0,0 +1,589 @@
+/**
+ * Equivalence test and timing of the compiled policies in src/policy.cpp,
+ * against the previous evaluator, which walked the table of pointer-to-members
+ * for every term on every tick.
+ *
+ * Random policies of each type are evaluated on random states. The outputs
+ * must match up to float rounding, which differs as the compiled quadratic
+ * adds Q_ij and Q_ji together before multiplying. Gain-scheduled, RBF and
+ * sparse policies, which the walker never supported, are compared to direct
+ * evaluations of their definitions. This also checks that a new policy only
+ * takes effect at applyPendingPolicy, that a policy selected from the bank or
+ * patched matches setting it directly, that a patch only applies to the
+ * controller it was made from, that the outputs can mix types, and
+ * projects the cost of the largest RBF policy on the PIC32.
+ */
+#include <stdio.h>
+#include <math.h>
+#include <float.h>
+#include <vector>
+
+#include <messages.pb.h>
+
+#include "policy.h"
+#include "bench.h"
+#include "flop_count.h"
+
+namespace {
+
+//! The previous implementation, from policy.cpp
+namespace walker {
+  struct field_pair {
+    float LogEntry::* state;
+    float LinearPolicy::* lin_field;
+    LinearPolicy PureQuadraticPolicy::* quad_field;
+    operator bool() const {
+      return state != nullptr || lin_field != nullptr || quad_field != nullptr;
+    }
+  };
+
+  const field_pair fields[] = {
+    {&LogEntry::droll,    &LinearPolicy::k_droll,    &PureQuadraticPolicy::k_droll},
+    {&LogEntry::dyaw,     &LinearPolicy::k_dyaw,     &PureQuadraticPolicy::k_dyaw},
+    {&LogEntry::dAngleW,  &LinearPolicy::k_dAngleW,  &PureQuadraticPolicy::k_dAngleW},
+    {&LogEntry::dpitch,   &LinearPolicy::k_dpitch,   &PureQuadraticPolicy::k_dpitch},
+    {&LogEntry::dAngleTT, &LinearPolicy::k_dAngleTT, &PureQuadraticPolicy::k_dAngleTT},
+    {&LogEntry::xOrigin,  &LinearPolicy::k_xOrigin,  &PureQuadraticPolicy::k_xOrigin},
+    {&LogEntry::yOrigin,  &LinearPolicy::k_yOrigin,  &PureQuadraticPolicy::k_yOrigin},
+    {&LogEntry::roll,     &LinearPolicy::k_roll,     &PureQuadraticPolicy::k_roll},
+    {&LogEntry::yaw,      &LinearPolicy::k_yaw,      &PureQuadraticPolicy::k_yaw},
+    {&LogEntry::pitch,    &LinearPolicy::k_pitch,    &PureQuadraticPolicy::k_pitch},
+    {nullptr, nullptr, nullptr}
+  };
+
+  float computePolicy(const LinearPolicy& policy, const LogEntry& state) {
+    float result = 0;
+    for(const field_pair* fp = fields; *fp; fp++) {
+      result += policy.*(fp->lin_field) * state.*(fp->state);
+    }
+    return result;
+  }
+  float computePolicy(const PureQuadraticPolicy& policy, const LogEntry& state) {
+    float result = 0;
+    for(const field_pair* fp = fields; *fp; fp++) {
+      result += computePolicy(policy.*(fp->quad_field), state) * state.*(fp->state);
+    }
+    return result;
+  }
+  //! The cell of a grid axis containing v, and the position within it
+  size_t cell(float v, float v_min, float step, uint32_t n, float &t) {
+    if (n == 1) { t = 0; return 0; }
+    float f = fmin(fmax((v - v_min) / step, 0), n - 1);
+    size_t i = fmin(floor(f), n - 2);
+    t = f - i;
+    return i;
+  }
+  float computePolicy(const AffinePolicy& policy, const LogEntry& state) {
+    return policy.k_bias + computePolicy(policy.k_lin, state);
+  }
+  float computePolicy(const GainScheduledPolicy& policy, const LogEntry& state) {
+    float tr, tp;
+    size_t i = cell(state.roll, policy.roll_min, policy.roll_step, policy.n_roll, tr);
+    size_t j = cell(state.pitch, policy.pitch_min, policy.pitch_step, policy.n_pitch, tp);
+    size_t i1 = policy.n_roll > 1 ? i + 1 : i, j1 = policy.n_pitch > 1 ? j + 1 : j;
+    const AffinePolicy *g = policy.gains;
+    size_t n = policy.n_pitch;
+    return (1 - tr) * (1 - tp) * computePolicy(g[i*n + j], state)
+         + (1 - tr) * tp       * computePolicy(g[i*n + j1], state)
+         + tr * (1 - tp)       * computePolicy(g[i1*n + j], state)
+         + tr * tp             * computePolicy(g[i1*n + j1], state);
+  }
+  double computePolicy(const RbfPolicy& policy, const LogEntry& state) {
+    double result = policy.k_bias;
+    for (size_t i = 0; i < policy.centers_count; i++) {
+      double dist2 = 0;
+      for (const field_pair* fp = fields; *fp; fp++) {
+        double d = (state.*(fp->state) - policy.centers[i].center.*(fp->lin_field))
+                 * policy.inv_lengthscale.*(fp->lin_field);
+        dist2 += d * d;
+      }
+      result += policy.centers[i].weight * exp(-dist2 / 2);
+    }
+    return result;
+  }
+  //! The terms of a sparse policy, with the sum of their magnitudes in mag
+  double computePolicy(const SparsePolicy& policy, const LogEntry& state, double &mag) {
+    const size_t n = sizeof(fields) / sizeof(fields[0]) - 1;
+    const float *c = policy.coeffs;
+    double result = policy.k_bias;
+    mag = fabs(result);
+    for (size_t a = 0; a < n; a++) {
+      if (!(policy.lin_mask >> a & 1)) continue;
+      double term = *c++ * state.*(fields[a].state);
+      result += term;
+      mag += fabs(term);
+    }
+    size_t bit = 0;
+    for (size_t a = 0; a < n; a++) {
+      for (size_t b = a; b < n; b++, bit++) {
+        if (!(policy.quad_mask >> bit & 1)) continue;
+        double term = *c++ * state.*(fields[a].state) * state.*(fields[b].state);
+        result += term;
+        mag += fabs(term);
+      }
+    }
+    return result;
+  }
+  float computePolicy(const Policy& policy, const LogEntry& state) {
+    switch (policy.which_msg) {
+      case Policy_lin_tag:
+        return computePolicy(policy.msg.lin, state);
+      case Policy_affine_tag:
+        return policy.msg.affine.k_bias + computePolicy(policy.msg.affine.k_lin, state);
+      case Policy_quad_tag:
+        return policy.msg.quad.k_bias
+          + computePolicy(policy.msg.quad.k_lin, state)
+          + computePolicy(policy.msg.quad.k_quad, state);
+      case Policy_scheduled_tag:
+        return computePolicy(policy.msg.scheduled, state);
+      case Policy_rbf_tag:
+        return computePolicy(policy.msg.rbf, state);
+      case Policy_sparse_tag: {
+        double mag;
+        return computePolicy(policy.msg.sparse, state, mag);
+      }
+      default:
+        return 0;
+    }
+  }
+
+  float saturate(float p) {
+    return p > 1 ? 1 : p < -1 ? -1 : p;
+  }
+
+  //! The sum of the magnitudes of the terms, which bounds the rounding error
+  double magnitude(const Policy& policy, const LogEntry& state) {
+    if (policy.which_msg == Policy_sparse_tag) {
+      double mag;
+      computePolicy(policy.msg.sparse, state, mag);
+      return mag;
+    }
+    if (policy.which_msg == Policy_scheduled_tag) {
+      // at most the largest of the interpolated outputs
+      double result = 0;
+      for (size_t k = 0; k < policy.msg.scheduled.gains_count; k++) {
+        Policy p = {};
+        p.which_msg = Policy_affine_tag;
+        p.msg.affine = policy.msg.scheduled.gains[k];
+        result = fmax(result, magnitude(p, state));
+      }
+      return result;
+    }
+    if (policy.which_msg == Policy_rbf_tag) {
+      // exp_neg and the rounding of the distances are only good to about
+      // 8e-7, rather than 4 eps, so scale the bound to match
+      double result = fabs(policy.msg.rbf.k_bias);
+      for (size_t k = 0; k < policy.msg.rbf.centers_count; k++) {
+        result += 2 * fabs(policy.msg.rbf.centers[k].weight);
+      }
+      return result;
+    }
+    const LinearPolicy *lin = nullptr;
+    const PureQuadraticPolicy *quad = nullptr;
+    double result = 0;
+    switch (policy.which_msg) {
+      case Policy_lin_tag:    lin = &policy.msg.lin; break;
+      case Policy_affine_tag: lin = &policy.msg.affine.k_lin;
+                              result = fabs(policy.msg.affine.k_bias); break;
+      case Policy_quad_tag:   lin = &policy.msg.quad.k_lin; quad = &policy.msg.quad.k_quad;
+                              result = fabs(policy.msg.quad.k_bias); break;
+    }
+    for (const field_pair* fi = fields; *fi; fi++) {
+      double xi = fabs(state.*(fi->state));
+      result += fabs(lin->*(fi->lin_field)) * xi;
+      if (!quad) continue;
+      for (const field_pair* fj = fields; *fj; fj++) {
+        result += fabs((quad->*(fi->quad_field)).*(fj->lin_field) * state.*(fj->state)) * xi;
+      }
+    }
+    return result;
+  }
+}
+
+void random_linear(LinearPolicy &p, float scale) {
+  std::normal_distribution<float> d(0, scale);
+  for (const walker::field_pair* fp = walker::fields; *fp; fp++) {
+    p.*(fp->lin_field) = d(bench::rng());
+  }
+}
+
+Policy random_policy(pb_size_t type) {
+  std::normal_distribution<float> d(0, 0.1f);
+  Policy p = {};
+  p.which_msg = type;
+  switch (type) {
+    case Policy_lin_tag:
+      random_linear(p.msg.lin, 0.1f);
+      break;
+    case Policy_affine_tag:
+      p.msg.affine.k_bias = d(bench::rng());
+      random_linear(p.msg.affine.k_lin, 0.1f);
+      break;
+    case Policy_quad_tag:
+      p.msg.quad.k_bias = d(bench::rng());
+      random_linear(p.msg.quad.k_lin, 0.1f);
+      for (const walker::field_pair* fp = walker::fields; *fp; fp++) {
+        random_linear(p.msg.quad.k_quad.*(fp->quad_field), 0.02f);
+      }
+      break;
+    case Policy_scheduled_tag: {
+      // a 5x4 grid over +/-30 degrees, so that the random states also cover
+      // the clamped region beyond it
+      GainScheduledPolicy &s = p.msg.scheduled;
+      s.n_roll = 5;  s.roll_min = -0.5f;  s.roll_step = 0.25f;
+      s.n_pitch = 4; s.pitch_min = -0.5f; s.pitch_step = 1 / 3.0f;
+      s.gains_count = s.n_roll * s.n_pitch;
+      for (size_t k = 0; k < s.gains_count; k++) {
+        s.gains[k].k_bias = d(bench::rng());
+        random_linear(s.gains[k].k_lin, 0.1f);
+      }
+      break;
+    }
+    case Policy_sparse_tag: {
+      // about a third of the terms of a quadratic policy
+      SparsePolicy &sp = p.msg.sparse;
+      std::bernoulli_distribution keep(0.3);
+      sp.k_bias = d(bench::rng());
+      size_t n_terms = sizeof(sp.coeffs) / sizeof(sp.coeffs[0]);
+      const size_t n_lin = sizeof(walker::fields) / sizeof(walker::fields[0]) - 1;
+      for (size_t t = 0; t < n_terms; t++) {
+        if (!keep(bench::rng())) continue;
+        if (t < n_lin) sp.lin_mask |= uint32_t(1) << t;
+        else           sp.quad_mask |= uint64_t(1) << (t - n_lin);
+        sp.coeffs[sp.coeffs_count++] = t < n_lin ? d(bench::rng()) : 0.2f * d(bench::rng());
+      }
+      break;
+    }
+    case Policy_rbf_tag: {
+      // as many centers as fit, ignoring yaw
+      RbfPolicy &r = p.msg.rbf;
+      std::uniform_real_distribution<float> inv_l(0.3f, 1.5f);
+      std::normal_distribution<float> center(0, 1);
+      r.k_bias = d(bench::rng());
+      r.has_inv_lengthscale = true;
+      for (const walker::field_pair* fp = walker::fields; *fp; fp++) {
+        r.inv_lengthscale.*(fp->lin_field) = inv_l(bench::rng());
+      }
+      r.inv_lengthscale.k_yaw = 0;
+      r.centers_count = sizeof(r.centers) / sizeof(r.centers[0]);
+      for (size_t k = 0; k < r.centers_count; k++) {
+        r.centers[k].has_center = true;
+        for (const walker::field_pair* fp = walker::fields; *fp; fp++) {
+          r.centers[k].center.*(fp->lin_field) = center(bench::rng());
+        }
+        r.centers[k].weight = 3 * d(bench::rng());
+      }
+      break;
+    }
+  }
+  return p;
+}
+
+/**
+ * The soft-float operations of one output of an RBF policy, as computeRbf and
+ * exp_neg do them. Float to int conversions are counted as additions.
+ */
+bench::flop_counts rbf_counts(size_t n_centers, size_t n_dims) {
+  bench::flop_counts exp_neg = {};
+  exp_neg.cmp = 1;
+  exp_neg.mul = 7;
+  exp_neg.add = 10;
+
+  bench::flop_counts c = {};
+  c.mul = n_dims + n_centers * (n_dims + 1 + exp_neg.mul);
+  c.add = 1 + n_centers * (2 * n_dims + 1 + exp_neg.add);
+  c.cmp = n_centers * exp_neg.cmp;
+  return c;
+}
+
+LogEntry random_state() {
+  std::normal_distribution<float> d(0, 1);
+  LogEntry l = {};
+  for (const walker::field_pair* fp = walker::fields; *fp; fp++) {
+    l.*(fp->state) = d(bench::rng());
+  }
+  return l;
+}
+
+struct policy_type {
+  const char *name;
+  pb_size_t tag;
+};
+
+const policy_type types[] = {
+  {"linear",    Policy_lin_tag},
+  {"affine",    Policy_affine_tag},
+  {"quadratic", Policy_quad_tag},
+  {"scheduled", Policy_scheduled_tag},
+  {"rbf",       Policy_rbf_tag},
+  {"sparse",    Policy_sparse_tag},
+};
+
+}
+
+int main() {
+  const size_t n_policies = 100, n = 1000;
+
+  std::vector<LogEntry> states(n);
+  for (LogEntry &l : states) l = random_state();
+
+  bool ok = true;
+  printf("%-10s %12s %14s %14s %9s\n", "type", "max error", "walker ns/op", "compiled ns/op", "speedup");
+  for (const policy_type &t : types) {
+    double max_ratio = 0, max_err = 0;
+    for (size_t k = 0; k < n_policies; k++) {
+      Controller c = {};
+      c.wheel = random_policy(t.tag);
+      c.turntable = random_policy(t.tag);
+      setPolicy(c);
+      applyPendingPolicy();
+      for (const LogEntry &l : states) {
+        float w_old = walker::saturate(walker::computePolicy(c.wheel, l));
+        float t_old = walker::saturate(walker::computePolicy(c.turntable, l));
+        PolicyOutputs u = computePolicies(l);
+        double err = fmax(fabs(u.wheel - w_old), fabs(u.turntable - t_old));
+        double bound = 4 * FLT_EPSILON * fmax(walker::magnitude(c.wheel, l),
+                                              walker::magnitude(c.turntable, l));
+        max_err = fmax(max_err, err);
+        max_ratio = fmax(max_ratio, err / bound);
+      }
+    }
+
+    // both outputs, as computed each tick
+    Controller c = {};
+    c.wheel = random_policy(t.tag);
+    c.turntable = random_policy(t.tag);
+    setPolicy(c);
+    applyPendingPolicy();
+    std::vector<float> out(2 * n);
+    double t_old = bench::time_ns([&]{
+      for (size_t i = 0; i < n; i++) {
+        out[2*i]     = walker::saturate(walker::computePolicy(c.wheel, states[i]));
+        out[2*i + 1] = walker::saturate(walker::computePolicy(c.turntable, states[i]));
+      }
+      bench::keep(out);
+    });
+    double t_new = bench::time_ns([&]{
+      for (size_t i = 0; i < n; i++) {
+        PolicyOutputs u = computePolicies(states[i]);
+        out[2*i]     = u.wheel;
+        out[2*i + 1] = u.turntable;
+      }
+      bench::keep(out);
+    });
+    printf("%-10s %12.2e %14.2f %14.2f %8.1fx\n", t.name, max_err, t_old / n, t_new / n, t_old / t_new);
+
+    if (max_ratio > 1) {
+      printf("FAIL: %s policies differ by more than the rounding error\n", t.name);
+      ok = false;
+    }
+  }
+
+  // each output can be of a different type
+  for (const policy_type &tw : types) {
+    for (const policy_type &tt : types) {
+      Controller c = {};
+      c.wheel = random_policy(tw.tag);
+      c.turntable = random_policy(tt.tag);
+      setPolicy(c);
+      applyPendingPolicy();
+      for (const LogEntry &l : states) {
+        PolicyOutputs u = computePolicies(l);
+        double w_err = fabs(u.wheel - walker::saturate(walker::computePolicy(c.wheel, l)));
+        double t_err = fabs(u.turntable - walker::saturate(walker::computePolicy(c.turntable, l)));
+        if (w_err > 4 * FLT_EPSILON * walker::magnitude(c.wheel, l) ||
+            t_err > 4 * FLT_EPSILON * walker::magnitude(c.turntable, l)) {
+          printf("FAIL: a %s wheel and %s turntable policy differ\n", tw.name, tt.name);
+          ok = false;
+          break;
+        }
+      }
+    }
+  }
+
+  // the largest RBF policy, for both outputs, against the 50 ms control tick
+  const size_t n_centers = sizeof(RbfPolicy::centers) / sizeof(RbfCenter);
+  const size_t n_dims = sizeof(walker::fields) / sizeof(walker::fields[0]) - 1;
+  double cycles = 2 * rbf_counts(n_centers, n_dims).pic32_cycles();
+  printf("rbf with %zu centers over %zu states, both outputs: about %.0f PIC32 cycles, "
+         "%.2f ms, %.1f%% of the 50 ms tick\n",
+         n_centers, n_dims, cycles, cycles / 80e3, 100 * cycles / (80e6 * 0.05));
+
+  // a schedule that does not match its grid is rejected
+  Controller bad = {};
+  bad.wheel = random_policy(Policy_scheduled_tag);
+  bad.wheel.msg.scheduled.n_roll = 4;
+  setPolicy(bad);
+  applyPendingPolicy();
+  if (computePolicies(states[0]).wheel != 0) {
+    printf("FAIL: a schedule with the wrong number of gains was accepted\n");
+    ok = false;
+  }
+
+  // as is a sparse policy with fewer coefficients than its masks
+  bad = {};
+  bad.wheel = random_policy(Policy_sparse_tag);
+  bad.wheel.msg.sparse.coeffs_count--;
+  setPolicy(bad);
+  applyPendingPolicy();
+  if (computePolicies(states[0]).wheel != 0) {
+    printf("FAIL: a sparse policy with the wrong number of coefficients was accepted\n");
+    ok = false;
+  }
+
+  // a new policy only takes effect at the next tick boundary
+  Controller c = {};
+  c.wheel = random_policy(Policy_quad_tag);
+  setPolicy(c);
+  uint32_t v = applyPendingPolicy();
+  float before = computePolicies(states[0]).wheel;
+  c.wheel = random_policy(Policy_quad_tag);
+  setPolicy(c);
+  bool held = computePolicies(states[0]).wheel == before && applyPendingPolicy() == v + 1 &&
+              computePolicies(states[0]).wheel != before && applyPendingPolicy() == v + 1;
+  if (!held) {
+    printf("FAIL: setPolicy took effect outside of applyPendingPolicy\n");
+    ok = false;
+  }
+
+  // a stored policy only takes effect once selected, and then as if set directly
+  StorePolicy store = {};
+  store.slot = 2;
+  store.has_controller = true;
+  store.controller.wheel = random_policy(Policy_quad_tag);
+  store.controller.turntable = random_policy(Policy_sparse_tag);
+  v = applyPendingPolicy();
+  before = computePolicies(states[0]).wheel;
+  bool banked = storePolicy(store) && applyPendingPolicy() == v &&
+                computePolicies(states[0]).wheel == before && activePolicySlot() == 0 &&
+                !selectPolicy(1) && selectPolicy(2) && activePolicySlot() == 0 &&
+                applyPendingPolicy() == v + 1 && activePolicySlot() == 2;
+  std::vector<PolicyOutputs> selected(n);
+  for (size_t i = 0; i < n; i++) selected[i] = computePolicies(states[i]);
+  setPolicy(store.controller);
+  banked = banked && applyPendingPolicy() == v + 2 && activePolicySlot() == 0;
+  for (size_t i = 0; i < n; i++) {
+    PolicyOutputs u = computePolicies(states[i]);
+    banked = banked && u.wheel == selected[i].wheel && u.turntable == selected[i].turntable;
+  }
+  store.slot = 0;
+  banked = banked && !storePolicy(store) && !selectPolicy(0);
+  store.slot = 5;
+  banked = banked && !storePolicy(store) && !selectPolicy(5);
+  if (!banked) {
+    printf("FAIL: a policy selected from the bank differs from setting it directly\n");
+    ok = false;
+  }
+
+  // a patch takes effect at the next tick boundary, as if the patched policy
+  // were set in full, and one with any id out of range changes nothing
+  c = {};
+  c.wheel = random_policy(Policy_quad_tag);
+  c.turntable = random_policy(Policy_sparse_tag);
+  setPolicy(c);
+  v = applyPendingPolicy();
+  for (size_t i = 0; i < n; i++) selected[i] = computePolicies(states[i]);
+  PatchPolicy patch = {};
+  patch.coeffs_count = 4;
+  patch.coeffs[0] = PolicyCoefficient{Controller_wheel_tag, 0, 0.5f};
+  patch.coeffs[1] = PolicyCoefficient{Controller_wheel_tag, 3, -1.5f};
+  patch.coeffs[2] = PolicyCoefficient{Controller_wheel_tag, 11 + 10*7 + 9, 2.5f};
+  patch.coeffs[3] = PolicyCoefficient{Controller_turntable_tag, 1, 0.25f};
+  PatchPolicy bad_patch = patch;
+  bad_patch.coeffs[3].id = c.turntable.msg.sparse.coeffs_count + 1;
+  bool patched = !patchPolicy(bad_patch) && applyPendingPolicy() == v;
+  for (size_t i = 0; i < n; i++) {
+    PolicyOutputs u = computePolicies(states[i]);
+    patched = patched && u.wheel == selected[i].wheel && u.turntable == selected[i].turntable;
+  }
+  patch.id = 7;
+  patch.base = 1;
+  patched = patched && !patchPolicy(patch) && applyPendingPolicy() == v;
+  patch.base = 0;
+  patched = patched && patchPolicy(patch) && computePolicies(states[0]).wheel == selected[0].wheel &&
+            applyPendingPolicy() == v + 1;
+  for (size_t i = 0; i < n; i++) selected[i] = computePolicies(states[i]);
+  c.wheel.msg.quad.k_bias = 0.5f;
+  c.wheel.msg.quad.k_lin.k_dAngleW = -1.5f;
+  c.wheel.msg.quad.k_quad.k_roll.k_pitch = 2.5f;
+  c.turntable.msg.sparse.coeffs[0] = 0.25f;
+  setPolicy(c);
+  applyPendingPolicy();
+  for (size_t i = 0; i < n; i++) {
+    PolicyOutputs u = computePolicies(states[i]);
+    patched = patched && u.wheel == selected[i].wheel && u.turntable == selected[i].turntable;
+  }
+  if (!patched) {
+    printf("FAIL: a patched policy differs from setting it in full\n");
+    ok = false;
+  }
+
+  // a patch follows only the one before it, and never replaces a policy
+  // selected from the bank
+  PatchPolicy next = {};
+  next.coeffs_count = 1;
+  next.coeffs[0] = PolicyCoefficient{Controller_wheel_tag, 0, 1.0f};
+  next.id = 8;
+  v = applyPendingPolicy();
+  patch.base = 0;
+  patch.id = 7;
+  bool followed = patchPolicy(patch) && applyPendingPolicy() == v + 1 &&
+                  !patchPolicy(next) && applyPendingPolicy() == v + 1;
+  patch.base = 7;
+  patch.id = 9;
+  followed = followed && patchPolicy(patch) && applyPendingPolicy() == v + 2;
+  next.base = 9;
+  followed = followed && selectPolicy(2) && !patchPolicy(next) &&
+             applyPendingPolicy() == v + 3 && activePolicySlot() == 2;
+  setPolicy(c);
+  next.base = 0;
+  followed = followed && patchPolicy(next) && applyPendingPolicy() == v + 4 &&
+             activePolicySlot() == 0;
+  if (!followed) {
+    printf("FAIL: a patch applied to a policy other than the one it was made from\n");
+    ok = false;
+  }
+
+  // only the patchable types of policy are kept for patching, so a patch to
+  // a controller with any other output is refused
+  c.wheel = random_policy(Policy_rbf_tag);
+  setPolicy(c);
+  v = applyPendingPolicy();
+  next.coeffs[0] = PolicyCoefficient{Controller_turntable_tag, 1, 1.0f};
+  if (patchPolicy(next) || applyPendingPolicy() != v) {
+    printf("FAIL: a patch to a controller with an RBF policy was accepted\n");
+    ok = false;
+  }
+
+  // the bank stores each policy in only the bytes it needs, so refuses one
+  // that does not fit beside the others, leaving them as they were, and
+  // moves them when a slot changes size
+  auto selects = [&](uint32_t slot, const Controller& expected) {
+    setPolicy(expected);
+    applyPendingPolicy();
+    for (size_t i = 0; i < n; i++) selected[i] = computePolicies(states[i]);
+    if (!selectPolicy(slot)) return false;
+    applyPendingPolicy();
+    bool same = activePolicySlot() == slot;
+    for (size_t i = 0; i < n; i++) {
+      PolicyOutputs u = computePolicies(states[i]);
+      same = same && u.wheel == selected[i].wheel && u.turntable == selected[i].turntable;
+    }
+    return same;
+  };
+  StorePolicy large = {};
+  large.slot = 1;
+  large.has_controller = true;
+  large.controller.wheel = random_policy(Policy_rbf_tag);
+  large.controller.turntable = random_policy(Policy_rbf_tag);
+  bool packed = !storePolicy(large) && !selectPolicy(1) && selects(2, store.controller);
+  large.controller.turntable = random_policy(Policy_quad_tag);
+  packed = packed && storePolicy(large) && selects(1, large.controller) && selects(2, store.controller);
+  large.controller.wheel = random_policy(Policy_lin_tag);
+  packed = packed && storePolicy(large) && selects(1, large.controller) && selects(2, store.controller);
+  if (!packed) {
+    printf("FAIL: the bank lost a policy when another did not fit, or changed size\n");
+    ok = false;
+  }
+  return ok ? 0 : 1;
+}
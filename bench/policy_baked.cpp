@@ -0,0 +1,175 @@
+/**
+ * Equivalence test and timing of a controller baked in at build time
+ * (BAKED_POLICY), against the same controller set at runtime through
+ * src/policy.cpp.
+ *
+ * The Makefile bakes $(BAKED_CONTROLLER) into build/baked_policy.h, which is
+ * a random pruned controller unless given on the make command line. This
+ * reads the same file as a serialized Controller for the runtime path.
+ */
+#include <stdio.h>
+#include <math.h>
+#include <vector>
+
+#include <messages.pb.h>
+#include <messages.fields.h>
+#include <baked_policy.h>
+
+#include "policy.h"
+#include "bench.h"
+#include "flop_count.h"
+
+// the headers that bakedPolicy.cpp includes are already included above, so
+// only its own definitions end up in this namespace
+#define BAKED_POLICY
+namespace baked {
+#include "../src/bakedPolicy.cpp"
+}
+
+namespace {
+
+bool read_controller(const char *path, Controller &c) {
+  FILE *f = fopen(path, "rb");
+  if (!f) return false;
+  std::vector<uint8_t> data;
+  uint8_t buf[4096];
+  size_t n;
+  while ((n = fread(buf, 1, sizeof(buf), f)) > 0) data.insert(data.end(), buf, buf + n);
+  fclose(f);
+  c = Controller();
+  return pb_host_decode(pb_host_stream{data.data(), data.data() + data.size()},
+                        Controller_host_msg, &c);
+}
+
+//! The LinearPolicy coefficients, in the order of the SparsePolicy mask bits
+float LinearPolicy::* const lin_fields[] = {
+  &LinearPolicy::k_droll, &LinearPolicy::k_dyaw, &LinearPolicy::k_dAngleW,
+  &LinearPolicy::k_dpitch, &LinearPolicy::k_dAngleTT, &LinearPolicy::k_xOrigin,
+  &LinearPolicy::k_yOrigin, &LinearPolicy::k_roll, &LinearPolicy::k_yaw,
+  &LinearPolicy::k_pitch,
+};
+LinearPolicy PureQuadraticPolicy::* const quad_fields[] = {
+  &PureQuadraticPolicy::k_droll, &PureQuadraticPolicy::k_dyaw, &PureQuadraticPolicy::k_dAngleW,
+  &PureQuadraticPolicy::k_dpitch, &PureQuadraticPolicy::k_dAngleTT, &PureQuadraticPolicy::k_xOrigin,
+  &PureQuadraticPolicy::k_yOrigin, &PureQuadraticPolicy::k_roll, &PureQuadraticPolicy::k_yaw,
+  &PureQuadraticPolicy::k_pitch,
+};
+const size_t n_states = sizeof(lin_fields) / sizeof(lin_fields[0]);
+float LogEntry::* const states[] = {
+  &LogEntry::droll, &LogEntry::dyaw, &LogEntry::dAngleW, &LogEntry::dpitch,
+  &LogEntry::dAngleTT, &LogEntry::xOrigin, &LogEntry::yOrigin, &LogEntry::roll,
+  &LogEntry::yaw, &LogEntry::pitch,
+};
+
+/**
+ * The soft-float operations of one output of a policy, in the row form of
+ * both paths. The runtime path does every term of a dense policy, while the
+ * baked one only does those that are nonzero.
+ */
+bench::flop_counts policy_counts(const Policy &p, bool skip_zeros) {
+  bool lin[n_states] = {};
+  size_t row_terms[n_states] = {};
+  switch (p.which_msg) {
+    case Policy_lin_tag:
+    case Policy_affine_tag: {
+      const LinearPolicy &k = p.which_msg == Policy_lin_tag ? p.msg.lin : p.msg.affine.k_lin;
+      for (size_t i = 0; i < n_states; i++) lin[i] = !skip_zeros || k.*lin_fields[i] != 0;
+      break;
+    }
+    case Policy_quad_tag:
+      for (size_t i = 0; i < n_states; i++) {
+        lin[i] = !skip_zeros || p.msg.quad.k_lin.*lin_fields[i] != 0;
+        for (size_t j = i; j < n_states; j++) {
+          float q = (p.msg.quad.k_quad.*quad_fields[i]).*lin_fields[j];
+          if (j > i) q += (p.msg.quad.k_quad.*quad_fields[j]).*lin_fields[i];
+          row_terms[i] += !skip_zeros || q != 0;
+        }
+      }
+      break;
+    case Policy_sparse_tag: {
+      const SparsePolicy &s = p.msg.sparse;
+      const float *c = s.coeffs;
+      for (size_t i = 0; i < n_states; i++) {
+        if (!(s.lin_mask >> i & 1)) continue;
+        lin[i] = !skip_zeros || *c != 0;
+        c++;
+      }
+      size_t bit = 0;
+      for (size_t i = 0; i < n_states; i++) {
+        for (size_t j = i; j < n_states; j++, bit++) {
+          if (!(s.quad_mask >> bit & 1)) continue;
+          row_terms[i] += !skip_zeros || *c != 0;
+          c++;
+        }
+      }
+      break;
+    }
+  }
+
+  bench::flop_counts counts = {};
+  for (size_t i = 0; i < n_states; i++) {
+    if (!lin[i] && !row_terms[i]) continue;
+    // the terms of the row, then the row times its state
+    counts.mul += row_terms[i] + 1;
+    counts.add += row_terms[i] + (lin[i] && row_terms[i]) + 1;
+  }
+  return counts;
+}
+
+LogEntry random_state() {
+  std::normal_distribution<float> d(0, 1);
+  LogEntry l = {};
+  for (float LogEntry::* s : states) l.*s = d(bench::rng());
+  return l;
+}
+
+}
+
+int main() {
+  Controller c;
+  if (!read_controller(BAKED_CONTROLLER, c)) {
+    printf("FAIL: could not read a Controller from %s\n", BAKED_CONTROLLER);
+    return 1;
+  }
+  setPolicy(c);
+  applyPendingPolicy();
+
+  const size_t n = 10000;
+  std::vector<LogEntry> entries(n);
+  for (LogEntry &l : entries) l = random_state();
+
+  double max_err = 0;
+  for (const LogEntry &l : entries) {
+    PolicyOutputs u = computePolicies(l);
+    PolicyOutputs b = baked::computePolicies(l);
+    max_err = fmax(max_err, fmax(fabs(u.wheel - b.wheel), fabs(u.turntable - b.turntable)));
+  }
+
+  std::vector<PolicyOutputs> out(n);
+  double t_runtime = bench::time_ns([&]{
+    for (size_t i = 0; i < n; i++) out[i] = computePolicies(entries[i]);
+    bench::keep(out);
+  });
+  double t_baked = bench::time_ns([&]{
+    for (size_t i = 0; i < n; i++) out[i] = baked::computePolicies(entries[i]);
+    bench::keep(out);
+  });
+
+  double cyc_runtime = 0, cyc_baked = 0;
+  for (const Policy *p : {&c.wheel, &c.turntable}) {
+    cyc_runtime += policy_counts(*p, false).pic32_cycles();
+    cyc_baked += policy_counts(*p, true).pic32_cycles();
+  }
+
+  printf("%s: max deviation %.2e\n", BAKED_CONTROLLER, max_err);
+  printf("runtime %.2f ns/op, baked %.2f ns/op, speedup %.1fx\n",
+         t_runtime / n, t_baked / n, t_runtime / t_baked);
+  printf("projected on the PIC32: runtime %.0f cycles, baked %.0f cycles, of soft-float\n",
+         cyc_runtime, cyc_baked);
+
+  // only rounding differs, from the order of the terms and FMA contraction
+  if (max_err > 1e-6) {
+    printf("FAIL: the baked controller differs from the runtime one\n");
+    return 1;
+  }
+}
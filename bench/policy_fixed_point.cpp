@@ -0,0 +1,308 @@
+/**
+ * Accuracy and cost of the fixed-point policies (POLICY_FIXED_POINT) compared
+ * with the float ones.
+ *
+ * src/policy.cpp is compiled twice into this file, once into each of the
+ * namespaces float_path and fixed_path, so that both can be evaluated side by
+ * side on the same random policies and states. The states are drawn across
+ * the whole of their declared ranges, and some beyond, where they are clamped.
+ *
+ * The host has an FPU, so the soft-float cost of each path on the PIC32 is
+ * also projected from the operations it does. A build with -DPROFILE_UPDATE
+ * measures the real tick time on the robot.
+ */
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+#include <vector>
+
+#include <messages.pb.h>
+#include <fixed.h>
+
+#include "policy.h"
+#include "bench.h"
+#include "flop_count.h"
+
+// the headers that policy.cpp includes are already included above, so only
+// its own definitions end up in these namespaces
+namespace float_path {
+#include "../src/policy.cpp"
+}
+#define POLICY_FIXED_POINT
+namespace fixed_path {
+#include "../src/policy.cpp"
+}
+
+namespace {
+
+//! The state fields, and the ranges declared for them in policy.cpp
+struct state_field {
+  float LogEntry::* state;
+  float LinearPolicy::* lin_field;
+  LinearPolicy PureQuadraticPolicy::* quad_field;
+  float range;
+};
+
+const state_field fields[] = {
+  {&LogEntry::droll,    &LinearPolicy::k_droll,    &PureQuadraticPolicy::k_droll,    35},
+  {&LogEntry::dyaw,     &LinearPolicy::k_dyaw,     &PureQuadraticPolicy::k_dyaw,     35},
+  {&LogEntry::dAngleW,  &LinearPolicy::k_dAngleW,  &PureQuadraticPolicy::k_dAngleW,  100},
+  {&LogEntry::dpitch,   &LinearPolicy::k_dpitch,   &PureQuadraticPolicy::k_dpitch,   35},
+  {&LogEntry::dAngleTT, &LinearPolicy::k_dAngleTT, &PureQuadraticPolicy::k_dAngleTT, 100},
+  {&LogEntry::xOrigin,  &LinearPolicy::k_xOrigin,  &PureQuadraticPolicy::k_xOrigin,  10},
+  {&LogEntry::yOrigin,  &LinearPolicy::k_yOrigin,  &PureQuadraticPolicy::k_yOrigin,  10},
+  {&LogEntry::roll,     &LinearPolicy::k_roll,     &PureQuadraticPolicy::k_roll,     M_PI},
+  {&LogEntry::yaw,      &LinearPolicy::k_yaw,      &PureQuadraticPolicy::k_yaw,      M_PI},
+  {&LogEntry::pitch,    &LinearPolicy::k_pitch,    &PureQuadraticPolicy::k_pitch,    M_PI},
+};
+const size_t n_states = sizeof(fields) / sizeof(fields[0]);
+
+/**
+ * A state with each field uniform over `spread` times its range, which is
+ * the same mix of magnitudes as on the robot for spread = 1.
+ */
+LogEntry random_state(float spread) {
+  std::uniform_real_distribution<float> d(-spread, spread);
+  LogEntry l = {};
+  for (const state_field &f : fields) l.*(f.state) = f.range * d(bench::rng());
+  return l;
+}
+
+/**
+ * A linear policy whose terms each contribute up to about `scale` to the
+ * output over the range of their state, as a tuned controller's would.
+ */
+void random_linear(LinearPolicy &p, float scale) {
+  std::normal_distribution<float> d(0, scale);
+  for (const state_field &f : fields) p.*(f.lin_field) = d(bench::rng()) / f.range;
+}
+
+Policy random_policy(pb_size_t type) {
+  std::normal_distribution<float> d(0, 0.1f);
+  Policy p = {};
+  p.which_msg = type;
+  switch (type) {
+    case Policy_affine_tag:
+      p.msg.affine.k_bias = d(bench::rng());
+      random_linear(p.msg.affine.k_lin, 0.1f);
+      break;
+    case Policy_quad_tag:
+      p.msg.quad.k_bias = d(bench::rng());
+      random_linear(p.msg.quad.k_lin, 0.1f);
+      for (const state_field &f : fields) {
+        LinearPolicy &row = p.msg.quad.k_quad.*(f.quad_field);
+        random_linear(row, 0.02f);
+        for (const state_field &g : fields) row.*(g.lin_field) /= f.range;
+      }
+      break;
+    case Policy_sparse_tag: {
+      // about a third of the terms of a quadratic policy
+      SparsePolicy &sp = p.msg.sparse;
+      std::bernoulli_distribution keep(0.3);
+      sp.k_bias = d(bench::rng());
+      size_t bit = 0;
+      for (size_t a = 0; a < n_states; a++) {
+        if (!keep(bench::rng())) continue;
+        sp.lin_mask |= uint32_t(1) << a;
+        sp.coeffs[sp.coeffs_count++] = d(bench::rng()) / fields[a].range;
+      }
+      for (size_t a = 0; a < n_states; a++) {
+        for (size_t b = a; b < n_states; b++, bit++) {
+          if (!keep(bench::rng())) continue;
+          sp.quad_mask |= uint64_t(1) << bit;
+          sp.coeffs[sp.coeffs_count++] = 0.2f * d(bench::rng()) / (fields[a].range * fields[b].range);
+        }
+      }
+      break;
+    }
+  }
+  return p;
+}
+
+//! The number of terms of a policy, for projecting its cost
+void count_terms(const Policy &p, size_t &n_rows, size_t &n_terms) {
+  n_rows = n_terms = 0;
+  switch (p.which_msg) {
+    case Policy_affine_tag:
+      n_rows = n_states;
+      n_terms = 0;
+      break;
+    case Policy_quad_tag:
+      n_rows = n_states;
+      n_terms = n_states * (n_states + 1) / 2;
+      break;
+    case Policy_sparse_tag: {
+      for (uint64_t m = p.msg.sparse.quad_mask; m; m &= m - 1) n_terms++;
+      // a row for each state with a linear or quadratic term
+      size_t bit = 0;
+      for (size_t a = 0; a < n_states; a++) {
+        bool has = p.msg.sparse.lin_mask >> a & 1;
+        for (size_t b = a; b < n_states; b++, bit++) has |= p.msg.sparse.quad_mask >> bit & 1;
+        n_rows += has;
+      }
+      break;
+    }
+  }
+}
+
+/**
+ * The projected PIC32 cycles of one output of each path. The float path is a
+ * soft-float multiply and add per row and per term. The fixed path is a few
+ * loads and a MADD per term, and a rounding shift and saturation per row,
+ * plus the conversion of the output, all in single-cycle instructions.
+ */
+double float_cycles(size_t n_rows, size_t n_terms) {
+  bench::flop_counts c = {};
+  c.mul = n_rows + n_terms;
+  c.add = n_rows + n_terms;
+  return c.pic32_cycles();
+}
+double fixed_cycles(size_t n_rows, size_t n_terms) {
+  return 40 + 12 * n_rows + 5 * n_terms;
+}
+
+//! the cost of converting the state to fixed point, shared by both outputs
+const double gather_cycles = 25 * n_states;
+
+struct policy_type {
+  const char *name;
+  pb_size_t tag;
+};
+
+const policy_type types[] = {
+  {"affine",    Policy_affine_tag},
+  {"quadratic", Policy_quad_tag},
+  {"sparse",    Policy_sparse_tag},
+};
+
+//! The largest acceptable difference from the float path
+const double tolerance = 1e-6;
+
+}
+
+int main() {
+  bool ok = true;
+
+  // the bit-level conversions must match the soft-float ones exactly
+  {
+    std::uniform_real_distribution<float> mant(-2, 2);
+    std::uniform_int_distribution<int> exp2(-40, 40), shift(-10, 60);
+    size_t bad_round = 0, bad_float = 0;
+    for (size_t i = 0; i < 1000000; i++) {
+      float v = ldexpf(mant(bench::rng()), exp2(bench::rng()));
+      int s = shift(bench::rng());
+      if (geometry::detail::ldexp_round(v, s) != geometry::detail::round_saturate(ldexp(double(v), s))) {
+        bad_round++;
+      }
+      int32_t r = int32_t(bench::rng()()) >> (i % 31);
+      double exact = ldexp(double(r), -s);
+      if (fabs(geometry::detail::ldexp_float(r, s) - exact) > fabs(exact) * FLT_EPSILON / 2) {
+        bad_float++;
+      }
+    }
+    if (geometry::detail::ldexp_round(NAN, 10) != 0 ||
+        geometry::detail::ldexp_round(INFINITY, 0) != geometry::detail::fixed_max ||
+        geometry::detail::ldexp_round(-INFINITY, 0) != geometry::detail::fixed_min) {
+      bad_round++;
+    }
+    if (bad_round || bad_float) {
+      printf("FAIL: %zu ldexp_round and %zu ldexp_float results differ from soft-float\n",
+             bad_round, bad_float);
+      ok = false;
+    }
+  }
+
+  const size_t n_policies = 100, n = 1000;
+  std::vector<LogEntry> states(n), wide(n);
+  for (LogEntry &l : states) l = random_state(1);
+  for (LogEntry &l : wide) l = random_state(40);
+
+  printf("deviation of fixed-point from float, over the declared state ranges\n");
+  printf("%-10s %10s %10s   %11s %11s   %13s %13s\n", "type", "max", "rms",
+         "float ns/op", "fixed ns/op", "float cycles", "fixed cycles");
+  for (const policy_type &t : types) {
+    double max_err = 0, sum_sq = 0;
+    size_t n_err = 0;
+    double cyc_float = 0, cyc_fixed = 0;
+    for (size_t k = 0; k < n_policies; k++) {
+      Controller c = {};
+      c.wheel = random_policy(t.tag);
+      c.turntable = random_policy(t.tag);
+      float_path::setPolicy(c);
+      float_path::applyPendingPolicy();
+      fixed_path::setPolicy(c);
+      fixed_path::applyPendingPolicy();
+      for (const LogEntry &l : states) {
+        PolicyOutputs uf = float_path::computePolicies(l);
+        PolicyOutputs ux = fixed_path::computePolicies(l);
+        for (double err : {fabs(ux.wheel - uf.wheel), fabs(ux.turntable - uf.turntable)}) {
+          max_err = fmax(max_err, err);
+          sum_sq += err * err;
+          n_err++;
+        }
+      }
+
+      // far outside the ranges, the clamped states must still saturate sanely
+      for (const LogEntry &l : wide) {
+        PolicyOutputs ux = fixed_path::computePolicies(l);
+        if (!(fabs(ux.wheel) <= 1 && fabs(ux.turntable) <= 1)) {
+          printf("FAIL: a %s policy gave %g, %g on a state beyond its range\n",
+                 t.name, ux.wheel, ux.turntable);
+          ok = false;
+          break;
+        }
+      }
+
+      for (const Policy *p : {&c.wheel, &c.turntable}) {
+        size_t n_rows, n_terms;
+        count_terms(*p, n_rows, n_terms);
+        cyc_float += float_cycles(n_rows, n_terms);
+        cyc_fixed += fixed_cycles(n_rows, n_terms);
+      }
+    }
+    cyc_float /= n_policies;
+    cyc_fixed = cyc_fixed / n_policies + gather_cycles;
+
+    std::vector<PolicyOutputs> out(n);
+    double t_float = bench::time_ns([&]{
+      for (size_t i = 0; i < n; i++) out[i] = float_path::computePolicies(states[i]);
+      bench::keep(out);
+    });
+    double t_fixed = bench::time_ns([&]{
+      for (size_t i = 0; i < n; i++) out[i] = fixed_path::computePolicies(states[i]);
+      bench::keep(out);
+    });
+    printf("%-10s %10.2e %10.2e   %11.2f %11.2f   %13.0f %13.0f  (%.1fx)\n", t.name,
+           max_err, sqrt(sum_sq / n_err), t_float / n, t_fixed / n,
+           cyc_float, cyc_fixed, cyc_float / cyc_fixed);
+
+    if (max_err > tolerance) {
+      printf("FAIL: fixed-point %s policies differ from float by more than %g\n", t.name, tolerance);
+      ok = false;
+    }
+  }
+  printf("cycles are both outputs projected for the PIC32, of the 4M in a tick; "
+         "ns/op is on the host FPU, which is not indicative of the MCU\n");
+
+  // saturation matches saturate(), including far beyond +/-1
+  {
+    Controller c = {};
+    c.wheel.which_msg = Policy_affine_tag;
+    c.wheel.msg.affine.k_bias = 1e6f;
+    c.turntable.which_msg = Policy_affine_tag;
+    c.turntable.msg.affine.k_bias = -3;
+    c.turntable.msg.affine.k_lin.k_roll = 1;
+    fixed_path::setPolicy(c);
+    fixed_path::applyPendingPolicy();
+    LogEntry l = {};
+    l.roll = 2.5f;
+    PolicyOutputs u = fixed_path::computePolicies(l);
+    if (u.wheel != 1 || fabs(u.turntable + 0.5f) > 1e-6f) {
+      printf("FAIL: saturation gives %g and %g, rather than 1 and -0.5\n", u.wheel, u.turntable);
+      ok = false;
+    }
+  }
+
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,90 @@
+/**
+ * Accuracy of the latency compensation in prediction.h.
+ *
+ * The robot is moved along the exact arc given by a constant yaw rate and
+ * ground speed, and the position and self-centered origin at the end compared
+ * to those predicted from the start. This exits with an error unless the
+ * prediction is within its second order bound, and much closer than the
+ * unpredicted state, and unless the angles are advanced by their rates.
+ */
+#include <stdio.h>
+#include <math.h>
+
+#include "prediction.h"
+#include "bench.h"
+
+namespace {
+
+//! The origin in the self-centered frame, of a robot at (x, y) facing psi
+void origin(double x, double y, double psi, double &xOrigin, double &yOrigin) {
+  xOrigin =  cos(psi)*-x + sin(psi)*-y;
+  yOrigin = -sin(psi)*-x + cos(psi)*-y;
+}
+
+}
+
+int main() {
+  const size_t n = 10000;
+  const float max_lead = 5e-3;
+  std::uniform_real_distribution<float> pos(-2, 2), angle(-M_PI, M_PI), rate(-5, 5),
+                                        wheel_rate(-20, 20), lead(0, max_lead);
+
+  double max_err = 0, max_held = 0, max_excess = 0;
+  double max_pos_err = 0, max_pos_held = 0, max_angle_err = 0;
+  for (size_t i = 0; i < n; i++) {
+    double x = pos(bench::rng()), y = pos(bench::rng()), psi = angle(bench::rng());
+    LogEntry l = {};
+    l.dyaw = rate(bench::rng());
+    l.dAngleW = wheel_rate(bench::rng());
+    l.yaw = psi;
+    l.x = x;
+    l.y = y;
+    l.dAngleTT = rate(bench::rng());
+    l.AngleW = angle(bench::rng());
+    l.AngleTT = angle(bench::rng());
+    double xo, yo;
+    origin(x, y, psi, xo, yo);
+    l.xOrigin = xo;
+    l.yOrigin = yo;
+    float t = lead(bench::rng());
+
+    // the arc driven over the lead
+    double w = l.dyaw, v = W_RADIUS * l.dAngleW, psi_t = psi + w*t;
+    double x_t = x + v/w * (sin(psi_t) - sin(psi));
+    double y_t = y - v/w * (cos(psi_t) - cos(psi));
+    double xo_t, yo_t;
+    origin(x_t, y_t, psi_t, xo_t, yo_t);
+
+    LogEntry p = l;
+    predictState(p, t);
+    double err = hypot(p.xOrigin - xo_t, p.yOrigin - yo_t);
+    // the second derivative of the origin is bounded by this
+    double bound = 0.5 * (2*fabs(w*v) + w*w*hypot(xo, yo)) * t*t;
+    max_err = fmax(max_err, err);
+    max_held = fmax(max_held, hypot(l.xOrigin - xo_t, l.yOrigin - yo_t));
+    max_excess = fmax(max_excess, err - bound);
+
+    // the position has a second derivative of |w v|
+    double pos_err = hypot(p.x - x_t, p.y - y_t);
+    max_pos_err = fmax(max_pos_err, pos_err);
+    max_pos_held = fmax(max_pos_held, hypot(l.x - x_t, l.y - y_t));
+    max_excess = fmax(max_excess, pos_err - 0.5 * fabs(w*v) * t*t);
+
+    // the wheel and turntable angles are linear in time
+    max_angle_err = fmax(max_angle_err, fabs(p.AngleW - (l.AngleW + l.dAngleW*t)));
+    max_angle_err = fmax(max_angle_err, fabs(p.AngleTT - (l.AngleTT + l.dAngleTT*t)));
+  }
+
+  printf("origin over a lead of up to %.0f ms: max error %.2e m predicted, %.2e m held\n",
+         max_lead * 1e3, max_err, max_held);
+  printf("position: max error %.2e m predicted, %.2e m held\n", max_pos_err, max_pos_held);
+  printf("wheel and turntable angles: max error %.2e rad\n", max_angle_err);
+
+  // allowing for float rounding of positions of a few meters, and of angles
+  // of up to pi
+  if (max_excess > 1e-6 || max_err * 10 > max_held || max_pos_err * 10 > max_pos_held ||
+      max_angle_err > 1e-6) {
+    printf("FAIL: the prediction is not second order accurate\n");
+    return 1;
+  }
+}
@@ -0,0 +1,144 @@
+/**
+ * Compare the batched quaternion kernels in quat_batch.h against the scalar
+ * ones they replace, for both speed and agreement.
+ *
+ * This runs at two sizes: a batch whose arrays all fit in L1, where the
+ * kernels are limited by arithmetic, and one that only fits in L2, where
+ * multiply reads and writes as many bytes as the scalar loop and is limited by
+ * the bandwidth of L2 instead.
+ */
+#include <stdio.h>
+
+#include <quat.h>
+#include <euler.h>
+#include <quat_batch.h>
+
+#include "bench.h"
+
+using namespace geometry;
+
+namespace {
+
+struct result {
+  long max_ulp = 0;
+  void update(float a, float b) {
+    long d = bench::ulp_diff(a, b);
+    if (d > max_ulp) max_ulp = d;
+  }
+  void update(const quat &a, const quat &b) {
+    update(a.x, b.x); update(a.y, b.y); update(a.z, b.z); update(a.w, b.w);
+  }
+};
+
+void report(const char *name, size_t N, double scalar_ns, double batch_ns, result r) {
+  printf("%-12s scalar %7.2f ns/op   batch %7.2f ns/op   speedup %5.2fx   max error %ld ULP\n",
+         name, scalar_ns / N, batch_ns / N, scalar_ns / batch_ns, r.max_ulp);
+}
+
+void run(size_t N) {
+  bench::quat_storage sa(N), sb(N), sout(N);
+  batch::quat_array a = {sa.x.data(), sa.y.data(), sa.z.data(), sa.w.data()};
+  batch::quat_array b = {sb.x.data(), sb.y.data(), sb.z.data(), sb.w.data()};
+  batch::quat_array out = {sout.x.data(), sout.y.data(), sout.z.data(), sout.w.data()};
+
+  std::vector<quat> qa(N), qb(N), qout(N);
+  for (size_t i = 0; i < N; i++) {
+    qa[i] = bench::random_unit_quat();
+    qb[i] = bench::random_unit_quat();
+    a.set(i, qa[i]);
+    b.set(i, qb[i]);
+  }
+
+  // multiply
+  {
+    double ts = bench::time_ns([&]{
+      for (size_t i = 0; i < N; i++) qout[i] = qa[i] * qb[i];
+      bench::keep(qout);
+    });
+    double tb = bench::time_ns([&]{
+      batch::multiply(a, b, out, N);
+      bench::keep(sout);
+    });
+    result r;
+    for (size_t i = 0; i < N; i++) r.update(qout[i], out.get(i));
+    report("multiply", N, ts, tb, r);
+  }
+
+  // normalize, starting from the non-unit results of a sum
+  {
+    std::vector<quat> qsum(N);
+    bench::quat_storage ssum(N);
+    batch::quat_array sum = {ssum.x.data(), ssum.y.data(), ssum.z.data(), ssum.w.data()};
+    for (size_t i = 0; i < N; i++) {
+      qsum[i] = qa[i] + qb[i];
+      sum.set(i, qsum[i]);
+    }
+    double ts = bench::time_ns([&]{
+      for (size_t i = 0; i < N; i++) { qout[i] = qsum[i]; qout[i].normalize(); }
+      bench::keep(qout);
+    });
+    double tb = bench::time_ns([&]{
+      sout = ssum;
+      batch::normalize(out, N);
+      bench::keep(sout);
+    });
+    result r;
+    for (size_t i = 0; i < N; i++) r.update(qout[i], out.get(i));
+    report("normalize", N, ts, tb, r);
+  }
+
+  // exp, of the small pure quaternions seen when integrating
+  {
+    for (size_t i = 0; i < N; i++) {
+      qa[i] = bench::random_pure_quat(0.1);
+      a.set(i, qa[i]);
+    }
+    double ts = bench::time_ns([&]{
+      for (size_t i = 0; i < N; i++) qout[i] = geometry::exp(qa[i]);
+      bench::keep(qout);
+    });
+    double tb = bench::time_ns([&]{
+      batch::exp(a, out, N);
+      bench::keep(sout);
+    });
+    result r;
+    for (size_t i = 0; i < N; i++) r.update(qout[i], out.get(i));
+    report("exp", N, ts, tb, r);
+  }
+
+  // conversion to euler angles
+  {
+    for (size_t i = 0; i < N; i++) {
+      qa[i] = bench::random_unit_quat();
+      a.set(i, qa[i]);
+    }
+    std::vector<euler_angles<213>> eout(N);
+    std::vector<float> phi(N), theta(N), psi(N);
+    batch::euler_array e = {phi.data(), theta.data(), psi.data()};
+
+    double ts = bench::time_ns([&]{
+      for (size_t i = 0; i < N; i++) eout[i] = qa[i];
+      bench::keep(eout);
+    });
+    double tb = bench::time_ns([&]{
+      batch::to_euler<213>(a, e, N);
+      bench::keep(phi);
+    });
+    result r;
+    for (size_t i = 0; i < N; i++) {
+      r.update(eout[i].phi, phi[i]);
+      r.update(eout[i].theta, theta[i]);
+      r.update(eout[i].psi, psi[i]);
+    }
+    report("euler<213>", N, ts, tb, r);
+  }
+}
+
+}
+
+int main() {
+  printf("256 quaternions, in L1:\n");
+  run(256);
+  printf("4096 quaternions, in L2:\n");
+  run(4096);
+}
@@ -0,0 +1,42 @@
+#! python3
+"""
+Write a serialized Controller with random coefficients, for the benchmarks
+that need one at build time.
+
+usage: random_controller.py out.pb
+
+The wheel policy is quadratic, and the turntable one sparse, each with about
+half of their terms zero, as a pruned controller would have.
+"""
+import random
+import sys
+from pathlib import Path
+
+sys.path.insert(0, str(Path(__file__).resolve().parent.parent / 'tools'))
+
+import messages_pb2
+import policies_pb2
+import sparsify
+
+_state_fields = sorted(policies_pb2.LinearPolicy.DESCRIPTOR.fields, key=lambda f: f.number)
+
+
+def random_linear(msg, scale, rng):
+    for f in _state_fields:
+        setattr(msg, f.name, rng.gauss(0, scale) if rng.random() < 0.5 else 0.0)
+
+
+def main(out):
+    rng = random.Random(12345)
+    c = messages_pb2.Controller()
+    for policy in (c.wheel, c.turntable):
+        policy.quad.k_bias = rng.gauss(0, 0.1)
+        random_linear(policy.quad.k_lin, 0.1, rng)
+        for f in _state_fields:
+            random_linear(getattr(policy.quad.k_quad, f.name), 0.02, rng)
+    c.turntable.CopyFrom(sparsify.sparsify(c.turntable))
+    Path(out).write_bytes(c.SerializeToString())
+
+
+if __name__ == '__main__':
+    main(*sys.argv[1:])
@@ -0,0 +1,141 @@
+/**
+ * Replay recorded logs through src/policy.cpp, to check that the firmware
+ * evaluates a controller the same way as it was designed.
+ *
+ * usage: replay [--tol <x>] controller.pb log.pb...
+ *
+ * controller.pb is a serialized Controller message, and each log.pb a
+ * serialized LogBundle, as saved by the terminal alongside each .mat log.
+ * replay.py converts .mat files to these.
+ *
+ * The controller is evaluated on the state in every LogEntry, predicted forward
+ * by its lead as the firmware does, and compared to the TurntableInput and
+ * WheelInput recorded in it. With --tol, this exits
+ * with an error if any output differs by more than x.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <vector>
+
+#include <messages.pb.h>
+#include <messages.fields.h>
+
+#include "policy.h"
+#include "prediction.h"
+#include "bench.h"
+
+namespace {
+
+bool read_file(const char *path, std::vector<uint8_t> &data) {
+  FILE *f = fopen(path, "rb");
+  if (!f) return false;
+  uint8_t buf[4096];
+  size_t n;
+  while ((n = fread(buf, 1, sizeof(buf), f)) > 0) {
+    data.insert(data.end(), buf, buf + n);
+  }
+  bool ok = !ferror(f);
+  fclose(f);
+  return ok;
+}
+
+pb_host_stream stream_of(const std::vector<uint8_t> &data) {
+  return pb_host_stream{data.data(), data.data() + data.size()};
+}
+
+//! Decode the entries of a LogBundle, which nanopb leaves to a callback
+bool read_log_bundle(const std::vector<uint8_t> &data, std::vector<LogEntry> &entries) {
+  pb_host_stream s = stream_of(data);
+  while (s.p != s.end) {
+    uint32_t tag, wire_type;
+    pb_host_stream value;
+    if (!pb_host_next(s, tag, wire_type, value)) return false;
+    if (tag != LogBundle_entry_tag || wire_type != 2) continue;
+    LogEntry l = {};
+    if (!pb_host_decode(value, LogEntry_host_msg, &l)) return false;
+    // the state that the policy saw
+    predictState(l, l.lead);
+    entries.push_back(l);
+  }
+  return true;
+}
+
+struct deviation {
+  double wheel = 0, turntable = 0;
+  size_t worst = 0;  //!< the index of the entry with the largest deviation
+};
+
+}
+
+int main(int argc, char **argv) {
+  double tol = -1;
+  int arg = 1;
+  if (arg + 1 < argc && strcmp(argv[arg], "--tol") == 0) {
+    tol = atof(argv[arg + 1]);
+    arg += 2;
+  }
+  if (argc - arg < 2) {
+    fprintf(stderr, "usage: %s [--tol <x>] controller.pb log.pb...\n", argv[0]);
+    return 2;
+  }
+
+  std::vector<uint8_t> data;
+  Controller c = {};
+  if (!read_file(argv[arg], data) || !pb_host_decode(stream_of(data), Controller_host_msg, &c)) {
+    fprintf(stderr, "could not read a Controller from %s\n", argv[arg]);
+    return 2;
+  }
+  setPolicy(c);
+  applyPendingPolicy();
+
+  std::vector<LogEntry> all;
+  deviation total;
+  printf("%-30s %8s %12s %12s\n", "log", "entries", "max dWheel", "max dTT");
+  for (arg++; arg < argc; arg++) {
+    std::vector<LogEntry> entries;
+    data.clear();
+    if (!read_file(argv[arg], data) || !read_log_bundle(data, entries)) {
+      fprintf(stderr, "could not read a LogBundle from %s\n", argv[arg]);
+      return 2;
+    }
+
+    deviation d;
+    for (size_t i = 0; i < entries.size(); i++) {
+      PolicyOutputs u = computePolicies(entries[i]);
+      double dw = fabs(u.wheel - entries[i].WheelInput);
+      double dt = fabs(u.turntable - entries[i].TurntableInput);
+      if (fmax(dw, dt) > fmax(d.wheel, d.turntable)) d.worst = i;
+      d.wheel = fmax(d.wheel, dw);
+      d.turntable = fmax(d.turntable, dt);
+    }
+    printf("%-30s %8zu %12.3e %12.3e", argv[arg], entries.size(), d.wheel, d.turntable);
+    if (!entries.empty() && fmax(d.wheel, d.turntable) > 0) {
+      printf("   worst at entry %zu, tick %lu", d.worst, (unsigned long) entries[d.worst].tick);
+    }
+    printf("\n");
+
+    total.wheel = fmax(total.wheel, d.wheel);
+    total.turntable = fmax(total.turntable, d.turntable);
+    all.insert(all.end(), entries.begin(), entries.end());
+  }
+  if (all.empty()) {
+    printf("no log entries\n");
+    return 2;
+  }
+
+  // throughput on the host, over every entry of every log
+  std::vector<PolicyOutputs> out(all.size());
+  double t = bench::time_ns([&]{
+    for (size_t i = 0; i < all.size(); i++) out[i] = computePolicies(all[i]);
+    bench::keep(out);
+  });
+  printf("%zu evaluations, max deviation wheel %.3e, turntable %.3e, %.3g evaluations/s\n",
+         all.size(), total.wheel, total.turntable, all.size() / (t * 1e-9));
+
+  if (tol >= 0 && fmax(total.wheel, total.turntable) > tol) {
+    printf("FAIL: outputs differ from the log by more than %g\n", tol);
+    return 1;
+  }
+}
@@ -0,0 +1,70 @@
+#! python3
+"""
+Replay logs through src/policy.cpp with build/replay, converting any .mat
+files to the serialized messages that it reads.
+
+usage: replay.py [--tol <x>] controller log...
+
+where controller is a .mat file as loaded by the terminal `policy` command,
+or a serialized Controller, and each log is a .mat file saved by the
+terminal, or the serialized LogBundle saved alongside it. .mat files need
+scipy, as the terminal does.
+"""
+import subprocess
+import sys
+import tempfile
+from pathlib import Path
+
+here = Path(__file__).resolve().parent
+sys.path.insert(0, str(here.parent / 'tools'))
+
+import messages_pb2
+
+
+def controller_bytes(path):
+    if path.suffix != '.mat':
+        return path.read_bytes()
+    import matlabio
+    return matlabio.load_policy(str(path)).SerializeToString()
+
+
+def log_bytes(path):
+    if path.suffix != '.mat':
+        return path.read_bytes()
+    import scipy.io
+    logs = scipy.io.loadmat(str(path), squeeze_me=True)['msg']
+    bundle = messages_pb2.LogBundle()
+    names = [f.name for f in messages_pb2.LogEntry.DESCRIPTOR.fields]
+    for row in logs.reshape(-1):
+        entry = bundle.entry.add()
+        for name in names:
+            if name in logs.dtype.names:
+                setattr(entry, name, row[name].item())
+    return bundle.SerializeToString()
+
+
+def main(argv):
+    tol = []
+    if len(argv) >= 2 and argv[0] == '--tol':
+        tol, argv = argv[:2], argv[2:]
+    if len(argv) < 2:
+        print(__doc__)
+        return 2
+
+    with tempfile.TemporaryDirectory() as tmp:
+        tmp = Path(tmp)
+        controller = tmp / 'controller.pb'
+        controller.write_bytes(controller_bytes(Path(argv[0])))
+        logs = []
+        for i, arg in enumerate(argv[1:]):
+            path = Path(arg)
+            if path.suffix == '.mat':
+                converted = tmp / '{}-{}.pb'.format(i, path.stem)
+                converted.write_bytes(log_bytes(path))
+                path = converted
+            logs.append(str(path))
+        return subprocess.call([str(here / 'build' / 'replay')] + tol + [str(controller)] + logs)
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv[1:]))
@@ -0,0 +1,149 @@
+/**
+ * Accuracy and speed of the GEOMETRY_FAST_TRIG backend in trig.h.
+ *
+ * This is built with GEOMETRY_FAST_TRIG defined, and sweeps a grid over the
+ * whole unit quaternion sphere, comparing the euler angles from the library
+ * against a double-precision reference and against the libm float version.
+ */
+#include <stdio.h>
+#include <math.h>
+
+#include <quat.h>
+#include <euler.h>
+#include <trig.h>
+
+#include "bench.h"
+
+using namespace geometry;
+
+namespace {
+
+// The same formulas as euler_angles<213>, with a choice of trig functions
+template<typename T, typename Atan2, typename Asin>
+void euler213(const quat &q, T &phi, T &theta, T &psi, Atan2 atan2_, Asin asin_) {
+  T x = q.x, y = q.y, z = q.z, w = q.w;
+  phi   = atan2_(-2*w*y + 2*x*z, x*x -y*y -z*z +w*w);
+  theta = asin_(  2*z*w + 2*x*y);
+  psi   = atan2_(-2*y*z + 2*x*w, x*x -y*y +z*z -w*w);
+}
+
+double angle_diff(double a, double b) {
+  return fabs(remainder(a - b, 2*M_PI));
+}
+
+struct max_error {
+  double all = 0;       // over the whole sphere
+  double regular = 0;   // excluding within 5 degrees of gimbal lock
+  void update(double err, bool is_regular) {
+    if (err > all) all = err;
+    if (is_regular && err > regular) regular = err;
+  }
+};
+
+//! Sample the unit quaternions on a grid of Hopf coordinates
+std::vector<quat> sphere_grid(int n_eta, int n_xi) {
+  std::vector<quat> qs;
+  for (int i = 0; i <= n_eta; i++) {
+    double eta = (M_PI / 2) * i / n_eta;
+    for (int j = 0; j < n_xi; j++) {
+      double xi1 = 2 * M_PI * j / n_xi;
+      for (int k = 0; k < n_xi; k++) {
+        double xi2 = 2 * M_PI * k / n_xi;
+        qs.push_back(quat(cos(eta) * cos(xi1), sin(eta) * cos(xi2),
+                          sin(eta) * sin(xi2), cos(eta) * sin(xi1)));
+      }
+    }
+  }
+  return qs;
+}
+
+}
+
+int main() {
+  auto libm_atan2 = [](float y, float x) { return atan2f(y, x); };
+  auto libm_asin  = [](float x) { return asinf(x); };
+  auto ref_atan2  = [](double y, double x) { return atan2(y, x); };
+  auto ref_asin   = [](double x) { return asin(fmax(-1, fmin(1, x))); };
+
+  std::vector<quat> qs = sphere_grid(64, 128);
+  printf("Sweeping %zu quaternions\n", qs.size());
+
+  // accuracy of the conversion
+  max_error vs_ref[3], vs_libm[3];
+  for (const quat &q : qs) {
+    euler_angles<213> e = q;
+    double r[3];
+    float l[3];
+    euler213(q, r[0], r[1], r[2], ref_atan2, ref_asin);
+    euler213(q, l[0], l[1], l[2], libm_atan2, libm_asin);
+    float f[3] = {e.phi, e.theta, e.psi};
+
+    bool regular = fabs(r[1]) < (85 * M_PI / 180);
+    for (int i = 0; i < 3; i++) {
+      vs_ref[i].update(angle_diff(f[i], r[i]), regular);
+      vs_libm[i].update(angle_diff(f[i], l[i]), regular);
+    }
+  }
+  const char *names[3] = {"phi", "theta", "psi"};
+  printf("max error of euler_angles<213>, in rad\n");
+  printf("           vs libm float         vs double reference\n");
+  printf("           all       |theta|<85  all       |theta|<85\n");
+  for (int i = 0; i < 3; i++) {
+    printf("  %-6s   %.2e  %.2e    %.2e  %.2e\n", names[i],
+           vs_libm[i].all, vs_libm[i].regular, vs_ref[i].all, vs_ref[i].regular);
+  }
+
+  // accuracy of sin and cos within their documented range
+  double sin_err = 0, cos_err = 0;
+  for (int i = -1000000; i <= 1000000; i++) {
+    float x = 4 * M_PI * i / 1000000;
+    sin_err = fmax(sin_err, fabs(fast::sin(x) - sin(double(x))));
+    cos_err = fmax(cos_err, fabs(fast::cos(x) - cos(double(x))));
+  }
+  printf("max error of sin: %.2e, cos: %.2e, for |x| < 4pi\n", sin_err, cos_err);
+
+  // relative error of exp_neg, and absolute error where it flushes to zero
+  std::vector<float> xs;
+  double exp_rel_err = 0, exp_abs_err = 0;
+  for (int i = 0; i <= 2000000; i++) {
+    float x = 20.0f * i / 2000000;
+    double ref = exp(-double(x)), e = fast::exp_neg(x);
+    if (x < 17) exp_rel_err = fmax(exp_rel_err, fabs(e - ref) / ref);
+    else        exp_abs_err = fmax(exp_abs_err, fabs(e - ref));
+    xs.push_back(x);
+  }
+  printf("max error of exp_neg: relative %.2e for x < 17, absolute %.2e beyond\n",
+         exp_rel_err, exp_abs_err);
+
+  // speed of the conversion
+  std::vector<euler_angles<213>> out(qs.size());
+  double t_fast = bench::time_ns([&]{
+    for (size_t i = 0; i < qs.size(); i++) out[i] = qs[i];
+    bench::keep(out);
+  }, 5);
+  double t_libm = bench::time_ns([&]{
+    for (size_t i = 0; i < qs.size(); i++) {
+      euler213(qs[i], out[i].phi, out[i].theta, out[i].psi, libm_atan2, libm_asin);
+    }
+    bench::keep(out);
+  }, 5);
+  printf("euler_angles<213>: libm %.2f ns/op, fast %.2f ns/op, speedup %.2fx\n",
+         t_libm / qs.size(), t_fast / qs.size(), t_libm / t_fast);
+
+  std::vector<float> ys(xs.size());
+  double t_exp_libm = bench::time_ns([&]{
+    for (size_t i = 0; i < xs.size(); i++) ys[i] = expf(-xs[i]);
+    bench::keep(ys);
+  }, 5);
+  double t_exp_fast = bench::time_ns([&]{
+    for (size_t i = 0; i < xs.size(); i++) ys[i] = fast::exp_neg(xs[i]);
+    bench::keep(ys);
+  }, 5);
+  printf("exp(-x): libm %.2f ns/op, fast %.2f ns/op, speedup %.2fx\n",
+         t_exp_libm / xs.size(), t_exp_fast / xs.size(), t_exp_libm / t_exp_fast);
+
+  if (exp_rel_err > 4e-7 || exp_abs_err > 5e-8) {
+    printf("FAIL: exp_neg is less accurate than documented\n");
+    return 1;
+  }
+}
@@ -0,0 +1,96 @@
+/**
+ * Kernels for comparing the code generated by the Vector3 expression templates
+ * against the previous eager operators, which built a whole Vector3 of the
+ * promoted scalar type for every operation.
+ *
+ * This is only compiled to assembly; vector_codegen.sh counts the instructions
+ * in each function.
+ */
+#include <stdint.h>
+
+#include <vector3.h>
+
+using namespace geometry;
+
+namespace eager {
+  // the operators from before the expression templates
+  template<typename T, typename U,
+           typename R = decltype(declval<T>() + declval<U>())>
+  inline Vector3<R> operator +(Vector3<T> a, const Vector3<U> &b) {
+    return Vector3<R>(R(a.x) + b.x, R(a.y) + b.y, R(a.z) + b.z);
+  }
+  template<typename T, typename U,
+           typename R = decltype(declval<T>() - declval<U>())>
+  inline Vector3<R> operator -(Vector3<T> a, const Vector3<U> &b) {
+    return Vector3<R>(R(a.x) - b.x, R(a.y) - b.y, R(a.z) - b.z);
+  }
+  template<typename T, typename U,
+           typename R = decltype(declval<T>() * declval<U>())>
+  inline Vector3<R> operator *(Vector3<T> a, const U &f) {
+    return Vector3<R>(R(a.x) * f, R(a.y) * f, R(a.z) * f);
+  }
+  template<typename T, typename U,
+           typename R = decltype(declval<T>() / declval<U>())>
+  inline Vector3<R> operator /(Vector3<T> a, const U &f) {
+    return Vector3<T>(a.x / f, a.y / f, a.z / f);
+  }
+}
+
+namespace {
+  const float RAD_PER_LSB_S = (M_PI / 180) / 14.375;
+
+  // as in gyroAccel.cpp
+  template<typename T>
+  Vector3<T> chipToRobotFrame(Vector3<T> v_chip) {
+    return Vector3<T>(-v_chip.z, v_chip.x, -v_chip.y);
+  }
+}
+
+extern "C" {
+
+// gyroRawToSI(gyroReadRaw() - gyro_offset)
+void gyro_si_fused(const Vector3<int16_t> &raw, const Vector3<float> &offset,
+                   Vector3<float> &out) {
+  out = chipToRobotFrame(Vector3<float>((raw - offset) * RAD_PER_LSB_S));
+}
+void gyro_si_eager(const Vector3<int16_t> &raw, const Vector3<float> &offset,
+                   Vector3<float> &out) {
+  using namespace eager;
+  out = chipToRobotFrame(Vector3<float>((raw - offset) * RAD_PER_LSB_S));
+}
+
+// the mean angular velocity in intAngVel
+void mean_rate_fused(const Vector3<float> &w, const Vector3<float> &w0,
+                     Vector3<float> &out) {
+  out = (w + w0) / 2.0;
+}
+void mean_rate_eager(const Vector3<float> &w, const Vector3<float> &w0,
+                     Vector3<float> &out) {
+  using namespace eager;
+  out = (w + w0) / 2.0;
+}
+
+// scaling a float vector by a double constant
+void scale_rate_fused(const Vector3<float> &w, Vector3<float> &out) {
+  out = w * 0.05;
+}
+void scale_rate_eager(const Vector3<float> &w, Vector3<float> &out) {
+  using namespace eager;
+  out = w * 0.05;
+}
+
+// a step of gyroCalibrate
+void calibrate_fused(const Vector3<int16_t> &lsb, Vector3<int32_t> &sum,
+                     Vector3<int32_t> &sum2) {
+  sum += lsb;
+  sum2 += lsb.cwiseProduct(lsb);
+}
+void calibrate_eager(const Vector3<int16_t> &lsb, Vector3<int32_t> &sum,
+                     Vector3<int32_t> &sum2) {
+  sum = eager::operator+(sum, lsb);
+  for (int i = 0; i < 3; i++) {
+    sum2[i] += lsb[i] * lsb[i];
+  }
+}
+
+}
@@ -0,0 +1,31 @@
+#!/bin/sh
+# Count the instructions generated for each kernel in vector_codegen.cpp, and
+# fail if an expression template version calls out of line, uses double
+# precision, or is any longer than the eager one.
+#
+# usage: vector_codegen.sh file.s
+
+asm="$1"
+
+# print "name instructions doubles calls" for each function in the assembly
+awk '
+  /^[a-z_]+:$/ { fn = substr($0, 1, length($0) - 1); n = 0; d = 0; c = 0; next }
+  fn != "" && /^\t\.size/ { print fn, n, d, c; fn = ""; next }
+  fn != "" && /^\t[a-z]/ {
+    n++
+    if ($1 ~ /^call/) c++
+    if ($1 ~ /^v?cvt(ss2sd|sd2ss|si2sd|sd2si)/ || $1 ~ /^v?(add|sub|mul|div)sd$/) d++
+  }
+' "$asm" | sort > "$asm.counts"
+
+status=0
+printf "%-12s %8s %8s   %s\n" kernel eager fused "double-precision instructions (eager/fused)"
+for k in $(sed -n 's/_fused .*//p' "$asm.counts"); do
+  set -- $(grep "^${k}_eager " "$asm.counts") $(grep "^${k}_fused " "$asm.counts")
+  printf "%-12s %8d %8d   %d/%d\n" "$k" "$2" "$6" "$3" "$7"
+  if [ "$6" -gt "$2" ] || [ "$7" -gt 0 ] || [ "$8" -gt 0 ]; then
+    echo "  FAIL: $k"
+    status=1
+  fi
+done
+exit $status
@@ -0,0 +1,112 @@
+/**
+ * A per-tick cache of the quantities derived from the attitude quaternion.
+ *
+ * The control loop needs the (2,1,3) euler angles of q, and the sines and
+ * cosines of them for the position estimate and the euler rates. These are all
+ * found here at once from q, so that nothing downstream needs to call a trig
+ * function.
+ */
+#pragma once
+
+#include "quat.h"
+#include "euler.h"
+#include "vector3.h"
+#include "trig.h"
+
+namespace geometry {
+
+//! The sine and cosine of an angle
+struct sin_cos {
+  float sin;
+  float cos;
+};
+
+struct attitude_cache {
+  /**
+   * The rotation matrix R(q) of Diebel eq. 125, which takes vectors in the
+   * world frame to the body frame.
+   */
+  float R[3][3];
+
+  //! The (2,1,3) euler angles, as euler_angles<213>(q) gives
+  euler_angles<213> angles;
+
+  //! The sine and cosine of each of the angles
+  sin_cos phi, theta, psi;
+
+  attitude_cache() {}
+
+  /**
+   * Derive everything from a unit quaternion. This costs the atan2, asin and
+   * atan2 of the euler conversion, and a single sqrt and division for all the
+   * sines and cosines.
+   */
+  template<typename T>
+  explicit attitude_cache(const basic_quat<T> &q) {
+    T x = q.x, y = q.y, z = q.z, w = q.w;
+    T xx = x*x, yy = y*y, zz = z*z, ww = w*w;
+    T r02 = 2*(y*w - x*z);
+    T r10 = 2*(y*z - x*w);
+    T r11 = xx - yy + zz - ww;
+    T r12 = 2*(z*w + x*y);
+    T r22 = xx - yy - zz + ww;
+
+    R[0][0] = float(xx + yy - zz - ww);
+    R[0][1] = float(2*(y*z + x*w));
+    R[0][2] = float(r02);
+    R[1][0] = float(r10);
+    R[1][1] = float(r11);
+    R[1][2] = float(r12);
+    R[2][0] = float(2*(y*w + x*z));
+    R[2][1] = float(2*(z*w - x*y));
+    R[2][2] = float(r22);
+
+    // these are the terms of detail::euler_213_terms
+    angles.phi   = float(trig::atan2(-r02, r22));
+    angles.theta = float(trig::asin(r12));
+    angles.psi   = float(trig::atan2(-r10, r11));
+
+    // the first and last columns of the (2,1,3) matrix are scaled by cos(theta)
+    float cos2_theta = R[0][2]*R[0][2] + R[2][2]*R[2][2];
+    theta.sin = R[1][2];
+    theta.cos = trig::sqrt(cos2_theta);
+    if (cos2_theta > 1e-6f) {
+      float inv_cos_theta = 1 / theta.cos;
+      phi.sin = -R[0][2] * inv_cos_theta;
+      phi.cos =  R[2][2] * inv_cos_theta;
+      psi.sin = -R[1][0] * inv_cos_theta;
+      psi.cos =  R[1][1] * inv_cos_theta;
+    }
+    else {
+      // at the gimbal singularity the terms are all rounding error, so match
+      // whatever angles atan2 made of them
+      phi.sin = trig::sin(angles.phi);
+      phi.cos = trig::cos(angles.phi);
+      psi.sin = trig::sin(angles.psi);
+      psi.cos = trig::cos(angles.psi);
+    }
+  }
+
+  //! The rotation by psi about the world z axis, as removed by remove_psi
+  quat psi_rotation() const {
+    return quat::bisect(1, quat(psi.cos, 0, 0, psi.sin));
+  }
+};
+
+/**
+ * As euler_rates_213(q, w), but using the sines and cosines in the cache. The
+ * clamp on cos(theta) is the same.
+ */
+template<typename R>
+euler_angles<213> euler_rates_213(const attitude_cache &a, const Vector3<R> &w) {
+  float wx = float(w.x), wy = float(w.y), wz = float(w.z);
+  float cos_theta = a.theta.cos < 1e-3f ? 1e-3f : a.theta.cos;
+
+  euler_angles<213> rates;
+  rates.theta = a.phi.cos*wx + a.phi.sin*wz;
+  rates.psi   = (a.phi.cos*wz - a.phi.sin*wx) / cos_theta;
+  rates.phi   = wy - a.theta.sin * rates.psi;
+  return rates;
+}
+
+}
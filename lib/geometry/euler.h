@@ -1,6 +1,7 @@
 #pragma once
 
 #include "quat.h"
+#include "trig.h"
 
 namespace geometry {
 
@@ -14,21 +15,126 @@ struct euler_angles {
   constexpr euler_angles(float phi, float theta, float psi)
     : phi(phi), theta(theta), psi(psi) {}
   euler_angles(const quat &q);
+  euler_angles(const basic_quat<q2_29> &q);
 
   operator quat() const;
 
   static quat remove_psi(const quat &q);
 };
 
+// https://www.astro.rug.nl/software/kapteyn/_downloads/attitude.pdf#page=24
+template<>
+inline euler_angles<123>::euler_angles(const quat &q) {
+  float x = q.x, y = q.y, z = q.z, w = q.w;
+
+  phi   = trig::atan2(2*z*w + 2*x*y, w*w -z*z -y*y +x*x);
+  theta = -trig::asin(2*y*w - 2*x*z);
+  psi   = trig::atan2(2*y*z + 2*x*w, y*y +x*x -w*w -z*z);
+}
+
+namespace detail {
+  /**
+   * The arguments to the trig functions in the (2,1,3) conversion, which are
+   * multiples of the sin and cos of each angle. For a unit quaternion,
+   *
+   *   (phi_s, phi_c) = cos(theta) (sin(phi), cos(phi))
+   *   theta_s        = sin(theta)
+   *   (psi_s, psi_c) = cos(theta) (sin(psi), cos(psi))
+   *
+   * https://www.astro.rug.nl/software/kapteyn/_downloads/attitude.pdf#page=28
+   */
+  template<typename T>
+  struct euler_213_terms {
+    T phi_s, phi_c, theta_s, psi_s, psi_c;
+
+    euler_213_terms(const basic_quat<T> &q) {
+      T x = q.x, y = q.y, z = q.z, w = q.w;
+      phi_s   = -2*w*y + 2*x*z;
+      phi_c   = x*x -y*y -z*z +w*w;
+      theta_s =  2*z*w + 2*x*y;
+      psi_s   = -2*y*z + 2*x*w;
+      psi_c   = x*x -y*y +z*z -w*w;
+    }
+  };
+
+  template<typename T>
+  void to_euler_213(const basic_quat<T> &q, float &phi, float &theta, float &psi) {
+    euler_213_terms<T> t = q;
+    phi   = float(trig::atan2(t.phi_s, t.phi_c));
+    theta = float(trig::asin(t.theta_s));
+    psi   = float(trig::atan2(t.psi_s, t.psi_c));
+  }
+
+  template<typename T>
+  basic_quat<T> remove_psi_213(const basic_quat<T> &q) {
+    // taken from euler_angles<213>::euler_angles;
+    euler_213_terms<T> t = q;
+
+    // reconstruct the psi rotation
+    auto psi_quat_double = basic_quat<T>(t.psi_c, 0, 0, t.psi_s);
+    psi_quat_double.normalize();
+    auto un_psi_quat = basic_quat<T>::bisect(T(1), psi_quat_double).conj();
+
+    return q * un_psi_quat;
+  }
+
+  template<typename T>
+  basic_quat<T> from_euler_213(T phi, T theta, T psi) {
+    return
+      basic_quat<T>(trig::cos(phi   / 2), 0,                    trig::sin(phi   / 2), 0) *
+      basic_quat<T>(trig::cos(theta / 2), trig::sin(theta / 2), 0,                    0) *
+      basic_quat<T>(trig::cos(psi   / 2), 0,                    0,                    trig::sin(psi / 2));
+  }
+}
 
 template<>
-euler_angles<123>::euler_angles(const quat &q);
+inline euler_angles<213>::euler_angles(const quat &q) {
+  detail::to_euler_213(q, phi, theta, psi);
+}
 
 template<>
-euler_angles<213>::euler_angles(const quat &q);
+inline euler_angles<213>::euler_angles(const basic_quat<q2_29> &q) {
+  detail::to_euler_213(q, phi, theta, psi);
+}
 
 template<>
-euler_angles<213>::operator quat() const;
+inline quat euler_angles<213>::remove_psi(const quat &q) {
+  return detail::remove_psi_213(q);
+}
+
+/**
+ * The rates of change of the (2,1,3) euler angles of the unit quaternion q,
+ * when rotating with angular velocity w in the body frame, as in intAngVel.
+ *
+ * This inverts the kinematic equation
+ *
+ *   w = (cos(phi) dtheta - sin(phi) cos(theta) dpsi,
+ *        dphi + sin(theta) dpsi,
+ *        sin(phi) dtheta + cos(phi) cos(theta) dpsi)
+ *
+ * taking the sines and cosines from the terms of the quaternion to euler
+ * conversion, so needs no trig functions. It is singular when cos(theta) = 0,
+ * where cos(theta)^2 is clamped to 1e-6 to keep the result finite.
+ */
+template<typename T, typename R>
+euler_angles<213> euler_rates_213(const basic_quat<T> &q, const Vector3<R> &w) {
+  detail::euler_213_terms<T> t = q;
+  float phi_s = float(t.phi_s), phi_c = float(t.phi_c);
+  float wx = float(w.x), wy = float(w.y), wz = float(w.z);
 
+  float cos2_theta = phi_s*phi_s + phi_c*phi_c;
+  if (cos2_theta < 1e-6f) cos2_theta = 1e-6f;
+
+  euler_angles<213> rates;
+  rates.theta = (phi_c*wx + phi_s*wz) / trig::sqrt(cos2_theta);
+  rates.psi   = (phi_c*wz - phi_s*wx) / cos2_theta;
+  rates.phi   = wy - float(t.theta_s) * rates.psi;
+  return rates;
+}
+
+template<>
+inline euler_angles<213>::operator quat() const {
+  return detail::from_euler_213(phi, theta, psi);
+}
 
-}
\ No newline at end of file
+}
@@ -0,0 +1,321 @@
+/**
+ * Fixed-point arithmetic, so that the attitude maths can run on integer
+ * instructions on the FPU-less microcontroller.
+ *
+ * fixed<F> is a signed 32-bit Q-format number with F fractional bits. All of
+ * the arithmetic saturates rather than wrapping. The formats used here are
+ *
+ *   q2_29:   unit quaternion components and angles, in [-4, 4)
+ *   q16_16:  angular velocities and accelerations, in [-32768, 32768)
+ *
+ * Multiplying by a float is deliberately a compile error, as it would either
+ * truncate the float or fall back to soft-float. Convert constants with
+ * `fixed<F>(0.5)` instead, preferably in a constexpr context.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+#include "trig.h"
+
+namespace geometry {
+
+namespace detail {
+  const int32_t fixed_max = 0x7fffffff;
+  const int32_t fixed_min = -0x7fffffff - 1;
+
+  constexpr int32_t saturate(int64_t v) {
+    return v > fixed_max ? fixed_max :
+           v < fixed_min ? fixed_min : int32_t(v);
+  }
+
+  //! v * 2^-s, rounding to nearest
+  constexpr int64_t shift_round(int64_t v, int s) {
+    return s > 0 ? (v + (int64_t(1) << (s - 1))) >> s
+                 : v * (int64_t(1) << -s);
+  }
+
+  //! round a float that has already been scaled by 2^F
+  template<typename Fl>
+  constexpr int32_t round_saturate(Fl v) {
+    return v >=  Fl(2147483647.0) ? fixed_max :
+           v <= -Fl(2147483648.0) ? fixed_min :
+           int32_t(v < 0 ? v - Fl(0.5) : v + Fl(0.5));
+  }
+
+  /**
+   * round_saturate(v * 2^s), working on the bits of v so that it needs no
+   * soft-float calls. NaN becomes 0. The float multiply and conversion cost
+   * over a hundred cycles on the PIC32, and this about twenty.
+   */
+  inline int32_t ldexp_round(float v, int s) {
+    uint32_t b;
+    memcpy(&b, &v, sizeof(b));
+    int e = int(b >> 23 & 0xff);
+    uint32_t m = b & 0x7fffff;
+    if (e == 0xff && m != 0) return 0;  // NaN
+    if (e == 0) return 0;               // zero, or too small to matter
+
+    // |v| * 2^s = m * 2^shift, with the implicit leading bit
+    m |= 0x800000;
+    int shift = e - 150 + s;
+    uint32_t mag;
+    if (shift >= 8)       mag = 0x80000000u;  // also infinity
+    else if (shift >= 0)  mag = m << shift;
+    else if (shift > -25) mag = (m + (uint32_t(1) << (-shift - 1))) >> -shift;
+    else                  mag = 0;
+
+    if (b >> 31) return mag >= 0x80000000u ? fixed_min : -int32_t(mag);
+    return mag >= 0x80000000u ? fixed_max : int32_t(mag);
+  }
+
+  //! r * 2^-s rounded to the nearest float, likewise without soft-float calls
+  inline float ldexp_float(int32_t r, int s) {
+    if (r == 0) return 0;
+    uint32_t sign = r < 0 ? 0x80000000u : 0;
+    uint32_t mag = r < 0 ? 0u - uint32_t(r) : uint32_t(r);
+
+    // normalize to 24 bits, with the leading bit at bit 23
+    int top = 31 - __builtin_clz(mag);
+    if (top > 23) {
+      int d = top - 23;
+      mag = (mag + (uint32_t(1) << (d - 1))) >> d;
+      if (mag >> 24) {
+        mag >>= 1;
+        top++;
+      }
+    }
+    else {
+      mag <<= 23 - top;
+    }
+
+    int e = top - s + 127;
+    if (e <= 0) return sign ? -0.0f : 0.0f;
+    uint32_t b = e >= 0xff ? sign | 0x7f800000u : sign | uint32_t(e) << 23 | (mag & 0x7fffff);
+    float f;
+    memcpy(&f, &b, sizeof(f));
+    return f;
+  }
+}
+
+template<int F>
+class fixed {
+  struct raw_tag {};
+  constexpr fixed(int32_t r, raw_tag) : raw(r) {}
+
+public:
+  static constexpr int frac_bits = F;
+
+  //! The stored integer, which is the value multiplied by 2^F
+  int32_t raw;
+
+  fixed() {}
+  constexpr fixed(int i)    : raw(detail::saturate(int64_t(i) * (int64_t(1) << F))) {}
+  constexpr fixed(long i)   : raw(detail::saturate(int64_t(i) * (int64_t(1) << F))) {}
+  constexpr fixed(float f)  : raw(detail::round_saturate(f * float(int64_t(1) << F))) {}
+  constexpr fixed(double d) : raw(detail::round_saturate(d * double(int64_t(1) << F))) {}
+
+  //! conversion between formats, rounding and saturating as needed
+  template<int G>
+  explicit constexpr fixed(fixed<G> f)
+    : raw(detail::saturate(detail::shift_round(f.raw, G - F))) {}
+
+  static constexpr fixed from_raw(int32_t r) { return fixed(r, raw_tag()); }
+
+  explicit constexpr operator float() const {
+    return raw * (1.0f / float(int64_t(1) << F));
+  }
+  explicit constexpr operator double() const {
+    return raw * (1.0 / double(int64_t(1) << F));
+  }
+
+  // arithmetic
+  friend constexpr fixed operator+(fixed a, fixed b) {
+    return from_raw(detail::saturate(int64_t(a.raw) + b.raw));
+  }
+  friend constexpr fixed operator-(fixed a, fixed b) {
+    return from_raw(detail::saturate(int64_t(a.raw) - b.raw));
+  }
+  friend constexpr fixed operator*(fixed a, fixed b) {
+    return from_raw(detail::saturate(
+      detail::shift_round(int64_t(a.raw) * b.raw, F)));
+  }
+  friend constexpr fixed operator/(fixed a, fixed b) {
+    return b.raw == 0 ? from_raw(a.raw < 0 ? detail::fixed_min : detail::fixed_max)
+                      : from_raw(detail::saturate(int64_t(a.raw) * (int64_t(1) << F) / b.raw));
+  }
+  constexpr fixed operator-() const {
+    return from_raw(detail::saturate(-int64_t(raw)));
+  }
+
+  // scaling by integers is exact, up to saturation
+  friend constexpr fixed operator*(fixed a, int i) {
+    return from_raw(detail::saturate(int64_t(a.raw) * i));
+  }
+  friend constexpr fixed operator*(int i, fixed a) { return a * i; }
+  friend constexpr fixed operator/(fixed a, int i) { return from_raw(a.raw / i); }
+
+  friend fixed operator*(fixed, float)  = delete;
+  friend fixed operator*(fixed, double) = delete;
+  friend fixed operator*(float, fixed)  = delete;
+  friend fixed operator*(double, fixed) = delete;
+  friend fixed operator/(fixed, float)  = delete;
+  friend fixed operator/(fixed, double) = delete;
+
+  fixed& operator+=(fixed b) { return *this = *this + b; }
+  fixed& operator-=(fixed b) { return *this = *this - b; }
+  fixed& operator*=(fixed b) { return *this = *this * b; }
+  fixed& operator/=(fixed b) { return *this = *this / b; }
+  fixed& operator*=(int i)   { return *this = *this * i; }
+  fixed& operator/=(int i)   { return *this = *this / i; }
+  fixed& operator*=(float)  = delete;
+  fixed& operator*=(double) = delete;
+  fixed& operator/=(float)  = delete;
+  fixed& operator/=(double) = delete;
+
+  // comparison
+  friend constexpr bool operator==(fixed a, fixed b) { return a.raw == b.raw; }
+  friend constexpr bool operator!=(fixed a, fixed b) { return a.raw != b.raw; }
+  friend constexpr bool operator< (fixed a, fixed b) { return a.raw <  b.raw; }
+  friend constexpr bool operator> (fixed a, fixed b) { return a.raw >  b.raw; }
+  friend constexpr bool operator<=(fixed a, fixed b) { return a.raw <= b.raw; }
+  friend constexpr bool operator>=(fixed a, fixed b) { return a.raw >= b.raw; }
+};
+
+typedef fixed<29> q2_29;
+typedef fixed<16> q16_16;
+
+/**
+ * Multiply numbers of different formats, producing a result with R fractional
+ * bits. The full 64-bit product is kept until the final rounding, so this is
+ * more accurate than converting either argument first.
+ */
+template<int R, int F, int G>
+constexpr fixed<R> fixed_mul(fixed<F> a, fixed<G> b) {
+  return fixed<R>::from_raw(detail::saturate(
+    detail::shift_round(int64_t(a.raw) * b.raw, F + G - R)));
+}
+
+namespace detail {
+  //! floor(sqrt(v))
+  inline uint32_t isqrt(uint64_t v) {
+    uint64_t res = 0;
+    uint64_t bit = uint64_t(1) << 62;
+    while (bit > v) bit >>= 2;
+    while (bit != 0) {
+      if (v >= res + bit) {
+        v -= res + bit;
+        res = (res >> 1) + bit;
+      }
+      else {
+        res >>= 1;
+      }
+      bit >>= 2;
+    }
+    return uint32_t(res);
+  }
+
+  //! atan(2^-i), in Q2.30
+  const int32_t cordic_atan[30] = {
+    843314857, 497837829, 263043837, 133525159, 67021687,
+    33543516, 16775851, 8388437, 4194283, 2097149,
+    1048576, 524288, 262144, 131072, 65536,
+    32768, 16384, 8192, 4096, 2048,
+    1024, 512, 256, 128, 64,
+    32, 16, 8, 4, 2,
+  };
+  const int32_t cordic_inv_gain = 652032874;  // prod cos(atan(2^-i)), in Q2.30
+  const int32_t half_pi_q30 = 1686629713;
+  const int64_t pi_q30 = 3373259426LL;
+}
+
+/**
+ * Overloads of the functions in trig.h, so that generic code calling
+ * `trig::sqrt(x)` and friends works on fixed-point numbers. These use CORDIC,
+ * and are accurate to a few units of the last place of q2_29.
+ */
+namespace trig {
+  template<int F>
+  fixed<F> sqrt(fixed<F> x) {
+    if (x.raw <= 0) return 0;
+    return fixed<F>::from_raw(detail::isqrt(uint64_t(x.raw) << F));
+  }
+
+  //! atan2(y, x) in [-pi, pi], by CORDIC vectoring
+  template<int F>
+  q2_29 atan2(fixed<F> y, fixed<F> x) {
+    // leave headroom for the CORDIC gain of 1.65
+    int32_t xi = x.raw >> 2, yi = y.raw >> 2;
+    if (xi == 0 && yi == 0) return 0;
+
+    // rotate into the right half-plane
+    int64_t z = 0;
+    if (xi < 0) {
+      z = yi < 0 ? -detail::pi_q30 : detail::pi_q30;
+      xi = -xi;
+      yi = -yi;
+    }
+
+    // rotate onto the x axis, accumulating the angle rotated
+    for (int i = 0; i < 30; i++) {
+      int32_t dx = yi >> i, dy = xi >> i;
+      if (yi > 0) { xi += dx; yi -= dy; z += detail::cordic_atan[i]; }
+      else        { xi -= dx; yi += dy; z -= detail::cordic_atan[i]; }
+    }
+    return q2_29::from_raw(int32_t(detail::shift_round(z, 1)));
+  }
+
+  template<int F>
+  q2_29 asin(fixed<F> x) {
+    fixed<F> one = 1;
+    return trig::atan2(x, trig::sqrt((one - x) * (one + x)));
+  }
+
+  //! sin(a) and cos(a), by CORDIC rotation
+  template<int F>
+  void sincos(fixed<F> a, fixed<F> &s, fixed<F> &c) {
+    // reduce to [-pi, pi] in Q2.30
+    const int64_t two_pi = 2 * detail::pi_q30;
+    int64_t z = detail::shift_round(a.raw, F - 30) % two_pi;
+    if (z > detail::pi_q30) z -= two_pi;
+    if (z < -detail::pi_q30) z += two_pi;
+
+    // and then to [-pi/2, pi/2], remembering to flip the cosine
+    bool flip = false;
+    if (z > detail::half_pi_q30)  { z =  detail::pi_q30 - z; flip = true; }
+    if (z < -detail::half_pi_q30) { z = -detail::pi_q30 - z; flip = true; }
+
+    int32_t xi = detail::cordic_inv_gain, yi = 0, zi = int32_t(z);
+    for (int i = 0; i < 30; i++) {
+      int32_t dx = yi >> i, dy = xi >> i;
+      if (zi > 0) { xi -= dx; yi += dy; zi -= detail::cordic_atan[i]; }
+      else        { xi += dx; yi -= dy; zi += detail::cordic_atan[i]; }
+    }
+    s = fixed<F>(fixed<30>::from_raw(yi));
+    c = fixed<F>(fixed<30>::from_raw(flip ? -xi : xi));
+  }
+  template<int F>
+  fixed<F> sin(fixed<F> a) { fixed<F> s, c; sincos(a, s, c); return s; }
+  template<int F>
+  fixed<F> cos(fixed<F> a) { fixed<F> s, c; sincos(a, s, c); return c; }
+
+  //! e^x, saturating if the result is out of range
+  template<int F>
+  fixed<F> exp(fixed<F> x) {
+    // x = k ln(2) + r, with |r| <= ln(2)/2, rounding in 64 bits so that x
+    // near the limits of the format does not overflow
+    const fixed<F> ln2 = 0.69314718;
+    int k = int((int64_t(x.raw) + (x.raw < 0 ? -ln2.raw : ln2.raw) / 2) / ln2.raw);
+    if (k > 31)  return fixed<F>::from_raw(detail::fixed_max);
+    if (k < -32) return 0;
+    fixed<F> r = x - ln2 * k;
+
+    // taylor series of e^r, which has error < 2e-8 for |r| < ln(2)/2
+    fixed<F> er = 1 + r*(1 + r*(fixed<F>(1/2.) + r*(fixed<F>(1/6.)
+                + r*(fixed<F>(1/24.) + r*(fixed<F>(1/120.) + r*fixed<F>(1/720.))))));
+    return fixed<F>::from_raw(detail::saturate(detail::shift_round(er.raw, -k)));
+  }
+}
+
+}
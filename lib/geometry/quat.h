@@ -1,43 +1,187 @@
+// provide simple manipulations of quaternions: conjugate, multiply and extract
+// Euler angles (using 123, or pitch, roll, yaw convention). See J. Diebel:
+// Representing Attitude: Euler Angles, Unit Quaternions, and Rotation Vectors
+// https://www.astro.rug.nl/software/kapteyn/_downloads/attitude.pdf
+//
+// Carl Edward Rasmussen, 2011-09-28
+// Aleksi Tukiainen, 2016-05-20
+
+// The quaternion quat(x,y,z,w) represents x + y i + z j + w k
+// Note: The names of the variables are usually ordered as (w,x,y,z)
+// That representation is written in comments
+
 #pragma once
 
 #include "vector3.h"
+#include "fixed.h"
+#include "trig.h"
 
 namespace geometry {
 
-class quat
+/**
+ * A quaternion with components of type T. This is normally float, but can be
+ * a fixed-point type from fixed.h to avoid soft-float.
+ *
+ * Everything is defined inline, so that calls in the control loop can be
+ * inlined and folded. Operations which need no square root are constexpr, so
+ * constant rotations can be built at compile time.
+ */
+template<typename T>
+class basic_quat
 {
 public:
-  float x, y, z, w;
-  quat() {};
-  constexpr quat(float x, float y, float z, float w) : x(x), y(y), z(z), w(w) {}
-  constexpr quat(float k, Vector3<float> v) : quat(k, v.x, v.y, v.z) {}
-  constexpr quat(Vector3<float> v)          : quat(0, v.x, v.y, v.z) {}
-  constexpr quat(float k)                   : quat(k, 0, 0, 0) {}
-
-  void normalize();
-  quat conj() const;
-  quat operator* (const quat &q) const;
-  quat& operator*= (float f);
-  quat& operator/= (float f);
-  quat& operator+= (quat q);
-  quat& operator-= (quat q);
-  float norm() const;
-
-  Vector3<float> v() const;
-
-  static quat bisect(const quat &a, const quat &b);
-  static quat between(Vector3<float> a, Vector3<float> b);
+  T x, y, z, w;
+  basic_quat() {};
+  constexpr basic_quat(T x, T y, T z, T w) : x(x), y(y), z(z), w(w) {}
+  constexpr basic_quat(T k, Vector3<T> v) : basic_quat(k, v.x, v.y, v.z) {}
+  constexpr basic_quat(Vector3<T> v)      : basic_quat(0, v.x, v.y, v.z) {}
+  constexpr basic_quat(T k)               : basic_quat(k, 0, 0, 0) {}
+
+  //! conversion from a quaternion of another scalar type
+  template<typename U>
+  explicit constexpr basic_quat(const basic_quat<U> &q)
+    : basic_quat(T(q.x), T(q.y), T(q.z), T(q.w)) {}
+
+  T norm() const {
+    return trig::sqrt(x*x+y*y+z*z+w*w);
+  }
+
+  void normalize() {
+    *this /= norm();
+  }
+
+  /**
+   * As normalize(), but cheaper for a quaternion whose norm is already within
+   * about 1e-4 of 1, as after an integration step. Then 1/norm() is replaced
+   * with the first-order approximation (3 - |q|^2)/2, which has an error of
+   * at most 4e-9 and needs no square root or division.
+   */
+  void renormalize() {
+    T n2 = x*x+y*y+z*z+w*w;
+    T err = n2 - T(1);
+    if (err < T(1e-4) && err > T(-1e-4)) {
+      *this *= (T(3) - n2) / 2;
+    }
+    else {
+      normalize();
+    }
+  }
+
+  // conjugate unit quaternion
+  constexpr basic_quat conj() const {
+    return basic_quat(x, -y, -z, -w);
+  }
+
+  constexpr Vector3<T> v() const {
+    return Vector3<T>(y, z, w);
+  }
+
+  // quaternion multiplication
+  constexpr basic_quat operator* (const basic_quat &q) const {
+    // This function seems right: see p. 14 on J. Diebel's paper
+    return basic_quat(q.x*x - q.y*y - q.z*z - q.w*w,
+                      q.x*y + q.y*x + q.z*w - q.w*z,
+                      q.x*z - q.y*w + q.z*x + q.w*y,
+                      q.x*w + q.y*z - q.z*y + q.w*x);
+  }
+
+  // basic arithmetic operators
+  basic_quat& operator+= (basic_quat q) { return *this = *this + q; }
+  basic_quat& operator-= (basic_quat q) { return *this = *this - q; }
+  basic_quat& operator*= (T f)          { return *this = *this * f; }
+  basic_quat& operator/= (T f)          { return *this = *this / f; }
+
+  friend constexpr basic_quat operator +(const basic_quat &a, const basic_quat &b) {
+    return basic_quat(a.x + b.x, a.y + b.y, a.z + b.z, a.w + b.w);
+  }
+  friend constexpr basic_quat operator -(const basic_quat &a, const basic_quat &b) {
+    return basic_quat(a.x - b.x, a.y - b.y, a.z - b.z, a.w - b.w);
+  }
+  friend constexpr basic_quat operator *(const basic_quat &q, T f) {
+    return basic_quat(q.x * f, q.y * f, q.z * f, q.w * f);
+  }
+  friend constexpr basic_quat operator *(T f, const basic_quat &q) {
+    return q * f;
+  }
+  friend constexpr basic_quat operator /(const basic_quat &q, T f) {
+    return basic_quat(q.x / f, q.y / f, q.z / f, q.w / f);
+  }
+
+  static basic_quat bisect(const basic_quat &a, const basic_quat &b) {
+    auto q = a + b;
+    q.normalize();
+    return q;
+  }
+
+  static basic_quat between(Vector3<T> a, Vector3<T> b) {
+    T len_ab = trig::sqrt(a.squaredNorm() * b.squaredNorm());
+    auto double_rotation = basic_quat(dot(a, b), cross(a, b)) / len_ab;
+
+    // halfway between identity and what we calculated
+    return basic_quat::bisect(T(1), double_rotation);
+  }
 };
 
-inline quat operator +(quat q1, const quat& q2) { return q1 += q2; }
-inline quat operator -(quat q1, const quat& q2) { return q1 -= q2; }
-inline quat operator *(quat q1, float f) { return q1 *= f; }
-inline quat operator *(float f, quat q1) { return q1 *= f; }
-inline quat operator /(quat q1, float f) { return q1 /= f; }
+typedef basic_quat<float> quat;
 
 // names match the standard library
-float arg(const quat &q);
+inline float arg(const quat &q) {
+  return acos(q.x / q.norm());
+}
+
 quat log(const quat &q);  // TODO?
-quat exp(const quat &q);
+
+namespace detail {
+  /**
+   * The largest |v|^2 for which each order of the taylor series in exp_pure is
+   * used. These keep the truncation error of both cos|v| and sin|v|/|v| below
+   * 5e-8, which is under half a float ULP of 1.
+   */
+  constexpr float taylor2_max = 1e-3;  // |v| < 0.032
+  constexpr float taylor4_max = 3e-2;  // |v| < 0.17
+  constexpr float taylor6_max = 2e-1;  // |v| < 0.45
+}
+
+/**
+ * exp of the pure quaternion (0, v), which is the rotation by angle 2|v| about
+ * v. Small angles, like those turned through in one control tick, use a
+ * taylor series of just enough order to be as accurate as exp(), without any
+ * sqrt, sin or cos.
+ */
+template<typename T>
+basic_quat<T> exp_pure(const Vector3<T> &v) {
+  T t2 = v.squaredNorm();
+  T c;  // cos|v|
+  T s;  // sin|v| / |v|
+  if (t2 < T(detail::taylor2_max)) {
+    c = T(1) - t2 / 2;
+    s = T(1) - t2 / 6;
+  }
+  else if (t2 < T(detail::taylor4_max)) {
+    c = T(1) - t2 * (T(1/2.) - t2 * T(1/24.));
+    s = T(1) - t2 * (T(1/6.) - t2 * T(1/120.));
+  }
+  else if (t2 < T(detail::taylor6_max)) {
+    c = T(1) - t2 * (T(1/2.) - t2 * (T(1/24.) - t2 * T(1/720.)));
+    s = T(1) - t2 * (T(1/6.) - t2 * (T(1/120.) - t2 * T(1/5040.)));
+  }
+  else {
+    T t = trig::sqrt(t2);
+    c = trig::cos(t);
+    s = trig::sin(t) / t;
+  }
+  return basic_quat<T>(c, v * s);
+}
+
+// https://math.stackexchange.com/q/1030737/1896
+template<typename T>
+basic_quat<T> exp(const basic_quat<T> &q) {
+  T n = trig::sqrt(q.y*q.y + q.z*q.z + q.w*q.w);
+  if (n == T(0)) return trig::exp(q.x);
+  return trig::exp(q.x) * basic_quat<T>(
+    trig::cos(n),
+    q.v() * (trig::sin(n) / n)
+  );
+}
 
 }
@@ -0,0 +1,130 @@
+/**
+ * Trigonometric functions used by the geometry library.
+ *
+ * The microcontroller has no FPU, so the libm versions of these functions are
+ * expensive. Defining GEOMETRY_FAST_TRIG (in the build_flags) replaces them
+ * with the polynomial approximations in geometry::fast, which have the
+ * following bounds on their absolute error, including float rounding:
+ *
+ *   atan2, asin:  1.2e-5 rad, over their whole domain
+ *   sin, cos:     7e-7, for |x| < 4pi (range reduction loses accuracy beyond)
+ *
+ * fast::exp_neg is always used by the RBF policies, and has a relative error
+ * of 3.1e-7 for x < 17, beyond which it returns 0.
+ *
+ * At gimbal lock, where phi and psi are not unique, the two backends may
+ * divide the rotation between them differently. `make -C bench run` reports
+ * the measured error and speedup.
+ *
+ * Code that wants to be able to opt in should call `trig::atan2` and friends
+ * instead of the global functions.
+ */
+#pragma once
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+namespace geometry {
+
+namespace fast {
+  const float pi = 3.14159265f;
+
+  /**
+   * atan(z) for |z| <= 1, by the minimax polynomial of Abramowitz & Stegun
+   * 4.4.49, which has |error| <= 1e-5
+   */
+  inline float atan_unit(float z) {
+    float z2 = z*z;
+    return z * (0.9998660f + z2*(-0.3302995f + z2*(0.1801410f
+             + z2*(-0.0851330f + z2*0.0208351f))));
+  }
+
+  /**
+   * atan2(y, x), with atan2(0, 0) = 0. This is written with selects rather
+   * than branches, so that loops over it vectorize, as in batch::to_euler; it
+   * still does a single division.
+   */
+  inline float atan2(float y, float x) {
+    float ax = fabsf(x), ay = fabsf(y);
+
+    // reduce to the first octant
+    bool steep = ay > ax;
+    float lo = steep ? ax : ay, hi = steep ? ay : ax;
+    float a = atan_unit(hi == 0 ? 0 : lo / hi);
+    a = steep ? pi/2 - a : a;
+
+    a = x < 0 ? pi - a : a;
+    return y < 0 ? -a : a;
+  }
+
+  //! asin(x), clamping to +/- pi/2 if rounding error pushes |x| beyond 1
+  inline float asin(float x) {
+    float c2 = (1 - x)*(1 + x);
+    return fast::atan2(x, c2 > 0 ? sqrtf(c2) : 0);
+  }
+
+  /**
+   * sin(x) for |x| <= pi/2, by the polynomial of Abramowitz & Stegun 4.3.97,
+   * which has |error| <= 2e-9 (before rounding)
+   */
+  inline float sin_half_pi(float x) {
+    float x2 = x*x;
+    return x * (1 + x2*(-0.1666666664f + x2*(0.0083333315f
+             + x2*(-0.0001984090f + x2*(0.0000027526f - x2*0.0000000239f)))));
+  }
+
+  inline float sin(float x) {
+    // reduce to [-pi, pi], and then reflect into [-pi/2, pi/2]
+    x -= 2*pi * floorf(x / (2*pi) + 0.5f);
+    if (x > pi/2) x = pi - x;
+    else if (x < -pi/2) x = -pi - x;
+    return sin_half_pi(x);
+  }
+
+  inline float cos(float x) {
+    return fast::sin(x + pi/2);
+  }
+
+  /**
+   * exp(-x) for x >= 0, as 2^-n 2^g with n an integer and |g| <= 1/2. 2^g is
+   * the polynomial of the cephes exp2f, and 2^-n is applied to the exponent
+   * bits directly. Beyond x = 17 the result is below 5e-8, and is flushed to
+   * zero, as it also is for NaN.
+   */
+  inline float exp_neg(float x) {
+    if (!(x < 17)) return 0;
+    float y = x * 1.44269504f;  // log2(e)
+    int32_t n = int32_t(y + 0.5f);
+    float g = float(n) - y;
+    float p = 1 + g*(6.931472028550421e-1f + g*(2.402264791363012e-1f
+                + g*(5.550332471162809e-2f + g*(9.618437357674640e-3f
+                + g*(1.339887440266574e-3f + g*1.535336188319500e-4f)))));
+    uint32_t bits;
+    memcpy(&bits, &p, sizeof(bits));
+    bits -= uint32_t(n) << 23;
+    memcpy(&p, &bits, sizeof(p));
+    return p;
+  }
+}
+
+//! The functions selected by GEOMETRY_FAST_TRIG. fixed.h adds overloads of
+//! these for fixed-point numbers.
+namespace trig {
+  inline float sqrt(float x)           { return ::sqrt(x); }
+  inline float exp(float x)            { return ::exp(x); }
+
+#ifdef GEOMETRY_FAST_TRIG
+  inline float atan2(float y, float x) { return fast::atan2(y, x); }
+  inline float asin(float x)           { return fast::asin(x); }
+  inline float sin(float x)            { return fast::sin(x); }
+  inline float cos(float x)            { return fast::cos(x); }
+#else
+  inline float atan2(float y, float x) { return ::atan2(y, x); }
+  inline float asin(float x)           { return ::asin(x); }
+  inline float sin(float x)            { return ::sin(x); }
+  inline float cos(float x)            { return ::cos(x); }
+#endif
+}
+
+}
@@ -5,8 +5,88 @@
 namespace geometry {
 
 template<typename T>
-class Vector3{
+T declval() noexcept;
+
+namespace detail {
+  template<typename T> struct is_floating    { static constexpr bool value = false; };
+  template<> struct is_floating<float>       { static constexpr bool value = true; };
+  template<> struct is_floating<double>      { static constexpr bool value = true; };
+  template<> struct is_floating<long double> { static constexpr bool value = true; };
+
+  template<bool B, typename T, typename F> struct conditional { typedef T type; };
+  template<typename T, typename F> struct conditional<false, T, F> { typedef F type; };
+
+  /**
+   * The type that a scalar of type U is converted to before being combined
+   * with vector elements of type T. Between floating point types this is T, so
+   * that `v / 2.0` does not promote a float vector to double and back.
+   */
+  template<typename T, typename U>
+  struct scalar_operand
+    : conditional<is_floating<T>::value && is_floating<U>::value, T, U> {};
+
+  // the element-wise operations
+  struct op_add {
+    template<typename A, typename B>
+    static constexpr auto apply(A a, B b) -> decltype(a + b) { return a + b; }
+  };
+  struct op_sub {
+    template<typename A, typename B>
+    static constexpr auto apply(A a, B b) -> decltype(a - b) { return a - b; }
+  };
+  struct op_mul {
+    template<typename A, typename B>
+    static constexpr auto apply(A a, B b) -> decltype(a * b) { return a * b; }
+  };
+  struct op_div {
+    template<typename A, typename B>
+    static constexpr auto apply(A a, B b) -> decltype(a / b) { return a / b; }
+  };
+
+  constexpr double sqrt_newton(double x, double guess, int iters) {
+    return iters == 0 ? guess : sqrt_newton(x, (guess + x / guess) / 2, iters - 1);
+  }
+
+  //! sqrt for use in constant expressions, accurate to double precision for
+  //! 1e-10 < x < 1e10. This is far too slow to call at runtime.
+  constexpr double constexpr_sqrt(double x) {
+    return x <= 0 ? 0 : sqrt_newton(x, x > 1 ? x : 1, 40);
+  }
+}
+
+template<typename Op, typename A, typename B> class VectorBinaryOp;
+
+/**
+ * Base class of everything that can be used as a vector: Vector3 itself, and
+ * the unevaluated results of arithmetic on vectors.
+ *
+ * The arithmetic operators below build expression objects rather than
+ * Vector3s, which are only evaluated element by element when assigned to a
+ * Vector3. This means that a chain like `(raw - offset) * scale` is computed
+ * in one pass, without temporaries. Every E provides a `Scalar` typedef, and
+ * `get<i>()` to compute the i-th element. The index is a template parameter so
+ * that no element selection is left at runtime, even at -Os.
+ *
+ * Expressions hold copies of their operands, so can safely be stored with
+ * `auto`, but they are normally converted straight to a Vector3.
+ */
+template<typename E>
+class VectorExpr {
 public:
+  constexpr const E& derived() const { return static_cast<const E&>(*this); }
+
+  //! the element-wise product
+  template<typename B>
+  constexpr VectorBinaryOp<detail::op_mul, E, B> cwiseProduct(const VectorExpr<B> &b) const {
+    return VectorBinaryOp<detail::op_mul, E, B>(derived(), b.derived());
+  }
+};
+
+template<typename T>
+class Vector3 : public VectorExpr<Vector3<T>> {
+public:
+  typedef T Scalar;
+
   T x;
   T y;
   T z;
@@ -15,54 +95,60 @@ public:
   T operator [](int i) const { return (&x)[i];}
   T & operator [](int i) { return (&x)[i];}
 
+  //! as operator[], but for a constant index, and usable in constant expressions
+  template<int i>
+  constexpr T get() const { return i == 0 ? x : i == 1 ? y : z; }
+
   Vector3() {}
   constexpr Vector3(T x, T y, T z) : x(x), y(y), z(z) {}
 
+  //! evaluate an expression, converting to this scalar type
+  template<typename E>
+  constexpr Vector3(const VectorExpr<E> &e)
+    : x(T(e.derived().template get<0>())),
+      y(T(e.derived().template get<1>())),
+      z(T(e.derived().template get<2>())) {}
+
   static constexpr Vector3<T> Zero() {
     return Vector3<T>(0, 0, 0);
   }
 
-  // conversion to other scalar types
-  template<typename U>
-  constexpr operator Vector3<U>() {
-    return Vector3<U>(x, y, z);
-  }
-
   // basic arithmetic
-  template<typename U>
-  Vector3<T>& operator +=(Vector3<U> v) {
-    x += v.x;
-    y += v.y;
-    z += v.z;
+  template<typename E>
+  Vector3<T>& operator +=(const VectorExpr<E> &v) {
+    const E &e = v.derived();
+    x += e.template get<0>();
+    y += e.template get<1>();
+    z += e.template get<2>();
     return *this;
   }
-  template<typename U>
-  Vector3<T>& operator -=(Vector3<U> v) {
-    x -= v.x;
-    y -= v.y;
-    z -= v.z;
+  template<typename E>
+  Vector3<T>& operator -=(const VectorExpr<E> &v) {
+    const E &e = v.derived();
+    x -= e.template get<0>();
+    y -= e.template get<1>();
+    z -= e.template get<2>();
     return *this;
   }
   template<typename U>
   Vector3<T>& operator *=(U f) {
-    x *= f;
-    y *= f;
-    z *= f;
+    typedef typename detail::scalar_operand<T, U>::type S;
+    x *= S(f);
+    y *= S(f);
+    z *= S(f);
     return *this;
   }
   template<typename U>
   Vector3<T>& operator /=(U f) {
-    x /= f;
-    y /= f;
-    z /= f;
+    typedef typename detail::scalar_operand<T, U>::type S;
+    x /= S(f);
+    y /= S(f);
+    z /= S(f);
     return *this;
   }
-  Vector3<T> operator-() const {
-    return Vector3<T>(-x, -y, -z);
-  }
 
   // other operations
-  T squaredNorm() const {
+  constexpr T squaredNorm() const {
     return x*x + y*y + z*z;
   }
 
@@ -75,15 +161,66 @@ public:
     res.normalize();
     return res;
   }
+
+  //! as normalized(), but can be evaluated at compile time, for constants
+  constexpr Vector3<T> constNormalized() const {
+    return scaled(1 / detail::constexpr_sqrt(double(squaredNorm())));
+  }
+
+private:
+  constexpr Vector3<T> scaled(double f) const {
+    return Vector3<T>(T(double(x) * f), T(double(y) * f), T(double(z) * f));
+  }
+};
+
+//! An element-wise operation between two vector expressions
+template<typename Op, typename A, typename B>
+class VectorBinaryOp : public VectorExpr<VectorBinaryOp<Op, A, B>> {
+  A a;
+  B b;
+public:
+  typedef decltype(Op::apply(declval<typename A::Scalar>(),
+                             declval<typename B::Scalar>())) Scalar;
+
+  constexpr VectorBinaryOp(const A &a, const B &b) : a(a), b(b) {}
+  template<int i>
+  constexpr Scalar get() const {
+    return Op::apply(a.template get<i>(), b.template get<i>());
+  }
+};
+
+//! An operation between each element of a vector expression and a scalar
+template<typename Op, typename A, typename S>
+class VectorScalarOp : public VectorExpr<VectorScalarOp<Op, A, S>> {
+  A a;
+  S s;
+public:
+  typedef decltype(Op::apply(declval<typename A::Scalar>(), declval<S>())) Scalar;
+
+  constexpr VectorScalarOp(const A &a, S s) : a(a), s(s) {}
+  template<int i>
+  constexpr Scalar get() const { return Op::apply(a.template get<i>(), s); }
+};
+
+//! The negation of a vector expression
+template<typename A>
+class VectorNegate : public VectorExpr<VectorNegate<A>> {
+  A a;
+public:
+  typedef decltype(-declval<typename A::Scalar>()) Scalar;
+
+  constexpr VectorNegate(const A &a) : a(a) {}
+  template<int i>
+  constexpr Scalar get() const { return -a.template get<i>(); }
 };
 
 template<typename T>
-T dot(Vector3<T> a, Vector3<T> b) {
+constexpr T dot(Vector3<T> a, Vector3<T> b) {
   return a.x*b.x + a.y*b.y + a.z*b.z;
 }
 
 template<typename T>
-Vector3<T> cross(Vector3<T> a, Vector3<T> b) {
+constexpr Vector3<T> cross(Vector3<T> a, Vector3<T> b) {
   return Vector3<T>(
     a.y*b.z - a.z*b.y,
     a.z*b.x - a.x*b.z,
@@ -92,33 +229,38 @@ Vector3<T> cross(Vector3<T> a, Vector3<T> b) {
 }
 
 
-template<typename T>
-T declval() noexcept;
-
-template<typename T, typename U,
-         typename R = decltype(declval<T>() + declval<U>())>
-inline Vector3<R> operator +(Vector3<T> a, const Vector3<U> &b) {
-  return static_cast<Vector3<R>>(a) += b;
+template<typename A, typename B>
+constexpr VectorBinaryOp<detail::op_add, A, B>
+operator +(const VectorExpr<A> &a, const VectorExpr<B> &b) {
+  return VectorBinaryOp<detail::op_add, A, B>(a.derived(), b.derived());
 }
-template<typename T, typename U,
-         typename R = decltype(declval<T>() - declval<U>())>
-inline Vector3<R> operator -(Vector3<T> a, const Vector3<U> &b) {
-  return static_cast<Vector3<R>>(a) -= b;
+template<typename A, typename B>
+constexpr VectorBinaryOp<detail::op_sub, A, B>
+operator -(const VectorExpr<A> &a, const VectorExpr<B> &b) {
+  return VectorBinaryOp<detail::op_sub, A, B>(a.derived(), b.derived());
 }
-template<typename T, typename U,
-         typename R = decltype(declval<T>() * declval<U>())>
-inline Vector3<R> operator *(Vector3<T> a, const U &f) {
-  return static_cast<Vector3<R>>(a) *= f;
-}
-template<typename T, typename U,
-         typename R = decltype(declval<T>() / declval<U>())>
-inline Vector3<R> operator /(Vector3<T> a, const U &b) {
-  return a /= b;
+template<typename A>
+constexpr VectorNegate<A> operator -(const VectorExpr<A> &a) {
+  return VectorNegate<A>(a.derived());
 }
 
-template<typename T, typename U>
-inline auto operator *(T f, Vector3<U> a) {
-  return a * f;
+template<typename A, typename U,
+         typename S = typename detail::scalar_operand<typename A::Scalar, U>::type>
+constexpr VectorScalarOp<detail::op_mul, A, S>
+operator *(const VectorExpr<A> &a, const U &f) {
+  return VectorScalarOp<detail::op_mul, A, S>(a.derived(), S(f));
+}
+template<typename A, typename U,
+         typename S = typename detail::scalar_operand<typename A::Scalar, U>::type>
+constexpr VectorScalarOp<detail::op_mul, A, S>
+operator *(const U &f, const VectorExpr<A> &a) {
+  return VectorScalarOp<detail::op_mul, A, S>(a.derived(), S(f));
+}
+template<typename A, typename U,
+         typename S = typename detail::scalar_operand<typename A::Scalar, U>::type>
+constexpr VectorScalarOp<detail::op_div, A, S>
+operator /(const VectorExpr<A> &a, const U &f) {
+  return VectorScalarOp<detail::op_div, A, S>(a.derived(), S(f));
 }
 
 }
@@ -6,7 +6,11 @@ We use it to compile the protobuf definition files using nanopb.
 
 Running `pio run -t python` will rebuild the python protobuf files
 and dump them in :/tools
+
+When the build_flags contain -DBAKED_POLICY=<controller>, this also generates
+baked_policy.h from that controller file, using policy_codegen.py.
 """
+import os
 
 from SCons.Script import DefaultEnvironment, Main
 
@@ -37,3 +41,20 @@ for f in ['messages', 'policies']:
     )
 
 env.Alias('python', target_python)
+
+
+def baked_policy(env):
+    """ The controller file named by -DBAKED_POLICY in the build_flags, if any """
+    for define in env.get('CPPDEFINES', []):
+        if isinstance(define, (list, tuple)) and define[0] == 'BAKED_POLICY':
+            return os.path.join(env.subst('$PROJECT_DIR'), define[1])
+    return None
+
+# policy_codegen.py needs the python 3 protobuf package, like the tools
+controller = baked_policy(env)
+if controller:
+    env.Command(
+        target='baked_policy.h',
+        source=[controller, 'policy_codegen.py'],
+        action='python3 ${SOURCES[1]} ${SOURCES[0]} $TARGET'
+    )
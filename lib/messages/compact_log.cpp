@@ -0,0 +1,124 @@
+#include <math.h>
+
+#include "compact_log.h"
+
+namespace {
+    //! A field of LogEntry, and how it is packed into a CompactLogEntry
+    struct compact_field {
+        uint8_t tag;
+        float LogEntry::* value;     //!< for float fields
+        uint32_t LogEntry::* count;  //!< for integer fields
+        uint8_t bits;
+        uint8_t step;                //!< a float is stored as round(x * 2^step)
+        bool wraps;                  //!< keep the low bits, rather than saturate
+    };
+
+    #define COMPACT_FLOAT(f) {LogEntry_##f##_tag, &LogEntry::f, nullptr, CompactLogBits_BITS_##f, CompactLogStep_STEP_##f, false}
+    #define COMPACT_ANGLE(f) {LogEntry_##f##_tag, &LogEntry::f, nullptr, CompactLogBits_BITS_##f, CompactLogStep_STEP_##f, true}
+    #define COMPACT_UINT(f)  {LogEntry_##f##_tag, nullptr, &LogEntry::f, CompactLogBits_BITS_##f, 0, true}
+
+    /**
+     * The fields of LogEntry, in the order they are packed. The tick comes
+     * first, as the fields that follow it may depend on it, and the rest are
+     * in the order of their field numbers.
+     */
+    constexpr compact_field fields[] = {
+        COMPACT_UINT(tick),
+        COMPACT_FLOAT(droll),
+        COMPACT_FLOAT(dyaw),
+        COMPACT_FLOAT(dAngleW),
+        COMPACT_FLOAT(dpitch),
+        COMPACT_FLOAT(dAngleTT),
+        COMPACT_FLOAT(xOrigin),
+        COMPACT_FLOAT(yOrigin),
+        COMPACT_FLOAT(roll),
+        COMPACT_FLOAT(yaw),
+        COMPACT_FLOAT(pitch),
+        COMPACT_FLOAT(x),
+        COMPACT_FLOAT(y),
+        COMPACT_ANGLE(AngleW),
+        COMPACT_ANGLE(AngleTT),
+        COMPACT_FLOAT(TurntableInput),
+        COMPACT_FLOAT(WheelInput),
+        COMPACT_FLOAT(ddx),
+        COMPACT_FLOAT(ddy),
+        COMPACT_FLOAT(ddz),
+        COMPACT_UINT(policy_version),
+        COMPACT_FLOAT(lead),
+        COMPACT_FLOAT(latency),
+        COMPACT_UINT(policy_slot),
+    };
+
+    #undef COMPACT_FLOAT
+    #undef COMPACT_ANGLE
+    #undef COMPACT_UINT
+
+    const size_t n_fields = sizeof(fields) / sizeof(fields[0]);
+    const size_t n_words = sizeof(CompactLogEntry::packed) / sizeof(uint32_t);
+
+    constexpr size_t totalBits(size_t i = 0) {
+        return i == n_fields ? 0 : fields[i].bits + totalBits(i + 1);
+    }
+    static_assert(totalBits() <= 32 * n_words,
+        "CompactLogEntry.packed in messages.options is too small for CompactLogBits");
+
+    //! Whether a field is packed, given the mask of fields
+    inline bool packed(const compact_field& f, uint32_t fields) {
+        return f.tag == LogEntry_tick_tag || (fields >> (f.tag - 1) & 1);
+    }
+
+    inline uint32_t lowBits(uint32_t v, uint8_t bits) {
+        return bits < 32 ? v & ((uint32_t(1) << bits) - 1) : v;
+    }
+
+    //! The two's complement value of a field
+    inline int32_t signExtend(uint32_t v, uint8_t bits) {
+        const uint32_t sign = uint32_t(1) << (bits - 1);
+        return int32_t(v ^ sign) - int32_t(sign);
+    }
+
+    //! The bits to store for a float field
+    uint32_t quantize(float x, const compact_field& f) {
+        float q = ldexpf(x, f.step);
+        if (q != q) return 0;
+        if (!f.wraps) {
+            const float max = float(uint32_t(1) << (f.bits - 1)) - 1;
+            if (q >= max) return lowBits(uint32_t(max), f.bits);
+            if (q <= -max - 1) return lowBits(uint32_t(int32_t(-max - 1)), f.bits);
+        }
+        return lowBits(uint32_t(int32_t(lroundf(q))), f.bits);
+    }
+}
+
+void compactLogEntry(const LogEntry& entry, uint32_t fields_sent, CompactLogEntry& compact) {
+    for (size_t i = 0; i < n_words; i++) compact.packed[i] = 0;
+
+    // pack each field from the low bits of the first word up
+    size_t pos = 0;
+    for (const compact_field& f : fields) {
+        if (!packed(f, fields_sent)) continue;
+        uint32_t v = f.value ? quantize(entry.*f.value, f) : lowBits(entry.*f.count, f.bits);
+        const size_t word = pos / 32, shift = pos % 32;
+        compact.packed[word] |= v << shift;
+        if (shift + f.bits > 32) compact.packed[word + 1] |= v >> (32 - shift);
+        pos += f.bits;
+    }
+    compact.packed_count = (pos + 31) / 32;
+}
+
+void expandLogEntry(const CompactLogEntry& compact, uint32_t fields_sent, LogEntry& entry) {
+    size_t pos = 0;
+    for (const compact_field& f : fields) {
+        if (!packed(f, fields_sent)) continue;
+        const size_t word = pos / 32, shift = pos % 32;
+        uint32_t v = word < compact.packed_count ? compact.packed[word] >> shift : 0;
+        if (shift + f.bits > 32 && word + 1 < compact.packed_count) {
+            v |= compact.packed[word + 1] << (32 - shift);
+        }
+        v = lowBits(v, f.bits);
+        pos += f.bits;
+
+        if (f.value) entry.*f.value = ldexpf(float(signExtend(v, f.bits)), -f.step);
+        else entry.*f.count = v;
+    }
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <messages.pb.h>
+
+/**
+ * Quantize the fields of a LogEntry with bit n-1 of fields_sent set for field
+ * n, and the tick, into a CompactLogEntry, with the bit widths and steps
+ * declared in messages.proto. Only as many words are used as those fields
+ * need.
+ */
+void compactLogEntry(const LogEntry& entry, uint32_t fields_sent, CompactLogEntry& compact);
+
+/**
+ * The LogEntry that a CompactLogEntry was made from with the same fields_sent,
+ * to within the steps it was quantized to, and with the other fields left
+ * unchanged. Fields which wrap around only have their low bits, so are not
+ * unwrapped.
+ */
+void expandLogEntry(const CompactLogEntry& compact, uint32_t fields_sent, LogEntry& entry);
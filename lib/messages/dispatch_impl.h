@@ -42,7 +42,10 @@ typedef type_list<
     GetLogs,
     CalibrateGyro,
     GetAccelerometer,
-    SetMotors
+    SetMotors,
+    SetImuCalibration,
+    StorePolicy,
+    PatchPolicy
 > msg_types;
 
 /**
@@ -66,6 +69,9 @@ template <typename T> struct field_info {};
     DECLARE_FIELD_INFO(CalibrateGyro, calibrate);
     DECLARE_FIELD_INFO(GetAccelerometer, get_acc);
     DECLARE_FIELD_INFO(SetMotors, set_motors);
+    DECLARE_FIELD_INFO(SetImuCalibration, set_imu_calibration);
+    DECLARE_FIELD_INFO(StorePolicy, store_policy);
+    DECLARE_FIELD_INFO(PatchPolicy, patch_policy);
 #undef DECLARE_FIELD_INFO
 
 /**
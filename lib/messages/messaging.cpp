@@ -6,9 +6,11 @@
 #include <cobs/Stream.h>
 #include <PacketListener.h>
 #include <pb_arduino.h>  // for as_pb_ostream
+#include <pb_common.h>   // for pb_field_iter_t
 
 #include <messaging.h>
 
+#include "compact_log.h"
 #include "nanopb_helpers.h"
 #include "dispatch_impl.h"
 
@@ -21,6 +23,42 @@ namespace {
 
     packetio::PacketListener listener(cobs_in);
 
+    //! the LogEntry fields that sendLog sends, with bit n-1 for field n
+    uint32_t log_fields = ~uint32_t(0);
+
+    //! the ticks between each time a field is sent, at n-1 for field n, or 0 for every tick
+    uint32_t log_every[32];
+
+    //! Whether the LogEntry field with a tag is to be sent on a tick
+    inline bool logFieldDue(uint32_t tag, uint32_t tick) {
+        const uint32_t every = log_every[tag - 1];
+        return (log_fields >> (tag - 1) & 1) && (every <= 1 || tick % every == 0);
+    }
+
+    /**
+     * Clear the fields of an entry that are not due on its tick, so that they
+     * are left out of its encoding. Returns the fields that are due, with bit
+     * n-1 for field n, which is 0 if no field but the tick is, so that the
+     * entry need not be sent.
+     */
+    uint32_t filterLogFields(LogEntry& entry) {
+        pb_field_iter_t iter;
+        if (!pb_field_iter_begin(&iter, LogEntry_fields, &entry))
+            return 0;
+
+        const uint32_t tick = entry.tick;
+        uint32_t due = 0;
+        do {
+            if (iter.pos->tag == LogEntry_tick_tag)
+                continue;
+            if (logFieldDue(iter.pos->tag, tick))
+                due |= uint32_t(1) << (iter.pos->tag - 1);
+            else
+                memset(iter.pData, 0, iter.pos->data_size);
+        } while (pb_field_iter_next(&iter));
+        return due;
+    }
+
     //! Send a message object over serial, using protobuf and cobs
     void sendMessage(RobotMessage& message) {
         // Create stream
@@ -43,6 +81,22 @@ namespace {
         Serial.flush();
     }
 
+    //! nanopb callback for writing an array of LogEntry as CompactLogEntry
+    bool write_compact_logs(pb_ostream_t *stream, const pb_field_t *field, void * const *arg)
+    {
+        auto handle = *reinterpret_cast<nanopb_helpers::array_handle<const LogEntry>*>(*arg);
+
+        for(size_t i = 0; i < handle.len; i++) {
+            CompactLogEntry compact;
+            compactLogEntry(handle.ptr[i], ~uint32_t(0), compact);
+            if (!pb_encode_tag_for_field(stream, field))
+                return false;
+            if (!pb_encode_submessage(stream, CompactLogEntry_fields, &compact))
+                return false;
+        }
+        return true;
+    }
+
     template<typename T>
     inline bool try_handlers(const PCMessage &message) {
         if (message.which_msg == field_info<T>::tag) {
@@ -61,7 +115,9 @@ namespace {
     void handlePacket(uint8_t* data, size_t n) {
         pb_istream_t pb_stream = pb_istream_from_buffer(data, n);
 
-        PCMessage message = PCMessage_init_zero;
+        // static, as the largest messages are a few KB, too much for the stack.
+        // pb_decode clears it first, and handlePacket is never reentered
+        static PCMessage message;
         bool status = pb_decode(&pb_stream, PCMessage_fields, &message);
 
         if(!status) {
@@ -123,6 +179,30 @@ namespace logging {
     }
 }
 
+/**
+ * Choose the fields of LogEntry that sendLog and sendCompactLog send, as
+ * described by Go in messages.proto. Returns false, leaving the choice
+ * unchanged, if a rate is given for a field that LogEntry does not have.
+ */
+bool selectLogFields(uint32_t fields, const LogFieldRate* rates, size_t n) {
+    uint32_t every[32] = {};
+
+    for (size_t i = 0; i < n; i++) {
+        // find the field, to check that it exists
+        LogEntry entry;
+        pb_field_iter_t iter;
+        if (rates[i].field == 0 || rates[i].field > 32
+            || !pb_field_iter_begin(&iter, LogEntry_fields, &entry)
+            || !pb_field_iter_find(&iter, rates[i].field))
+            return false;
+        every[rates[i].field - 1] = rates[i].every;
+    }
+
+    log_fields = fields != 0 ? fields : ~uint32_t(0);
+    memcpy(log_every, every, sizeof(every));
+    return true;
+}
+
 //! send log messages
 void sendLogBundle(const LogEntry* entries, size_t n) {
     nanopb_helpers::array_handle<const LogEntry> arr = {entries, n};
@@ -137,12 +217,57 @@ void sendLogBundle(const LogEntry* entries, size_t n) {
     sendMessage(message);
 }
 
-//! send log messages
+//! send the fields of a log message chosen by selectLogFields, if any are due
 void sendLog(const LogEntry& entry) {
 
     // fill out the message
     RobotMessage message = RobotMessage_init_zero;
     message.which_msg = RobotMessage_single_log_tag;
     message.msg.single_log = entry;
+    if (!filterLogFields(message.msg.single_log))
+        return;
+    sendMessage(message);
+}
+
+//! send log messages, quantized as CompactLogEntry
+void sendCompactLogBundle(const LogEntry* entries, size_t n) {
+    nanopb_helpers::array_handle<const LogEntry> arr = {entries, n};
+
+    RobotMessage message = RobotMessage_init_zero;
+    message.which_msg = RobotMessage_log_bundle_tag;
+    message.msg.log_bundle.compact_entry.funcs.encode = &write_compact_logs;
+    message.msg.log_bundle.compact_entry.arg = &arr;
+
+    sendMessage(message);
+}
+
+//! send a log message, quantized as CompactLogEntry, with the fields chosen by selectLogFields
+void sendCompactLog(const LogEntry& entry) {
+    LogEntry filtered = entry;
+    const uint32_t due = filterLogFields(filtered);
+    if (!due)
+        return;
+
+    RobotMessage message = RobotMessage_init_zero;
+    message.which_msg = RobotMessage_compact_log_tag;
+    compactLogEntry(filtered, due, message.msg.compact_log);
+    sendMessage(message);
+}
+
+//! report entries of a streamed run that were dropped
+void sendLogGap(uint32_t tick, uint32_t count) {
+    RobotMessage message = RobotMessage_init_zero;
+    message.which_msg = RobotMessage_log_gap_tag;
+    message.msg.log_gap.tick = tick;
+    message.msg.log_gap.count = count;
+    sendMessage(message);
+}
+
+//! report that every entry of a streamed run has been sent
+void sendStreamEnd(uint32_t ticks, uint32_t dropped) {
+    RobotMessage message = RobotMessage_init_zero;
+    message.which_msg = RobotMessage_stream_end_tag;
+    message.msg.stream_end.ticks = ticks;
+    message.msg.stream_end.dropped = dropped;
     sendMessage(message);
 }
@@ -20,8 +20,13 @@ namespace logging {
     inline void error(const char* text, size_t n) { log(DebugLevel_ERROR, text, n); }
 }
 
+bool selectLogFields(uint32_t fields, const LogFieldRate* rates, size_t n);
 void sendLogBundle(const LogEntry* entries, size_t n);
 void sendLog(const LogEntry& entry);
+void sendCompactLogBundle(const LogEntry* entries, size_t n);
+void sendCompactLog(const LogEntry& entry);
+void sendLogGap(uint32_t tick, uint32_t count);
+void sendStreamEnd(uint32_t ticks, uint32_t dropped);
 
 //! stores a handler for each message type.
 template<typename T>
@@ -0,0 +1,163 @@
+#! python3
+"""
+Generate a C++ header that evaluates one fixed controller, with its
+coefficients baked in as constants, for builds that always run the same one.
+
+usage: policy_codegen.py controller out.h
+
+where controller is a .mat file as loaded by the terminal `policy` command,
+or a serialized Controller. Linear, affine, quadratic and sparse policies are
+supported. Each output becomes a single constexpr expression in the row form
+of src/policy.cpp, with the zero terms removed.
+
+build.py runs this when the build_flags contain -DBAKED_POLICY=<controller>,
+with the path relative to the project directory. src/bakedPolicy.cpp then
+evaluates the generated header in place of src/policy.cpp.
+"""
+import sys
+from pathlib import Path
+
+sys.path.insert(0, str(Path(__file__).resolve().parents[2] / 'tools'))
+
+import messages_pb2
+import policies_pb2
+import sparsify
+
+# the LinearPolicy fields, in the order of the SparsePolicy mask bits
+_state_fields = sorted(policies_pb2.LinearPolicy.DESCRIPTOR.fields, key=lambda f: f.number)
+
+
+def load_controller(path):
+    if path.suffix == '.mat':
+        import matlabio
+        return matlabio.load_policy(str(path))
+    controller = messages_pb2.Controller()
+    controller.ParseFromString(path.read_bytes())
+    return controller
+
+
+def literal(c):
+    """ A float literal for a float32 value, which round-trips exactly """
+    if c != c or c in (float('inf'), float('-inf')):
+        raise ValueError('cannot bake a coefficient of {}'.format(c))
+    s = '{:.9g}'.format(c)
+    if '.' not in s and 'e' not in s:
+        s += '.0'
+    return s + 'f'
+
+
+def state(i):
+    """ The LogEntry field for the i-th state """
+    return 's.' + _state_fields[i].name[len('k_'):]
+
+
+def terms(policy):
+    """
+    The bias, and the nonzero linear and quadratic coefficients of a policy,
+    as a dict from state index to linear coefficient, and a dict from state
+    index to a list of (state index, coefficient) for its row
+    """
+    which = policy.WhichOneof('msg')
+    if which in ('lin', 'affine', 'quad'):
+        policy = sparsify.sparsify(policy)
+    elif which != 'sparse':
+        raise ValueError('{} policies cannot be baked'.format(which or 'unset'))
+    sp = policy.sparse
+
+    n = len(_state_fields)
+    n_terms = bin(sp.lin_mask).count('1') + bin(sp.quad_mask).count('1')
+    if sp.lin_mask >> n or sp.quad_mask >> (n * (n + 1) // 2) or n_terms != len(sp.coeffs):
+        raise ValueError('the masks of the sparse policy do not match its coefficients')
+
+    coeffs = iter(sp.coeffs)
+    lin, rows = {}, {}
+    for i in range(n):
+        if sp.lin_mask >> i & 1:
+            c = next(coeffs)
+            if c != 0:
+                lin[i] = c
+    bit = 0
+    for i in range(n):
+        for j in range(i, n):
+            if sp.quad_mask >> bit & 1:
+                c = next(coeffs)
+                if c != 0:
+                    rows.setdefault(i, []).append((j, c))
+            bit += 1
+    return sp.k_bias, lin, rows
+
+
+def join(terms):
+    """ Sum (coefficient, factor) pairs, folding the signs into the operators """
+    out = ''
+    for c, factor in terms:
+        term = literal(abs(c)) + factor
+        if not out:
+            out = ('-' if c < 0 else '') + term
+        else:
+            out += (' - ' if c < 0 else ' + ') + term
+    return out
+
+
+def expression(policy):
+    """ The C++ expression for a policy, and the number of terms in it """
+    bias, lin, rows = terms(policy)
+    parts = [join([(bias, '')])] if bias != 0 else []
+    n_terms = len(lin) + sum(len(r) for r in rows.values())
+    for i in range(len(_state_fields)):
+        if i not in rows:
+            if i in lin:
+                parts.append(join([(lin[i], ' * ' + state(i))]))
+            continue
+        row = [(lin[i], '')] if i in lin else []
+        row += [(c, ' * ' + state(j)) for j, c in rows[i]]
+        parts.append('{} * ({})'.format(state(i), join(row)))
+    if not parts:
+        parts = ['0.0f']
+    expr = parts[0]
+    for part in parts[1:]:
+        expr += '\n\t\t\t- ' + part[1:] if part.startswith('-') else '\n\t\t\t+ ' + part
+    return expr, n_terms
+
+
+type_names = {'lin': 'linear', 'affine': 'affine', 'quad': 'quadratic', 'sparse': 'sparse'}
+
+
+header = """\
+// Generated by lib/messages/policy_codegen.py from {source}
+// Do not edit, but rebuild with -DBAKED_POLICY=<controller> instead
+#pragma once
+
+#include <messages.pb.h>
+
+//! The outputs of the baked controller, before saturation
+namespace baked_policy {{
+{functions}
+}}
+"""
+
+function = """\
+	//! {name}: a {type} policy, with {n} nonzero terms
+	constexpr float {name}(const LogEntry& s) {{
+		return {expr};
+	}}
+"""
+
+
+def generate(controller, source):
+    functions = []
+    for f in sorted(messages_pb2.Controller.DESCRIPTOR.fields, key=lambda f: f.number):
+        policy = getattr(controller, f.name)
+        expr, n = expression(policy)
+        functions.append(function.format(
+            type=type_names[policy.WhichOneof('msg')], n=n, name=f.name, expr=expr))
+    return header.format(source=source, functions='\n'.join(functions))
+
+
+def main(controller, out):
+    controller = Path(controller)
+    Path(out).write_text(generate(load_controller(controller), controller.name))
+
+
+if __name__ == '__main__':
+    main(*sys.argv[1:])
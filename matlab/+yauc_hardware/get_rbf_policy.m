@@ -0,0 +1,39 @@
+function pol = get_rbf_policy(ctrl)
+  %% Produce an RBF policy from the given controller
+  % This expects the PILCO GP controller parameters in ctrl.policy.p, with
+  % `inputs` (the n x D centers), `targets` (n x E) and `hyp` ((D+2) x E,
+  % holding log([ell; sf; sn]) for each output). The result has
+  %
+  %   u_e = b(e) + sum_i w(i, e) * exp(-1/2 sum_j ((z_j - c(i, j)) * il(e, j))^2)
+  %
+  % which is what the robot evaluates for an RbfPolicy. As with the affine
+  % policy, the @gSat squashing is approximated by the saturation on the robot.
+  p = ctrl.policy.p;
+  if ~isfield(p, 'inputs') || ~isfield(p, 'targets') || ~isfield(p, 'hyp')
+    error('Expected an RBF policy type')
+  end
+
+  [n, D] = size(p.inputs);
+  E = size(p.targets, 2);
+  assert(D == numel(ctrl.in_frame.names), 'RBF inputs must be the full state');
+  assert(E == numel(ctrl.out_frame.names), 'RBF targets must be the full output');
+
+  pol.c  = p.inputs;
+  pol.b  = zeros(E, 1);
+  pol.il = zeros(E, D);
+  pol.w  = zeros(n, E);
+  for e = 1:E
+    il  = exp(-p.hyp(1:D, e))';
+    sf2 = exp(2*p.hyp(D+1, e));
+    sn2 = exp(2*p.hyp(D+2, e));
+
+    % the weights of the GP posterior mean, scaled by sf^2
+    X = bsxfun(@times, p.inputs, il);
+    sq = sum(X.^2, 2);
+    K = sf2 * exp(-max(bsxfun(@plus, sq, sq') - 2*(X*X'), 0) / 2);
+    beta = (K + sn2*eye(n)) \ p.targets(:, e);
+
+    pol.il(e, :) = il;
+    pol.w(:, e) = sf2 * beta;
+  end
+end
@@ -26,14 +26,47 @@ function msg = make_ctrl_msg(ctrl)
   assert(isequal(sort(fieldnames(p_name_map)), sort(p_frame.names)));
   assert(isequal(sort(fieldnames(u_name_map)), sort(u_frame.names)));
 
-  % todo: we need some way to inspect the controller and construct the
-  %       appropriate policy type (eq quadratic)
-  pol = yauc_hardware.get_affine_policy(ctrl);
+  % RBF controllers are sent as they are, anything else is linearized
+  is_rbf = isfield(ctrl.policy.p, 'inputs');
+  if is_rbf
+    pol = yauc_hardware.get_rbf_policy(ctrl);
+    n_centers = size(pol.c, 1);
+    max_centers = 32;  % from lib/messages/policies.options
+    if n_centers > max_centers
+      error('The robot supports at most %d RBF centers, not %d', max_centers, n_centers);
+    end
+  else
+    pol = yauc_hardware.get_affine_policy(ctrl);
+  end
 
   for u_name = fieldnames(u_name_map)', u_name = u_name{1};
     u_index = u_frame.i.(u_name);
     u_proto_name = u_name_map.(u_name);
 
+    if is_rbf
+      rbf = struct();
+      rbf.k_bias = pol.b(u_index);
+
+      % one LinearPolicy-shaped struct per center, and for the lengthscales
+      centers = repmat(struct('center', struct(), 'weight', 0), n_centers, 1);
+      for p_name = fieldnames(p_name_map)', p_name = p_name{1};
+        p_index = p_frame.i.(p_name);
+        p_proto_name = p_name_map.(p_name);
+
+        rbf.inv_lengthscale.(p_proto_name) = pol.il(u_index, p_index);
+        for i = 1:n_centers
+          centers(i).center.(p_proto_name) = pol.c(i, p_index);
+        end
+      end
+      for i = 1:n_centers
+        centers(i).weight = pol.w(i, u_index);
+      end
+      rbf.centers = centers;
+
+      msg.(u_proto_name).rbf = rbf;
+      continue
+    end
+
     affine = struct();
     affine.k_bias = pol.b(u_index);
 
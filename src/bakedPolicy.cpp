@@ -0,0 +1,57 @@
+/**
+ * The policy functions of policy.h, evaluating a controller that is baked into
+ * the firmware at build time rather than set over serial.
+ *
+ * This replaces policy.cpp when the build_flags contain
+ * -DBAKED_POLICY=<controller>, for which lib/messages/build.py generates
+ * baked_policy.h. Each output is a single constexpr expression, with the
+ * coefficients as constants and the zero terms removed, so there is no
+ * dispatch on the type of policy, no gathering of the state, and no loops.
+ */
+#ifdef BAKED_POLICY
+
+#include <messages.pb.h>
+#include <baked_policy.h>
+
+#include "policy.h"
+
+//! The baked controller cannot be replaced, so new ones are ignored
+void setPolicy(const Controller&)
+{
+}
+
+bool patchPolicy(const PatchPolicy&)
+{
+	return false;
+}
+
+bool storePolicy(const StorePolicy&)
+{
+	return false;
+}
+
+bool selectPolicy(uint32_t)
+{
+	return false;
+}
+
+uint32_t activePolicySlot()
+{
+	return 0;
+}
+
+uint32_t applyPendingPolicy()
+{
+	return 0;
+}
+
+//! compute every output from the baked controller, given the state
+PolicyOutputs computePolicies(const LogEntry& state)
+{
+	PolicyOutputs result;
+	result.wheel = saturate(baked_policy::wheel(state));
+	result.turntable = saturate(baked_policy::turntable(state));
+	return result;
+}
+
+#endif
@@ -28,6 +28,7 @@ using namespace i2c_funcs;
 
 #include "io.h"
 #include "pins.h"
+#include "irq_guard.h"
 
 using namespace geometry;
 
@@ -80,16 +81,19 @@ namespace {
     I2CRead(0xd0, reg, data, length);
   }
 
-  // in internal units, stored as float for extra precision
-  Vector3<float> gyro_offset;
-
-  const Vector3<float> acc_down = Vector3<float>(1.304, 0.038, 10.12).normalized();
+  constexpr Vector3<float> acc_down = Vector3<float>(1.304, 0.038, 10.12).constNormalized();
 }
 
 
 //! Initialize the connection to the accelerometer and gyro
-void gyroAccelSetup()
+namespace {
+  //! The interrupt that reads the sensors through the calibrations below
+  int reader_irq;
+}
+
+void gyroAccelSetup(int irq)
 {
+  reader_irq = irq;
   OpenI2C(i2c, I2C_EN, 0x062); // 400 KHz
 
   gyroWrite(0x3e, 0x80);  // Reset to defaults
@@ -104,45 +108,55 @@ void gyroAccelSetup()
 }
 
 
+// LSB/(deg/s) and (rad/s) / lsb, respectively
+constexpr float LSB_S_PER_DEG = 14.375;  // from datasheet
+constexpr float RAD_PER_LSB_S = (M_PI / 180) / LSB_S_PER_DEG;
+
+constexpr float SI_PER_LSB = 9.82 / 2048.0;  // conversion factor from 13 bit to m/s^2
+
 /**
- * \brief Convert from the chip coordinate frame to the robot frame
+ * \brief The nominal conversion from raw readings in the chip coordinate frame
+ *        to SI units in the robot frame
  *
- * The robot frame has 
+ * The robot frame has
  *    x pointing forwards (the side with the microcontroller)
  *    z pointing left
  *    y pointing up
  */
-template<typename T>
-Vector3<T> chipToRobotFrame(Vector3<T> v_chip) {
-  Vector3<float> v_frame;
-
-  v_frame.x = -v_chip.z;
-  v_frame.y =  v_chip.x;
-  v_frame.z = -v_chip.y;
+constexpr float gyroNominal[3][3] = {
+  {0,             0,              -RAD_PER_LSB_S},
+  {RAD_PER_LSB_S, 0,              0             },
+  {0,             -RAD_PER_LSB_S, 0             }
+};
+constexpr float accNominal[3][3] = {
+  {0,          0,           -SI_PER_LSB},
+  {SI_PER_LSB, 0,           0          },
+  {0,          -SI_PER_LSB, 0          }
+};
 
-  return v_frame;
+namespace {
+  //! The calibration of each sensor, including the gyro offset
+  RawToSI gyroToSI(gyroNominal);
+  RawToSI accToSI(accNominal);
+
+  //! Replace a calibration that the control loop may be reading from its
+  //! interrupt. The fields of a RawToSI only agree with each other once fused,
+  //! so the new one is built elsewhere and copied in with that interrupt off.
+  void swapIn(RawToSI &current, const RawToSI &next) {
+    irq_guard g(reader_irq);
+    current = next;
+  }
 }
 
-/**
- * \brief Convert from the raw chip reading to radians per second, in the robot
- *        frame
- */
-template<typename T>
-Vector3<float> gyroRawToSI(Vector3<T> raw) {
-  // LSB/(deg/s) and (rad/s) / lsb, respectively
-  const float LSB_S_PER_DEG = 14.375;  // from datasheet
-  const float RAD_PER_LSB_S = (M_PI / 180) / LSB_S_PER_DEG;
-  return chipToRobotFrame(raw * RAD_PER_LSB_S);
+void setGyroCorrection(const ImuCorrection &c) {
+  RawToSI next = gyroToSI;
+  next.setCorrection(c);
+  swapIn(gyroToSI, next);
 }
-
-/**
- * \brief Convert from the raw chip reading to meters per second squared, in the
- *        robot frame
- */
-template<typename T>
-Vector3<float> accRawToSI(Vector3<T> raw) {
-  const float SI_PER_LSB = 9.82 / 2048.0;  // conversion factor from 13 bit to m/s^2
-  return chipToRobotFrame(raw * SI_PER_LSB);
+void setAccelCorrection(const ImuCorrection &c) {
+  RawToSI next = accToSI;
+  next.setCorrection(c);
+  swapIn(accToSI, next);
 }
 
 //! Read the raw values of the accelerometer, in internal frame and units
@@ -160,10 +174,13 @@ Vector3<int16_t> accelReadRaw()
 }
 
 //! Get the acceleration in m s^-2, in the robot frame
-Vector3<float> accelRead()
+template<typename R>
+Vector3<R> accelRead()
 {
-  return accRawToSI(accelReadRaw());
+  return accToSI.apply<R>(accelReadRaw());
 }
+template Vector3<float> accelRead();
+template Vector3<q16_16> accelRead();
 
 //! Read the raw values of the gyroscope, without subtracting initial values
 Vector3<int16_t> gyroReadRaw()
@@ -191,9 +208,7 @@ Vector3<float> gyroCalibrate(int N) {
     auto lsb = gyroReadRaw();
 
     sum_lsb += lsb;
-    for (int i = 0; i < 3; i++) {
-      sum_lsb2[i] += lsb[i] * lsb[i];
-    }
+    sum_lsb2 += lsb.cwiseProduct(lsb);
   }
 
   // compute first and second moments
@@ -203,24 +218,28 @@ Vector3<float> gyroCalibrate(int N) {
     std_lsb[i] = sqrt(N*sum_lsb2[i] - sum_lsb[i]*sum_lsb[i]) / N;
   }
 
-  gyro_offset = mean_lsb;
+  RawToSI next = gyroToSI;
+  next.setRawOffset(mean_lsb);
+  swapIn(gyroToSI, next);
   // convert to real units
-  return gyroRawToSI(std_lsb);
+  return next.noiseToSI(std_lsb);
 }
 
 
 //! Get the angular velocity in the robot frame
-Vector3<float> gyroRead()
+template<typename R>
+Vector3<R> gyroRead()
 {
-  // read in the coordinate frame of the sensor chip
-  return gyroRawToSI(gyroReadRaw() - gyro_offset);
+  return gyroToSI.apply<R>(gyroReadRaw());
 }
+template Vector3<float> gyroRead();
+template Vector3<q16_16> gyroRead();
 
 //! Get the robot orientation based on the accelerometer reading. Only accurate
 //! when static
 quat accelOrient(Vector3<float> acc) {
   quat q = quat::between(acc, acc_down);
-  return euler_angles<213>::remove_psi(quat::between(acc, acc_down));
+  return euler_angles<213>::remove_psi(q);
 }
 quat accelOrient() {
   return accelOrient(accelRead());
@@ -6,10 +6,21 @@
 #include <vector3.h>
 #include <quat.h>
 
-void gyroAccelSetup();
+#include "imuCalibration.h"
+
+// irq is the interrupt that reads the sensors, which changes to their
+// calibration are guarded from
+void gyroAccelSetup(int irq);
+
+// These can produce either float or fixed-point (q16_16) results
+template<typename R = float> geometry::Vector3<R> accelRead();
+template<typename R = float> geometry::Vector3<R> gyroRead();
 
-geometry::Vector3<float> accelRead();
 geometry::quat accelOrient(geometry::Vector3<float> acc);
 geometry::quat accelOrient();
-geometry::Vector3<float> gyroRead();
 geometry::Vector3<float> gyroCalibrate(int N = 20);
+
+// Replace the correction applied to each sensor. The control loop sees either
+// the old correction or the new one, never a mix of the two
+void setGyroCorrection(const ImuCorrection &c);
+void setAccelCorrection(const ImuCorrection &c);
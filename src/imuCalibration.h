@@ -0,0 +1,162 @@
+/**
+ * Calibration of the IMU sensors, applied to each raw reading in a single
+ * fused pass.
+ *
+ * This has no hardware dependencies, so that it can be tested on a PC.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <math.h>
+
+#include <vector3.h>
+#include <fixed.h>
+
+/**
+ * A linear correction to one sensor of the IMU, in the robot frame and SI
+ * units. The corrected reading is `matrix * v - bias`, where v is the reading
+ * converted using the datasheet sensitivity.
+ *
+ * The matrix corrects for both axis misalignment and per-axis scale errors.
+ */
+struct ImuCorrection {
+  float matrix[3][3];
+  geometry::Vector3<float> bias;
+
+  //! no correction
+  static ImuCorrection identity() {
+    return ImuCorrection{
+      {{1, 0, 0},
+       {0, 1, 0},
+       {0, 0, 1}},
+      geometry::Vector3<float>::Zero()
+    };
+  }
+};
+
+/**
+ * The affine map from raw readings in the chip frame to SI units in the robot
+ * frame,
+ *
+ *   si = correction * nominal * (raw - raw_offset) - bias
+ *
+ * where nominal is the datasheet sensitivity combined with the rotation from
+ * the chip frame to the robot frame, and raw_offset is the zero-rate offset
+ * found by gyroCalibrate.
+ *
+ * Everything is folded into a 3x3 integer gain matrix and an offset whenever a
+ * parameter changes, so that apply() is a single pass of integer
+ * multiply-accumulates, of 32-bit gains into a 64-bit sum. These are single
+ * MADD instructions on the PIC32, where the separate scale, rotate and offset
+ * passes each cost soft-float calls.
+ *
+ * The gains keep 31 significant bits, so the result is exact to within the
+ * rounding to q16_16.
+ */
+class RawToSI {
+public:
+  explicit RawToSI(const float (&nominal)[3][3])
+    : _correction(ImuCorrection::identity()),
+      _raw_offset(geometry::Vector3<float>::Zero())
+  {
+    for (int i = 0; i < 3; i++)
+      for (int j = 0; j < 3; j++)
+        _nominal[i][j] = nominal[i][j];
+    fuse();
+  }
+
+  void setCorrection(const ImuCorrection &c) {
+    _correction = c;
+    fuse();
+  }
+
+  //! Set the offset to subtract from the raw readings, in LSB
+  void setRawOffset(const geometry::Vector3<float> &raw_offset) {
+    _raw_offset = raw_offset;
+    fuse();
+  }
+
+  //! Convert a raw reading, as either float or q16_16
+  template<typename R>
+  geometry::Vector3<R> apply(const geometry::Vector3<int16_t> &raw) const {
+    geometry::Vector3<geometry::q16_16> si;
+    for (int i = 0; i < 3; i++) {
+      int64_t acc = _offset[i];
+      for (int j = 0; j < 3; j++) {
+        acc += int64_t(_gain[i][j]) * raw[j];
+      }
+      // saturate one side at a time, which compiles to conditional moves
+      // rather than branches
+      int64_t v = acc >> (_shift - 16);
+      v = v < geometry::detail::fixed_min ? geometry::detail::fixed_min : v;
+      v = v > geometry::detail::fixed_max ? geometry::detail::fixed_max : v;
+      si[i] = geometry::q16_16::from_raw(int32_t(v));
+    }
+    return geometry::Vector3<R>(R(si.x), R(si.y), R(si.z));
+  }
+
+  //! The standard deviation in SI units of independent raw noise with stdev std_lsb
+  geometry::Vector3<float> noiseToSI(const geometry::Vector3<float> &std_lsb) const {
+    geometry::Vector3<float> std;
+    for (int i = 0; i < 3; i++) {
+      float var = 0;
+      for (int j = 0; j < 3; j++) {
+        float g = _gain_f[i][j] * std_lsb[j];
+        var += g * g;
+      }
+      std[i] = sqrt(var);
+    }
+    return std;
+  }
+
+private:
+  float _nominal[3][3];
+  ImuCorrection _correction;
+  geometry::Vector3<float> _raw_offset;
+
+  // the folded parameters
+  float _gain_f[3][3];    //!< SI per LSB
+  int32_t _gain[3][3];    //!< SI per LSB, with _shift fractional bits
+  int64_t _offset[3];     //!< -SI, with _shift fractional bits, plus half of the last bit kept
+  int _shift;
+
+  //! the fewest fractional bits, which are those of the result and one to round
+  static constexpr int min_shift = 17;
+  //! the most, which leave the offset and the sum of products room in 64 bits
+  static constexpr int max_shift = 40;
+
+  //! This is done in double precision, as float would lose about 40 bits
+  //! of the product of the gain and a full-scale reading
+  void fuse() {
+    double gain[3][3];
+    double offset[3];
+    double max_gain = 0;
+    for (int i = 0; i < 3; i++) {
+      offset[i] = _correction.bias[i];
+      for (int j = 0; j < 3; j++) {
+        double g = 0;
+        for (int k = 0; k < 3; k++) {
+          g += double(_correction.matrix[i][k]) * _nominal[k][j];
+        }
+        gain[i][j] = g;
+        _gain_f[i][j] = g;
+        offset[i] += g * _raw_offset[j];
+        if (fabs(g) > max_gain) max_gain = fabs(g);
+      }
+    }
+
+    // as many fractional bits as keep every gain within 32 bits
+    _shift = min_shift;
+    while (_shift < max_shift && ldexp(max_gain, _shift + 1) < ldexp(1.0, 31)) {
+      _shift++;
+    }
+
+    for (int i = 0; i < 3; i++) {
+      for (int j = 0; j < 3; j++) {
+        _gain[i][j] = geometry::detail::round_saturate(ldexp(gain[i][j], _shift));
+      }
+      _offset[i] = int64_t(llround(ldexp(-offset[i], _shift)))
+                 + (int64_t(1) << (_shift - 17));
+    }
+  }
+};
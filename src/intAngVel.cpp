@@ -12,37 +12,62 @@
 
 using namespace geometry;
 
+/**
+ * @brief      The vector part of the pure quaternion 0.5*w*dt, which is half
+ *             the rotation caused by applying angular velocity w for time dt
+ */
+Vector3<float> half_rotation(const Vector3<float> &w, float dt) {
+  return w * (dt / 2);
+}
+Vector3<q2_29> half_rotation(const Vector3<q16_16> &w, float dt) {
+  // keep the full precision of w through the multiplication
+  q2_29 half_dt = dt / 2;
+  return Vector3<q2_29>(
+    fixed_mul<29>(w.x, half_dt),
+    fixed_mul<29>(w.y, half_dt),
+    fixed_mul<29>(w.z, half_dt));
+}
+
 /**
  * @brief      Integrate from a starting quaternion, applying an angular
  *             velocity
  *
- * @param[in]  q0    The initial quaternion, q(t)
- * @param[in]  w     The angular velocity
- * @param[in]  dt    The timestep to integrate over
+ * @param[in]  method  The approximation to use
+ * @param[in]  q0      The initial quaternion, q(t)
+ * @param[in]  w       The angular velocity
+ * @param[in]  dt      The timestep to integrate over
  *
  * @return     The quaternion at q(t + dt)
  */
-quat integrate_quat(const quat &q0, const Vector3<float> &w, float dt) {
-  // from integrating $\dot{q} = 0.5 \omega q$
-  return exp(0.5*quat(w)*dt) * q0;
-}
+template<typename Q, typename R>
+basic_quat<Q> integrate_quat(QuatIntegrator method, const basic_quat<Q> &q0,
+                             const Vector3<R> &w, float dt) {
+  // from integrating $\dot{q} = 0.5 \omega q$, which gives exp(h) * q0
+  Vector3<Q> h = half_rotation(w, dt);
 
-quat integrate_quat_fast(const quat &q0, const Vector3<float> &w, float dt) {
-  // as above, approximating `exp(x)` as `1 + x`. This was previously used for
-  // small timesteps
-  return (1 + 0.5*quat(w)*dt) * q0;
-}
+  switch (method) {
+    default:
+    case QuatIntegrator::Exp:
+      return exp(basic_quat<Q>(h)) * q0;
 
-quat integrate_quat_aleksi(const quat &q0, const Vector3<float> &w, float dt) {
-  // This was previously used for a large timesteps. It is not clear where it
-  // came from. It seems to be the above with an extra high-order term
-  quat p(1 + (w[0]*dt/2.0)*(w[1]*dt/2.0)*(w[2]*dt/2.0),
+    case QuatIntegrator::Taylor:
+      return exp_pure(h) * q0;
 
-         (w[0]*dt/2.0) - (w[1]*dt/2.0)*(w[2]*dt/2.0),
-         (w[1]*dt/2.0) + (w[2]*dt/2.0)*(w[0]*dt/2.0),
-         (w[2]*dt/2.0) - (w[0]*dt/2.0)*(w[1]*dt/2.0));
-  return p * q0;
+    case QuatIntegrator::FirstOrder:
+      // approximating `exp(x)` as `1 + x`. This was previously used for
+      // small timesteps
+      return basic_quat<Q>(Q(1), h) * q0;
+
+    case QuatIntegrator::Aleksi:
+      // This was previously used for a large timesteps. It is not clear where
+      // it came from. It seems to be the above with an extra high-order term
+      return basic_quat<Q>(Q(1) + h.x*h.y*h.z,
+                           h.x - h.y*h.z,
+                           h.y + h.z*h.x,
+                           h.z - h.x*h.y) * q0;
+  }
 }
+
 /**
  * Returns a new angle such that:
  *   result === next  mod 2pi
@@ -53,36 +78,37 @@ float unwrap_angle(float next, float last) {
   return last + remainder(next - last, 2*M_PI);
 }
 
-void intAngVel(quat& q,
-               Vector3<float> &w0,
-               const Vector3<float> &w,
-               joint_angles &orient,
-               joint_angles &dorient)
+template<typename Q, typename R>
+void intAngVel(basic_quat<Q>& q,
+               Vector3<R> &w0,
+               const Vector3<R> &w,
+               attitude_cache &att,
+               joint_angles &dorient,
+               QuatIntegrator method)
 {
+  float old_psi = att.angles.psi;
+
+  // extract Euler angles after integrating with mean angular velocity.
   // normalizing is not strictly necessary but numerical error buildup happens
   // otherwise
-  joint_angles old_orient = orient;
+  q = integrate_quat(method, q, Vector3<R>((w + w0) / 2), dt);
+  q.renormalize();
+  att = attitude_cache(q);
 
-  // extract Euler angles after integrating with mean angular velocity
-  q = integrate_quat(q, (w + w0) / 2.0, dt);
-  q.normalize();
-  orient = q;
+  // remove discontinuities in yaw. This leaves its sin and cos unchanged
+  att.angles.psi = unwrap_angle(att.angles.psi, old_psi);
 
-  // remove discontinuities in yaw
-  orient.psi = unwrap_angle(orient.psi, old_orient.psi);
-
-  // extract Euler angles after small timestep
-  float dt_small = dt/10;
-  quat q1 = integrate_quat(q, w, dt_small);
-  q1.normalize();
-
-  // approximate instantaneous Euler velocities
-  joint_angles e1 = q1;
-  e1.psi = unwrap_angle(e1.psi, orient.psi);
-  dorient.phi   = (e1.phi   - orient.phi)/dt_small;
-  dorient.theta = (e1.theta - orient.theta)/dt_small;
-  dorient.psi   = (e1.psi   - orient.psi)/dt_small;
+  // instantaneous Euler velocities, from the current body rates
+  dorient = euler_rates_213(att, w);
 
   // save speeds for next call
   w0 = w;
 }
+
+template void intAngVel(quat&, Vector3<float>&, const Vector3<float>&,
+                        attitude_cache&, joint_angles&, QuatIntegrator);
+template void intAngVel(basic_quat<q2_29>&, Vector3<q16_16>&, const Vector3<q16_16>&,
+                        attitude_cache&, joint_angles&, QuatIntegrator);
+template quat integrate_quat(QuatIntegrator, const quat&, const Vector3<float>&, float);
+template basic_quat<q2_29> integrate_quat(QuatIntegrator, const basic_quat<q2_29>&,
+                                          const Vector3<q16_16>&, float);
@@ -2,6 +2,7 @@
 
 #include <quat.h>
 #include <euler.h>
+#include <attitude.h>
 #include <vector3.h>
 
 /**
@@ -16,10 +17,51 @@
  */
 typedef geometry::euler_angles<213> joint_angles;
 
-void intAngVel(geometry::quat& q,
-               geometry::Vector3<float> &w0,
-               const geometry::Vector3<float> &w,
-               joint_angles &orient,
-               joint_angles &dorient);
+/**
+ * The scalar types used for the attitude. Defining ATTITUDE_FIXED_POINT in the
+ * build_flags switches these to fixed-point, so that the attitude is tracked
+ * without any soft-float arithmetic until the euler angles are produced.
+ */
+#ifdef ATTITUDE_FIXED_POINT
+typedef geometry::q2_29 attitude_scalar;  //!< for the components of q
+typedef geometry::q16_16 rate_scalar;     //!< for angular velocities
+#else
+typedef float attitude_scalar;
+typedef float rate_scalar;
+#endif
+typedef geometry::basic_quat<attitude_scalar> attitude_quat;
+
+/**
+ * Ways of integrating the attitude quaternion over a timestep. These all
+ * approximate exp(0.5 w dt) q0, and are compared by `make -C bench run`
+ */
+enum class QuatIntegrator {
+  Exp,         //!< the exact exponential, using sin and cos
+  Taylor,      //!< a taylor series of exp, accurate to float precision
+  FirstOrder,  //!< exp(x) ~= 1 + x
+  Aleksi       //!< first order, with an extra third-order term
+};
+
+//! Integrate from q0, applying angular velocity w for time dt
+template<typename Q, typename R>
+geometry::basic_quat<Q> integrate_quat(QuatIntegrator method,
+                                       const geometry::basic_quat<Q> &q0,
+                                       const geometry::Vector3<R> &w,
+                                       float dt);
+
+/**
+ * Integrate q over one timestep, and refresh att from it. The yaw in
+ * att.angles is unwrapped to be continuous with its previous value.
+ *
+ * Both the float and fixed-point versions are instantiated, so that they can
+ * be compared
+ */
+template<typename Q, typename R>
+void intAngVel(geometry::basic_quat<Q>& q,
+               geometry::Vector3<R> &w0,
+               const geometry::Vector3<R> &w,
+               geometry::attitude_cache &att,
+               joint_angles &dorient,
+               QuatIntegrator method = QuatIntegrator::Taylor);
 
 extern const float dt;                 // time step in seconds
@@ -16,12 +16,14 @@
 #include <messaging.h>
 #include <quat.h>
 #include <euler.h>
+#include <attitude.h>
 #include <vector3.h>
 
 // Local includes
 #include "io.h"
 #include "pins.h"
 #include "policy.h"
+#include "prediction.h"
 #include "intAngVel.h"
 #include "gyroAccel.h"
 #include "motors.h"
@@ -31,8 +33,7 @@
 #include "timer.h"
 #include "irq_guard.h"
 
-// Kinematic properties
-const float WHEEL_CIRC = 0.222;       // circumference of the unicycle wheel (measured)
+// Kinematic properties, along with WHEEL_CIRC and W_RADIUS in prediction.h
 const float BELT_RATIO = 40/16;      // rotor rotations per wheel rotation
 const float GEARBOX_RATIO = 225/16;  // motor rotations per rotor rotation
 const float ENCODER_CPR = 512;       // counts per motor revolution
@@ -40,11 +41,11 @@ const float ENCODER_CPR = 512;       // counts per motor revolution
 // counts per radian for the turntable and wheel
 const float TT_CPRAD = ENCODER_CPR * GEARBOX_RATIO / (2*M_PI);
 const float W_CPRAD = ENCODER_CPR * GEARBOX_RATIO * BELT_RATIO / (2*M_PI);
-const float W_RADIUS = WHEEL_CIRC / (2 * M_PI);
 
 // control loop properties
 const float dt = 50e-3;                  // time step in seconds
 const float SPEED_MEASURE_WINDOW = 5e-3; // size of the window used to measure speed
+const float CORE_TIMER_PERIOD = 2.0 / F_CPU; // the core timer ticks at half the CPU clock
 
 enum class LoopPhase {
   PRE,
@@ -56,6 +57,7 @@ enum class Mode {
   CHANGING,
   IDLE,
   CONTINUOUS,
+  STREAM,
   BULK,
   MANUAL
 };
@@ -72,9 +74,26 @@ struct {
   bool run_complete_main = false; //!< true once the main thread has seen the run complete
 } bulk;
 
-// for continuous recording
+// for streamed recording, where bulk.logs is a ring buffer that the control
+// loop writes each entry into, and the main thread sends them from. Entries
+// are dropped if the link falls so far behind that it fills.
+struct {
+  size_t n = 0;                  //!< total number of steps to run, or 0 to run until stopped
+  size_t i = 0;                  //!< current step number, counting dropped entries
+  volatile uint32_t head = 0;    //!< entries written by the control loop
+  volatile uint32_t tail = 0;    //!< entries sent by the main thread
+  uint32_t next_tick = 0;        //!< the tick of the next entry the main thread expects
+  uint32_t dropped = 0;          //!< entries reported as dropped so far
+  volatile bool run_complete = false; //!< true after a run is complete
+  bool end_sent = false;         //!< true once the main thread has sent the StreamEnd
+} stream;
+
+// how the entries of the current run are sent, as chosen by its Go
+LogEncoding log_encoding = LogEncoding_FULL_LOG;
+
+// for entries that are not recorded, of which continuous runs send the latest
 LogEntry singleLog;
-bool singleLogPending = false;
+volatile bool singleLogPending = false;
 
 // where to save the current data
 LogEntry* currLog = &singleLog;
@@ -82,6 +101,13 @@ LogEntry* currLog = &singleLog;
 // Type A timer
 CallbackTimer ctrl_tmr = io::tmr1;
 
+// the policy in effect, which is kept apart from StateTracker so that a Go
+// does not reset it
+struct {
+  uint32_t version = 0;   //!< as returned by applyPendingPolicy
+  uint32_t tick = 0;      //!< the tick of the run on which version took effect
+} policy_change;
+
 //! handles computing the overall state
 struct StateTracker {
   wrapping<uint16_t> oldAngleTT = 0;  // old value of angle for turntable
@@ -94,10 +120,16 @@ struct StateTracker {
   float x_pos = 0;
   float y_pos = 0;
 
-  geometry::quat q = geometry::quat(1, 0, 0, 0);      // identity quaternion with no rotation
-  geometry::Vector3<float> w0 = geometry::Vector3<float>::Zero(); // keeping track of the velocity
+  attitude_quat q = attitude_quat(1, 0, 0, 0);      // identity quaternion with no rotation
+  geometry::Vector3<rate_scalar> w0 = geometry::Vector3<rate_scalar>::Zero(); // keeping track of the velocity
+
+  // everything derived from q, refreshed by intAngVel each tick
+  geometry::attitude_cache att = geometry::attitude_cache(q);
+
+  uint32_t tick = 0;            // ticks since the last reset
 
-  joint_angles orient = joint_angles(0, 0, 0);
+  uint32_t sample_count = 0;    // core timer count when the sensors were read
+  float latency = 0;            // [s] from reading the sensors to writing the motors, on the last tick
 
   void pre_update() {
     intAngleTT = getTTangle();
@@ -105,15 +137,27 @@ struct StateTracker {
   }
 
   void update(LogEntry& l) {
+    // switch to a new policy only at the start of a tick
+    uint32_t version = applyPendingPolicy();
+    if (version != policy_change.version) {
+      policy_change.version = version;
+      policy_change.tick = tick;
+    }
+    l.tick = tick++;
+    l.policy_version = version;
+    l.policy_slot = activePolicySlot();
+
     // read the gyro
-    geometry::Vector3<float> w = gyroRead();
+    sample_count = _CP0_GET_COUNT();
+    geometry::Vector3<rate_scalar> w = gyroRead<rate_scalar>();
 
     // read the accelerometer [m/s^2]
-    geometry::Vector3<float> acc = accelRead();
+    geometry::Vector3<rate_scalar> acc = accelRead<rate_scalar>();
 
     // compute euler angles and their derivatives
     joint_angles d_orient;
-    intAngVel(q, w0, w, orient, d_orient);
+    intAngVel(q, w0, w, att, d_orient);
+    const joint_angles &orient = att.angles;
 
     // Turntable angle
     wrapping<uint16_t> newAngleTT = getTTangle();
@@ -131,10 +175,10 @@ struct StateTracker {
 
     // Try the distance calculations (some drift due to yaw (psi))
     float dist = W_RADIUS * (deltaAngleW + d_orient.phi*dt);
-    x_pos += dist*cos(orient.psi);
-    y_pos += dist*sin(orient.psi);
-    float xOrigin =  cos(orient.psi)*-x_pos + sin(orient.psi)*-y_pos;
-    float yOrigin = -sin(orient.psi)*-x_pos + cos(orient.psi)*-y_pos;
+    x_pos += dist*att.psi.cos;
+    y_pos += dist*att.psi.sin;
+    float xOrigin =  att.psi.cos*-x_pos + att.psi.sin*-y_pos;
+    float yOrigin = -att.psi.sin*-x_pos + att.psi.cos*-y_pos;
 
     // Data recording starts here!
     l.droll  = d_orient.theta; // roll angular velocity
@@ -157,19 +201,45 @@ struct StateTracker {
     l.y = y_pos;               // y position
     l.AngleW  = AngleW + orient.phi; // wheel angle
     l.AngleTT = AngleTT;       // turn table angle
-    l.TurntableInput = policyTurntable(l); // control torque for turntable
-    l.WheelInput = policyWheel(l); // control torque for wheel
+
+    // the motors are written some time after the sensors were read, so act on
+    // the state at that time, assuming the latency is the same as last tick
+    l.lead = latency;
+    LogEntry predicted = l;
+    predictState(predicted, latency);
+    PolicyOutputs u = computePolicies(predicted);
+    l.TurntableInput = u.turntable; // control torque for turntable
+    l.WheelInput = u.wheel;         // control torque for wheel
     //-0.2+((float)rand()/(float)(RAND_MAX))*0.2;
 
     // We may need the accelerations for calibrating the start measurements
-    l.ddx = acc.x;
-    l.ddy = acc.y;
-    l.ddz = acc.z;
+    l.ddx = float(acc.x);
+    l.ddy = float(acc.y);
+    l.ddz = float(acc.z);
+  }
+
+  //! record the latency of this tick, once the motors have been written
+  void actuated(LogEntry& l) {
+    latency = (_CP0_GET_COUNT() - sample_count) * CORE_TIMER_PERIOD;
+    l.latency = latency;
   }
 };
 
 StateTracker state_tracker;
 
+#ifdef PROFILE_UPDATE
+// CPU cycles spent in StateTracker::update, reported when stopped. The core
+// timer ticks at half the CPU clock.
+struct {
+  uint32_t last = 0;
+  uint32_t max = 0;
+  void record(uint32_t ticks) {
+    last = 2 * ticks;
+    if (last > max) max = last;
+  }
+} update_cycles;
+#endif
+
 // Interrupt handlers begin
 
 void __attribute__((interrupt)) mainLoop(void) {
@@ -193,6 +263,7 @@ void __attribute__((interrupt)) mainLoop(void) {
 
     // choose where to store data
     currLog = &singleLog;
+    bool streamed = false;
     if(mode == Mode::BULK) {
       if(bulk.i < bulk.n) {
         currLog = &(bulk.logs[bulk.i++]);
@@ -203,10 +274,31 @@ void __attribute__((interrupt)) mainLoop(void) {
         bulk.run_complete = true;
       }
     }
+    else if(mode == Mode::STREAM) {
+      if(stream.n == 0 || stream.i < stream.n) {
+        stream.i++;
+        // if the ring is full, the entry is dropped
+        if(stream.head - stream.tail < uint32_t(H_max)) {
+          currLog = &(bulk.logs[stream.head % H_max]);
+          streamed = true;
+        }
+      }
+      else {
+        mode = Mode::IDLE;
+        digitalWrite(pins::LED, LOW);
+        stream.run_complete = true;
+      }
+    }
+#ifdef PROFILE_UPDATE
+    uint32_t t0 = _CP0_GET_COUNT();
+    state_tracker.update(*currLog);
+    update_cycles.record(_CP0_GET_COUNT() - t0);
+#else
     state_tracker.update(*currLog);
+#endif
 
     // update the motor outputs
-    if (mode == Mode::CONTINUOUS || mode == Mode::BULK) {
+    if (mode == Mode::CONTINUOUS || mode == Mode::STREAM || mode == Mode::BULK) {
       setMotorTurntable(currLog->TurntableInput);
       setMotorWheel(currLog->WheelInput);
     }
@@ -214,10 +306,16 @@ void __attribute__((interrupt)) mainLoop(void) {
       setMotorTurntable(0);
       setMotorWheel(0);
     }
+    state_tracker.actuated(*currLog);
 
-    // instruct the main thread to send a message
-    if(currLog == &singleLog)
+    // pass the complete entry on to the main thread to send
+    if(streamed) {
+      __sync_synchronize();
+      stream.head = stream.head + 1;
+    }
+    else if(mode == Mode::CONTINUOUS) {
       singleLogPending = true;
+    }
   }
 }
 
@@ -253,6 +351,11 @@ void request_stop() {
     if (mode == Mode::BULK) {
       bulk.n = bulk.i;
     }
+    else if (mode == Mode::STREAM) {
+      // the entries already recorded are still sent
+      mode = Mode::IDLE;
+      stream.run_complete = true;
+    }
     else {
       mode = Mode::IDLE;
     }
@@ -274,12 +377,63 @@ void do_gyro_calibrate() {
   }
 }
 
+/**
+ * Send the next entry of a streamed run, if the control loop has recorded one,
+ * reporting any dropped before it. Once the run is complete and every entry
+ * sent, this reports the end of the run.
+ */
+void sendStreamed() {
+  // once complete, the control loop writes no more entries
+  bool complete = stream.run_complete;
+  if(stream.tail != stream.head) {
+    const LogEntry& l = bulk.logs[stream.tail % H_max];
+    if(l.tick != stream.next_tick) {
+      sendLogGap(stream.next_tick, l.tick - stream.next_tick);
+      stream.dropped += l.tick - stream.next_tick;
+    }
+    if(log_encoding == LogEncoding_COMPACT_LOG) sendCompactLog(l);
+    else sendLog(l);
+    stream.next_tick = l.tick + 1;
+
+    // let the control loop reuse the entry
+    __sync_synchronize();
+    stream.tail = stream.tail + 1;
+  }
+  else if(complete && !stream.end_sent) {
+    // entries dropped at the end of the run are not followed by any sent
+    uint32_t ticks = stream.i;
+    if(stream.next_tick < ticks) {
+      sendLogGap(stream.next_tick, ticks - stream.next_tick);
+      stream.dropped += ticks - stream.next_tick;
+    }
+    sendStreamEnd(ticks, stream.dropped);
+    stream.end_sent = true;
+    logging::info("Test completed");
+  }
+}
+
+/**
+ * Send the latest entry of a continuous run, if the control loop has recorded
+ * one since the last was sent. Any recorded in between are not sent at all.
+ */
+void sendLatest() {
+  LogEntry l;
+  {
+    irq_guard g(ctrl_tmr.irq);
+    if(!singleLogPending) return;
+    l = singleLog;
+    singleLogPending = false;
+  }
+  if(log_encoding == LogEncoding_COMPACT_LOG) sendCompactLog(l);
+  else sendLog(l);
+}
+
 // set up the message handlers
 auto on_go = [](const Go& go) {
   // default to the maximum number of steps
   ssize_t n = go.steps;
   if(n == 0) n = H_max;
-  if(n > H_max) {
+  if(n > H_max && !go.stream) {
     char msg[256];
     snprintf(msg, sizeof(msg),
       "Not enough memory allocated for %d steps - using %d instead",
@@ -289,9 +443,24 @@ auto on_go = [](const Go& go) {
     n = H_max;
   }
 
+  // choose the fields of the entries sent while running
+  if(!selectLogFields(go.log_fields, go.log_rates, go.log_rates_count)) {
+    logging::error("A log rate was given for a field that LogEntry does not have");
+    return;
+  }
+
+  // switch to a stored policy, which takes effect on the first tick
+  if(go.policy_slot != 0 && !selectPolicy(go.policy_slot)) {
+    char msg[80];
+    snprintf(msg, sizeof(msg), "No policy is stored in slot %lu", (unsigned long) go.policy_slot);
+    logging::error(msg);
+    return;
+  }
+
   // lock the background loop so we can change mode
   ctrl_tmr.stop();
   mode = Mode::CHANGING;
+  log_encoding = go.log_encoding;
 
   // reset the state
   state_tracker = StateTracker();
@@ -302,11 +471,25 @@ auto on_go = [](const Go& go) {
   Mode target;
   bulk.i = 0;
   bulk.run_complete = false;
-  if(n < 0) {
+  singleLogPending = false;
+  if(n < 0 && !go.stream) {
     bulk.n = 0;
     target = Mode::CONTINUOUS;
     logging::info("Request for continuous mode");
   }
+  else if(go.stream) {
+    bulk.n = 0;
+    stream.n = n < 0 ? 0 : n;
+    stream.i = 0;
+    stream.head = 0;
+    stream.tail = 0;
+    stream.next_tick = 0;
+    stream.dropped = 0;
+    stream.run_complete = false;
+    stream.end_sent = false;
+    target = Mode::STREAM;
+    logging::info("Request for streaming mode");
+  }
   else {
     bulk.n = n;
     target = Mode::BULK;
@@ -333,7 +516,7 @@ auto on_go = [](const Go& go) {
   // enter the new mode, and begin
   mode = target;
   resetEncoders();
-  state_tracker.q = accelOrient();
+  state_tracker.q = attitude_quat(accelOrient());
   ctrl_tmr.start();
 
   digitalWrite(pins::LED, HIGH);
@@ -341,11 +524,18 @@ auto on_go = [](const Go& go) {
 auto on_stop = [](const Stop& stop) {
   request_stop();
   logging::info("Stopped by remote command!");
+#ifdef PROFILE_UPDATE
+  char msg[80];
+  snprintf(msg, sizeof(msg), "StateTracker::update: %lu cycles, max %lu",
+    (unsigned long) update_cycles.last, (unsigned long) update_cycles.max);
+  logging::info(msg);
+#endif
 };
 auto on_get_logs = [](const GetLogs& getLogs) {
   if(bulk.run_complete) {
     logging::info("Sending test data");
-    sendLogBundle(bulk.logs, bulk.n);
+    if(log_encoding == LogEncoding_COMPACT_LOG) sendCompactLogBundle(bulk.logs, bulk.n);
+    else sendLogBundle(bulk.logs, bulk.n);
   }
   else {
     logging::info("No data yet");
@@ -362,8 +552,8 @@ auto on_get_acc = [](const GetAccelerometer& msg) {
     auto acc = accelRead();
     auto acc_unit = acc.normalized();
 
-    geometry::quat q = accelOrient(acc);
-    joint_angles j = q;
+    geometry::attitude_cache att(accelOrient(acc));
+    const joint_angles &j = att.angles;
 
     char msg[512];
     snprintf(msg, sizeof(msg),
@@ -383,6 +573,64 @@ auto on_set_motors = [](const SetMotors& msg) {
   }
 };
 
+//! Convert a calibration message, where an all-zero matrix means the identity
+ImuCorrection toImuCorrection(const SensorCalibration& msg) {
+  ImuCorrection c = ImuCorrection::identity();
+  const Vec3* rows[3] = {&msg.m_x, &msg.m_y, &msg.m_z};
+  bool zero = true;
+  for (int i = 0; i < 3; i++) {
+    zero = zero && rows[i]->x == 0 && rows[i]->y == 0 && rows[i]->z == 0;
+  }
+  if (!zero) {
+    for (int i = 0; i < 3; i++) {
+      c.matrix[i][0] = rows[i]->x;
+      c.matrix[i][1] = rows[i]->y;
+      c.matrix[i][2] = rows[i]->z;
+    }
+  }
+  c.bias = geometry::Vector3<float>(msg.bias.x, msg.bias.y, msg.bias.z);
+  return c;
+}
+auto on_set_imu_calibration = [](const SetImuCalibration& msg) {
+  if (mode == Mode::IDLE) {
+    setGyroCorrection(toImuCorrection(msg.gyro));
+    setAccelCorrection(toImuCorrection(msg.accel));
+    logging::info("IMU calibration updated");
+  }
+  else {
+    logging::warn("The IMU calibration can only be changed when idle");
+  }
+};
+#ifdef BAKED_POLICY
+auto on_baked_policy = [](const Controller& msg) {
+  logging::warn("This build has a baked-in policy, so ignores new ones");
+};
+#endif
+auto on_patch_policy = [](const PatchPolicy& msg) {
+#ifdef BAKED_POLICY
+  logging::warn("This build has a baked-in policy, so ignores new ones");
+#else
+  if(!patchPolicy(msg)) {
+    logging::error("The patch does not match the current policy, so was ignored");
+  }
+#endif
+};
+auto on_store_policy = [](const StorePolicy& msg) {
+#ifdef BAKED_POLICY
+  logging::warn("This build has a baked-in policy, so ignores new ones");
+#else
+  char text[80];
+  if(storePolicy(msg)) {
+    snprintf(text, sizeof(text), "Stored a policy in slot %lu", (unsigned long) msg.slot);
+    logging::info(text);
+  }
+  else {
+    snprintf(text, sizeof(text), "There is no policy slot %lu, or no room in the bank", (unsigned long) msg.slot);
+    logging::error(text);
+  }
+#endif
+};
+
 // main function to setup the test
 void setup() {
   setupMessaging();
@@ -390,11 +638,18 @@ void setup() {
 
   onMessage<Go>(&on_go);
   onMessage<Stop>(&on_stop);
+#ifdef BAKED_POLICY
+  onMessage<Controller>(&on_baked_policy);
+#else
   onMessage<Controller>(setPolicy);
+#endif
   onMessage<GetLogs>(&on_get_logs);
   onMessage<CalibrateGyro>(&on_calibrate);
   onMessage<GetAccelerometer>(&on_get_acc);
   onMessage<SetMotors>(&on_set_motors);
+  onMessage<SetImuCalibration>(&on_set_imu_calibration);
+  onMessage<StorePolicy>(&on_store_policy);
+  onMessage<PatchPolicy>(&on_patch_policy);
 
   pinMode(pins::LED, OUTPUT);
   digitalWrite(pins::LED, LOW);
@@ -409,7 +664,7 @@ void setup() {
   setMotorWheel(0);
 
   logging::info("Starting I2C setup");
-  gyroAccelSetup();
+  gyroAccelSetup(ctrl_tmr.irq);
 
   logging::info("Starting encoder setup");
   setupEncoders();
@@ -438,10 +693,8 @@ void loop() {
   updateMessaging();
 
   // this can't be sent in an interrupt handler
-  if(singleLogPending && mode == Mode::CONTINUOUS) {
-    sendLog(singleLog);
-    singleLogPending = false;
-  }
+  if(mode == Mode::CONTINUOUS) sendLatest();
+  sendStreamed();
 
   // log that the test was complete
   if(bulk.run_complete && !bulk.run_complete_main) {
@@ -449,6 +702,23 @@ void loop() {
   }
   bulk.run_complete_main = bulk.run_complete;
 
+  // report when a new policy takes effect, which is only when
+  // applyPendingPolicy has switched to it
+  static uint32_t reported_policy_version = 0;
+  uint32_t policy_version, policy_tick;
+  {
+    irq_guard g(ctrl_tmr.irq);
+    policy_version = policy_change.version;
+    policy_tick = policy_change.tick;
+  }
+  if (policy_version != reported_policy_version) {
+    char msg[80];
+    snprintf(msg, sizeof(msg), "Policy %lu took effect on tick %lu",
+      (unsigned long) policy_version, (unsigned long) policy_tick);
+    logging::info(msg);
+    reported_policy_version = policy_version;
+  }
+
   // allow e-stop
   if (mode != Mode::IDLE && button::isPressed()) {
     request_stop();
@@ -1,112 +1,1029 @@
 /**
  * This file implements computing policies.
  *
- * The actual parameters used in the policy can be reconfigured with setPolicy
+ * The actual parameters used in the policy can be reconfigured with setPolicy,
+ * which compiles them into a flat layout that is quick to evaluate each tick.
+ * storePolicy instead compiles them into a bank of slots, so that selectPolicy
+ * can later switch between them without sending them again, and patchPolicy
+ * changes a few coefficients of the last policy set.
+ *
+ * Defining POLICY_FIXED_POINT in the build_flags compiles affine, quadratic
+ * and sparse policies into fixed point instead, so that they are evaluated
+ * with integer multiply-accumulates rather than soft-float calls.
+ *
+ * Defining BAKED_POLICY replaces all of this but saturate() with
+ * bakedPolicy.cpp, which evaluates a controller fixed at build time.
  */
 
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+#include "policy.h"
+
+float saturate(float p){
+	// TODO: implement the same saturation as in simulation
+	if (p > 1) {
+		return 1;
+	}
+	else if (p < -1) {
+		return -1;
+	}
+	else {
+		return p;
+	}
+}
+
+#ifndef BAKED_POLICY
+
 #include <messages.pb.h>   // for LogEntry, LinearPolicy, Controller
+#include <trig.h>           // for fast::exp_neg
+#ifdef POLICY_FIXED_POINT
+#include <fixed.h>          // for detail::ldexp_round and friends
+#endif
 
 // internal functions in an anonymous namespace
 namespace {
+	//! A state at the edge of its declared range is 2^state_bits in fixed point
+	const int state_bits = 23;
+
+	//! The smallest e with range <= 2^e
+	constexpr int rangeExponent(float range, int e = -16) {
+		return e >= 16 || range <= (e >= 0 ? float(int32_t(1) << e) : 1 / float(int32_t(1) << -e))
+			? e : rangeExponent(range, e + 1);
+	}
+
 	//! pointers to the fields that our controller takes as input
 	struct field_pair {
 		float LogEntry::* state;
 		float LinearPolicy::* lin_field;
 		LinearPolicy PureQuadraticPolicy::* quad_field;
-		operator bool() const {
-			return state != nullptr || lin_field != nullptr || quad_field != nullptr;
-		}
+		int8_t range_exp;   //!< the state is expected within +/-2^range_exp
+		int8_t shift;       //!< the state in fixed point is state * 2^shift
+
+		constexpr field_pair(float LogEntry::* state, float LinearPolicy::* lin_field,
+		                     LinearPolicy PureQuadraticPolicy::* quad_field, float range)
+			: state(state), lin_field(lin_field), quad_field(quad_field),
+			  range_exp(rangeExponent(range)), shift(state_bits - rangeExponent(range)) {}
 	};
 
-	//! List of state fields and their corresponding controller field
-	//! Null-terminated
+	/**
+	 * List of state fields and their corresponding controller field, with the
+	 * largest magnitude expected of each. The rates are limited by the gyro's
+	 * +/-2000 deg/s, and the angles to +/-pi.
+	 */
 	const field_pair fields[] = {
-		{&LogEntry::droll,    &LinearPolicy::k_droll,    &PureQuadraticPolicy::k_droll},
-		{&LogEntry::dyaw,     &LinearPolicy::k_dyaw,     &PureQuadraticPolicy::k_dyaw},
-		{&LogEntry::dAngleW,  &LinearPolicy::k_dAngleW,  &PureQuadraticPolicy::k_dAngleW},
-		{&LogEntry::dpitch,   &LinearPolicy::k_dpitch,   &PureQuadraticPolicy::k_dpitch},
-		{&LogEntry::dAngleTT, &LinearPolicy::k_dAngleTT, &PureQuadraticPolicy::k_dAngleTT},
-		{&LogEntry::xOrigin,  &LinearPolicy::k_xOrigin,  &PureQuadraticPolicy::k_xOrigin},
-		{&LogEntry::yOrigin,  &LinearPolicy::k_yOrigin,  &PureQuadraticPolicy::k_yOrigin},
-		{&LogEntry::roll,     &LinearPolicy::k_roll,     &PureQuadraticPolicy::k_roll},
-		{&LogEntry::yaw,      &LinearPolicy::k_yaw,      &PureQuadraticPolicy::k_yaw},
-		{&LogEntry::pitch,    &LinearPolicy::k_pitch,    &PureQuadraticPolicy::k_pitch},
-		{nullptr, nullptr, nullptr}
+		{&LogEntry::droll,    &LinearPolicy::k_droll,    &PureQuadraticPolicy::k_droll,    35},   // rad/s
+		{&LogEntry::dyaw,     &LinearPolicy::k_dyaw,     &PureQuadraticPolicy::k_dyaw,     35},   // rad/s
+		{&LogEntry::dAngleW,  &LinearPolicy::k_dAngleW,  &PureQuadraticPolicy::k_dAngleW,  100},  // rad/s
+		{&LogEntry::dpitch,   &LinearPolicy::k_dpitch,   &PureQuadraticPolicy::k_dpitch,   35},   // rad/s
+		{&LogEntry::dAngleTT, &LinearPolicy::k_dAngleTT, &PureQuadraticPolicy::k_dAngleTT, 100},  // rad/s
+		{&LogEntry::xOrigin,  &LinearPolicy::k_xOrigin,  &PureQuadraticPolicy::k_xOrigin,  10},   // m
+		{&LogEntry::yOrigin,  &LinearPolicy::k_yOrigin,  &PureQuadraticPolicy::k_yOrigin,  10},   // m
+		{&LogEntry::roll,     &LinearPolicy::k_roll,     &PureQuadraticPolicy::k_roll,     M_PI}, // rad
+		{&LogEntry::yaw,      &LinearPolicy::k_yaw,      &PureQuadraticPolicy::k_yaw,      M_PI}, // rad
+		{&LogEntry::pitch,    &LinearPolicy::k_pitch,    &PureQuadraticPolicy::k_pitch,    M_PI}, // rad
+	};
+
+	//! The number of state fields that the policies take as input
+	const size_t n_states = sizeof(fields) / sizeof(fields[0]);
+
+	//! The number of coefficients in the upper triangle of the quadratic term
+	const size_t n_quad = n_states * (n_states + 1) / 2;
+
+	//! The maximum number of grid points in a GainScheduledPolicy
+	const size_t n_schedule = sizeof(GainScheduledPolicy::gains) / sizeof(AffinePolicy);
+
+	//! An affine policy in the order of fields, with the bias first
+	typedef float CompiledAffine[n_states + 1];
+
+	/**
+	 * A gain-scheduled policy, as affine policies on a grid of roll and pitch.
+	 *
+	 * The grid position of a state is (x[i_roll] - roll_min) * roll_scale, and
+	 * likewise for pitch. The strides step from a grid point to its neighbours
+	 * in gains, and are zero along an axis with a single point, so that
+	 * evaluation never needs to special-case the size of the grid.
+	 */
+	struct CompiledSchedule {
+		float roll_min, roll_scale;
+		float pitch_min, pitch_scale;
+		uint8_t i_roll, i_pitch;
+		uint8_t n_roll, n_pitch;
+		uint8_t roll_stride, pitch_stride;
+		CompiledAffine gains[n_schedule];
+	};
+
+	//! The maximum number of centers in an RbfPolicy
+	const size_t n_rbf = sizeof(RbfPolicy::centers) / sizeof(RbfCenter);
+
+	/**
+	 * An RBF policy, with the lengthscales folded into the centers.
+	 *
+	 * Only the n_dims states with a nonzero inverse lengthscale are used,
+	 * which are x[dims[k]] * scale[k]. The scales include the factor of 1/2 in
+	 * the exponent, so that each center needs only a sum of squares and an
+	 * exp_neg. The centers come last, so that the bank need only store the
+	 * first n_centers of them.
+	 */
+	struct CompiledRbf {
+		uint8_t n_dims, n_centers;
+		uint8_t dims[n_states];
+		float scale[n_states];
+		float weights[n_rbf];
+		float centers[n_rbf][n_states];
+	};
+
+	static_assert(n_states <= 32 && n_quad <= 64,
+		"SparsePolicy has a bit per term in lin_mask and quad_mask");
+
+	/**
+	 * A sparse policy, in the same row form as CompiledPolicy but skipping
+	 * the zero terms. Only the n_rows rows with a term are stored, where row r
+	 * is
+	 *
+	 *   x[rows[r]] * (lin[r] + \sum_t coeffs[t] x[cols[t]])
+	 *
+	 * for t from the end of the previous row up to row_ends[r].
+	 */
+	template<typename Coeff>
+	struct SparseRows {
+		uint8_t n_rows;
+		uint8_t rows[n_states];
+		uint8_t row_ends[n_states];
+		Coeff lin[n_states];
+		uint8_t cols[n_quad];
+		Coeff coeffs[n_quad];
+	};
+
+	typedef SparseRows<float> CompiledSparse;
+
+#ifdef POLICY_FIXED_POINT
+	//! States are clamped to 16 times their declared range
+	const int32_t state_limit = int32_t(1) << (state_bits + 4);
+
+	/**
+	 * An affine, quadratic or sparse policy in fixed point, as sparse rows
+	 * with int32 coefficients. Each is scaled by 2^range_exp of the states it
+	 * multiplies, so that in terms of the scaled states every coefficient has
+	 * coeff_bits fractional bits, and every product has out_bits.
+	 *
+	 * coeff_bits is chosen so that the largest coefficient is below
+	 * 2^state_bits. With the states clamped to state_limit, no row can then
+	 * overflow an int32, nor the sum of the products an int64.
+	 */
+	struct FixedPolicy {
+		int64_t bias;         //!< with out_bits fractional bits
+		int8_t out_bits;      //!< coeff_bits + state_bits
+		SparseRows<int32_t> terms;
+	};
+#endif
+
+	//! How a compiled policy is evaluated
+	enum class PolicyKind : uint8_t {
+		Affine,      //!< bias and lin only
+		Quadratic,   //!< bias, lin and quad
+		Scheduled,   //!< schedule only
+		Rbf,         //!< bias and rbf
+		Sparse,      //!< bias and sparse
+#ifdef POLICY_FIXED_POINT
+		Fixed,       //!< fixed only, for affine, quadratic and sparse policies
+#endif
+	};
+
+	/**
+	 * A policy compiled into a flat layout. Affine and quadratic policies are
+	 * evaluated as
+	 *
+	 *   u = bias + \sum_i x_i (lin_i + \sum_{j >= i} quad_ij x_j)
+	 *
+	 * where x is the state gathered in the order of fields. quad holds the
+	 * upper triangle of Q + Q^T, row by row, with the diagonal of Q on its
+	 * diagonal, so that each product x_i x_j is only needed once.
+	 *
+	 * Linear and affine policies skip the quadratic term entirely. The other
+	 * types share its storage.
+	 */
+	struct CompiledPolicy {
+		PolicyKind kind;
+		float bias;
+		float lin[n_states];
+		union {
+			float quad[n_quad];
+			CompiledSchedule schedule;
+			CompiledRbf rbf;
+			CompiledSparse sparse;
+#ifdef POLICY_FIXED_POINT
+			FixedPolicy fixed;
+#endif
+		};
+	};
+
+	//! Copy the coefficients of a linear policy into the order of fields
+	void compileLinear(const LinearPolicy& policy, float lin[n_states]) {
+		for(size_t i = 0; i < n_states; i++) {
+			lin[i] = policy.*(fields[i].lin_field);
+		}
+	}
+
+	//! Fold a quadratic policy into the upper triangle of Q + Q^T
+	void compileQuadratic(const PureQuadraticPolicy& policy, float quad[n_quad]) {
+		float* q = quad;
+		for(size_t i = 0; i < n_states; i++) {
+			const LinearPolicy& row = policy.*(fields[i].quad_field);
+			*q++ = row.*(fields[i].lin_field);
+			for(size_t j = i + 1; j < n_states; j++) {
+				const LinearPolicy& col = policy.*(fields[j].quad_field);
+				*q++ = row.*(fields[j].lin_field) + col.*(fields[i].lin_field);
+			}
+		}
+	}
+
+	//! The index in fields of a state
+	size_t fieldIndex(float LogEntry::* state) {
+		size_t i = 0;
+		while(i < n_states && fields[i].state != state) i++;
+		return i;
+	}
+
+	/**
+	 * Compile one axis of the schedule grid. Returns false if the axis has no
+	 * points, or a step that cannot be inverted
+	 */
+	bool compileAxis(uint32_t n, float step, uint8_t& n_out, float& scale) {
+		if (n == 0 || n > n_schedule) return false;
+		n_out = n;
+		if (n == 1) {
+			scale = 0;
+			return true;
+		}
+		if (!(step > 0)) return false;
+		scale = 1 / step;
+		return true;
+	}
+
+	/**
+	 * Compile a gain-scheduled policy. Returns false if the grid does not
+	 * match the number of gains
+	 */
+	bool compileScheduled(const GainScheduledPolicy& policy, CompiledSchedule& s) {
+		if (!compileAxis(policy.n_roll, policy.roll_step, s.n_roll, s.roll_scale)) return false;
+		if (!compileAxis(policy.n_pitch, policy.pitch_step, s.n_pitch, s.pitch_scale)) return false;
+		if (size_t(s.n_roll) * s.n_pitch != policy.gains_count) return false;
+		if (policy.gains_count > n_schedule) return false;
+
+		s.roll_min = policy.roll_min;
+		s.pitch_min = policy.pitch_min;
+		s.i_roll = fieldIndex(&LogEntry::roll);
+		s.i_pitch = fieldIndex(&LogEntry::pitch);
+		s.roll_stride = s.n_roll > 1 ? s.n_pitch : 0;
+		s.pitch_stride = s.n_pitch > 1 ? 1 : 0;
+		for(size_t k = 0; k < policy.gains_count; k++) {
+			s.gains[k][0] = policy.gains[k].k_bias;
+			compileLinear(policy.gains[k].k_lin, &s.gains[k][1]);
+		}
+		return true;
+	}
+
+	//! Compile an RBF policy, scaling the centers by the inverse lengthscales
+	void compileRbf(const RbfPolicy& policy, CompiledRbf& r) {
+		float inv_lengthscale[n_states];
+		compileLinear(policy.inv_lengthscale, inv_lengthscale);
+
+		const float inv_sqrt2 = 0.70710678f;
+		r.n_dims = 0;
+		for(size_t j = 0; j < n_states; j++) {
+			if (inv_lengthscale[j] == 0) continue;
+			r.dims[r.n_dims] = j;
+			r.scale[r.n_dims] = inv_lengthscale[j] * inv_sqrt2;
+			r.n_dims++;
+		}
+
+		r.n_centers = policy.centers_count < n_rbf ? policy.centers_count : n_rbf;
+		for(size_t i = 0; i < r.n_centers; i++) {
+			float c[n_states];
+			compileLinear(policy.centers[i].center, c);
+			for(size_t k = 0; k < r.n_dims; k++) {
+				r.centers[i][k] = c[r.dims[k]] * r.scale[k];
+			}
+			r.weights[i] = policy.centers[i].weight;
+		}
+	}
+
+	//! The number of bits set in a mask
+	size_t countBits(uint64_t mask) {
+		size_t n = 0;
+		for(; mask; mask &= mask - 1) n++;
+		return n;
+	}
+
+	/**
+	 * Compile a sparse policy, grouping its terms into rows. Returns false if
+	 * the masks name terms that do not exist, or do not match the number of
+	 * coefficients
+	 */
+	bool compileSparse(const SparsePolicy& policy, CompiledSparse& s) {
+		uint64_t quad_valid = n_quad < 64 ? (uint64_t(1) << n_quad) - 1 : ~uint64_t(0);
+		if (policy.lin_mask >> n_states) return false;
+		if (policy.quad_mask & ~quad_valid) return false;
+
+		size_t n_lin = countBits(policy.lin_mask);
+		if (n_lin + countBits(policy.quad_mask) != policy.coeffs_count) return false;
+
+		const float* lin = policy.coeffs;
+		const float* quad = policy.coeffs + n_lin;
+		size_t t = 0, bit = 0;
+		s.n_rows = 0;
+		for(size_t i = 0; i < n_states; i++) {
+			size_t row_start = t;
+			for(size_t j = i; j < n_states; j++, bit++) {
+				if (policy.quad_mask & (uint64_t(1) << bit)) {
+					s.cols[t] = j;
+					s.coeffs[t] = *quad++;
+					t++;
+				}
+			}
+			bool has_lin = policy.lin_mask & (uint32_t(1) << i);
+			if (!has_lin && t == row_start) continue;
+			s.rows[s.n_rows] = i;
+			s.lin[s.n_rows] = has_lin ? *lin++ : 0;
+			s.row_ends[s.n_rows] = t;
+			s.n_rows++;
+		}
+		return true;
+	}
+
+#ifdef POLICY_FIXED_POINT
+	//! The nonzero terms of a compiled affine or quadratic policy, as sparse rows
+	CompiledSparse sparseRows(const CompiledPolicy& c) {
+		CompiledSparse s;
+		const float* q = c.quad;
+		size_t t = 0;
+		s.n_rows = 0;
+		for(size_t i = 0; i < n_states; i++) {
+			size_t row_start = t;
+			for(size_t j = i; c.kind == PolicyKind::Quadratic && j < n_states; j++, q++) {
+				if (*q == 0) continue;
+				s.cols[t] = j;
+				s.coeffs[t] = *q;
+				t++;
+			}
+			if (c.lin[i] == 0 && t == row_start) continue;
+			s.rows[s.n_rows] = i;
+			s.lin[s.n_rows] = c.lin[i];
+			s.row_ends[s.n_rows] = t;
+			s.n_rows++;
+		}
+		return s;
+	}
+
+	//! the most fractional bits in a coefficient, leaving room in the bias
+	const int max_coeff_bits = 25;
+
+	//! round_saturate for int64, limited to +/-2^60 to leave room for the terms
+	int64_t roundBias(double v) {
+		const double limit = ldexp(1.0, 60);
+		v = v > limit ? limit : v < -limit ? -limit : v;
+		return int64_t(v < 0 ? v - 0.5 : v + 0.5);
+	}
+
+	/**
+	 * Convert a policy in sparse rows to fixed point. Like RawToSI::fuse, this
+	 * is done in double precision, as it only happens in setPolicy.
+	 */
+	void compileFixed(float bias, const CompiledSparse& s, FixedPolicy& f) {
+		using geometry::detail::round_saturate;
+
+		// the largest coefficient, in terms of the scaled states
+		double max_coeff = 0;
+		for(size_t r = 0, t = 0; r < s.n_rows; r++) {
+			int e_row = fields[s.rows[r]].range_exp;
+			max_coeff = fmax(max_coeff, fabs(ldexp(double(s.lin[r]), e_row)));
+			for(; t < s.row_ends[r]; t++) {
+				int e = e_row + fields[s.cols[t]].range_exp;
+				max_coeff = fmax(max_coeff, fabs(ldexp(double(s.coeffs[t]), e)));
+			}
+		}
+		int coeff_bits = max_coeff_bits;
+		while (coeff_bits > -state_bits && ldexp(max_coeff, coeff_bits) >= ldexp(1.0, state_bits)) {
+			coeff_bits--;
+		}
+
+		f.out_bits = coeff_bits + state_bits;
+		f.bias = roundBias(ldexp(double(bias), f.out_bits));
+		f.terms.n_rows = s.n_rows;
+		for(size_t r = 0, t = 0; r < s.n_rows; r++) {
+			int e_row = fields[s.rows[r]].range_exp;
+			f.terms.rows[r] = s.rows[r];
+			f.terms.row_ends[r] = s.row_ends[r];
+			f.terms.lin[r] = round_saturate(ldexp(double(s.lin[r]), coeff_bits + e_row));
+			for(; t < s.row_ends[r]; t++) {
+				int e = e_row + fields[s.cols[t]].range_exp;
+				f.terms.cols[t] = s.cols[t];
+				f.terms.coeffs[t] = round_saturate(ldexp(double(s.coeffs[t]), coeff_bits + e));
+			}
+		}
+	}
+#endif
+
+	/**
+	 * A policy of one of the types that patchPolicy can change. This has the
+	 * same members as Policy, but without the scheduled and RBF types, which
+	 * would make it three times the size.
+	 */
+	struct PatchablePolicy {
+		pb_size_t which_msg;
+		union {
+			LinearPolicy lin;
+			AffinePolicy affine;
+			QuadraticPolicy quad;
+			SparsePolicy sparse;
+		} msg;
+	};
+
+	//! Copy a policy, returning false if it is of a type that cannot be patched
+	bool toPatchable(const Policy& policy, PatchablePolicy& p) {
+		p.which_msg = policy.which_msg;
+		switch (policy.which_msg) {
+			case 0:
+				return true;
+			case Policy_lin_tag:
+				p.msg.lin = policy.msg.lin;
+				return true;
+			case Policy_affine_tag:
+				p.msg.affine = policy.msg.affine;
+				return true;
+			case Policy_quad_tag:
+				p.msg.quad = policy.msg.quad;
+				return true;
+			case Policy_sparse_tag:
+				p.msg.sparse = policy.msg.sparse;
+				return true;
+		}
+		p.which_msg = 0;
+		return false;
+	}
+
+	//! Compile the types of policy that only a Policy can hold
+	void compileLarge(const Policy& policy, CompiledPolicy& c) {
+		switch (policy.which_msg) {
+			case Policy_scheduled_tag:
+				if (compileScheduled(policy.msg.scheduled, c.schedule)) {
+					c.kind = PolicyKind::Scheduled;
+				}
+				break;
+			case Policy_rbf_tag:
+				c.bias = policy.msg.rbf.k_bias;
+				compileRbf(policy.msg.rbf, c.rbf);
+				c.kind = PolicyKind::Rbf;
+				break;
+		}
+	}
+	void compileLarge(const PatchablePolicy&, CompiledPolicy&) {}
+
+	/**
+	 * Compile any type of policy, from a Policy or PatchablePolicy, in place.
+	 * Unknown or invalid types produce a zero output. Only the first
+	 * compiledSize(policy) bytes of c are written, so it may be a slot of the
+	 * bank that has no more.
+	 */
+	template<typename P>
+	void compilePolicy(const P& policy, CompiledPolicy& c) {
+		c.kind = PolicyKind::Affine;
+		c.bias = 0;
+		for(size_t i = 0; i < n_states; i++) {
+			c.lin[i] = 0;
+		}
+		switch (policy.which_msg) {
+			case Policy_lin_tag:
+				compileLinear(policy.msg.lin, c.lin);
+				break;
+			case Policy_affine_tag:
+				c.bias = policy.msg.affine.k_bias;
+				compileLinear(policy.msg.affine.k_lin, c.lin);
+				break;
+			case Policy_quad_tag:
+				c.bias = policy.msg.quad.k_bias;
+				compileLinear(policy.msg.quad.k_lin, c.lin);
+				compileQuadratic(policy.msg.quad.k_quad, c.quad);
+				c.kind = PolicyKind::Quadratic;
+				break;
+			case Policy_sparse_tag:
+				if (compileSparse(policy.msg.sparse, c.sparse)) {
+					c.bias = policy.msg.sparse.k_bias;
+					c.kind = PolicyKind::Sparse;
+				}
+				break;
+			default:
+				compileLarge(policy, c);
+				break;
+		}
+#ifdef POLICY_FIXED_POINT
+		if (c.kind == PolicyKind::Affine || c.kind == PolicyKind::Quadratic ||
+		    c.kind == PolicyKind::Sparse) {
+			CompiledSparse s = c.kind == PolicyKind::Sparse ? c.sparse : sparseRows(c);
+			compileFixed(c.bias, s, c.fixed);
+			c.kind = PolicyKind::Fixed;
+		}
+#endif
+	}
+
+	/**
+	 * The number of bytes of a CompiledPolicy that compilePolicy writes for a
+	 * policy, which is all that evaluating it reads. This is rounded up to the
+	 * alignment of CompiledPolicy, so that policies can be packed end to end.
+	 */
+	size_t compiledSize(const Policy& policy) {
+		size_t payload = 0;
+		switch (policy.which_msg) {
+			case Policy_quad_tag:
+				payload = n_quad * sizeof(float);
+				break;
+			case Policy_scheduled_tag: {
+				size_t n = policy.msg.scheduled.gains_count;
+				payload = offsetof(CompiledSchedule, gains) + (n < n_schedule ? n : n_schedule) * sizeof(CompiledAffine);
+				break;
+			}
+			case Policy_rbf_tag: {
+				size_t n = policy.msg.rbf.centers_count;
+				payload = offsetof(CompiledRbf, centers) + (n < n_rbf ? n : n_rbf) * n_states * sizeof(float);
+				break;
+			}
+			case Policy_sparse_tag:
+				payload = sizeof(CompiledSparse);
+				break;
+		}
+#ifdef POLICY_FIXED_POINT
+		// any policy that fails to compile is zero, which is then made Fixed
+		if (payload < sizeof(FixedPolicy)) payload = sizeof(FixedPolicy);
+#endif
+		const size_t align = alignof(CompiledPolicy);
+		return (offsetof(CompiledPolicy, quad) + payload + align - 1) / align * align;
+	}
+
+	//! The state, gathered into contiguous vectors in the order of fields
+	struct GatheredState {
+		float x[n_states];
+#ifdef POLICY_FIXED_POINT
+		int32_t z[n_states];  //!< x[i] * 2^fields[i].shift, clamped to state_limit
+#endif
 	};
 
-	//! compute the policy output for a given policy and state
-	float computePolicy(const LinearPolicy& policy, const LogEntry& state) {
-		// dot product over the pairs of members defined in fields
+	//! Gather the state fields, converting them to fixed point if needed
+	void gatherState(const LogEntry& state, GatheredState& s) {
+		for(size_t i = 0; i < n_states; i++) {
+			s.x[i] = state.*(fields[i].state);
+#ifdef POLICY_FIXED_POINT
+			int32_t z = geometry::detail::ldexp_round(s.x[i], fields[i].shift);
+			s.z[i] = z > state_limit ? state_limit : z < -state_limit ? -state_limit : z;
+#endif
+		}
+	}
+
+	//! compute the output of a compiled affine policy
+	inline float computeAffine(const CompiledAffine& policy, const float x[n_states]) {
+		float result = policy[0];
+		for(size_t i = 0; i < n_states; i++) {
+			result += policy[i + 1] * x[i];
+		}
+		return result;
+	}
+
+	/**
+	 * Find the grid cell along one axis that contains v, returning its first
+	 * point and setting t to the position within it, in [0, 1]. Values beyond
+	 * the grid are clamped to its edges.
+	 */
+	inline size_t gridCell(float v, float v_min, float scale, uint8_t n, float& t) {
+		float f = (v - v_min) * scale;
+		float f_max = n - 1;
+		f = f > 0 ? (f < f_max ? f : f_max) : 0;  // also maps NaN to 0
+		size_t i = size_t(f);
+		if (i > 0 && i + 1 >= n) i--;  // the last point ends the last cell
+		t = f - i;
+		return i;
+	}
+
+	/**
+	 * compute the output of a gain-scheduled policy, by bilinear interpolation
+	 * of the gains at the corners of the cell containing the state. The
+	 * corners are blended into a single affine policy, which is then evaluated
+	 * once, with no trig or division.
+	 */
+	float computeScheduled(const CompiledSchedule& s, const float x[n_states]) {
+		float t_roll, t_pitch;
+		size_t i = gridCell(x[s.i_roll], s.roll_min, s.roll_scale, s.n_roll, t_roll);
+		size_t j = gridCell(x[s.i_pitch], s.pitch_min, s.pitch_scale, s.n_pitch, t_pitch);
+
+		const CompiledAffine* g = &s.gains[i * s.n_pitch + j];
+		const CompiledAffine& g00 = g[0];
+		const CompiledAffine& g01 = g[s.pitch_stride];
+		const CompiledAffine& g10 = g[s.roll_stride];
+		const CompiledAffine& g11 = g[s.roll_stride + s.pitch_stride];
+
+		// the weight of each corner
+		float w11 = t_roll * t_pitch;
+		float w10 = t_roll - w11;
+		float w01 = t_pitch - w11;
+		float w00 = 1 - t_roll - w01;
+
+		CompiledAffine blended;
+		for(size_t k = 0; k < n_states + 1; k++) {
+			blended[k] = w00 * g00[k] + w01 * g01[k] + w10 * g10[k] + w11 * g11[k];
+		}
+		return computeAffine(blended, x);
+	}
+
+	/**
+	 * compute the output of an RBF policy, without its bias. Per center, this
+	 * costs a subtraction, multiply and add for each state used, and an
+	 * exp_neg, which is far cheaper than libm exp on the soft-float MCU.
+	 */
+	float computeRbf(const CompiledRbf& r, const float x[n_states]) {
+		float z[n_states];
+		for(size_t k = 0; k < r.n_dims; k++) {
+			z[k] = x[r.dims[k]] * r.scale[k];
+		}
+
 		float result = 0;
-		for(const field_pair* fp = fields; *fp; fp++) {
-			result += policy.*(fp->lin_field) * state.*(fp->state);
+		for(size_t i = 0; i < r.n_centers; i++) {
+			const float* c = r.centers[i];
+			float dist2 = 0;
+			for(size_t k = 0; k < r.n_dims; k++) {
+				float d = z[k] - c[k];
+				dist2 += d * d;
+			}
+			result += r.weights[i] * geometry::fast::exp_neg(dist2);
 		}
 		return result;
 	}
-	float computePolicy(const PureQuadraticPolicy& policy, const LogEntry& state) {
-		// note that we define this in terms of a sum over linear policies
-		// weighted by state
+
+	//! The policy in a Controller for each output, in the order of PolicyOutputs
+	Policy Controller::* const outputs[] = {
+		&Controller::wheel,
+		&Controller::turntable,
+	};
+
+	//! The number of outputs of a controller
+	const size_t n_outputs = sizeof(outputs) / sizeof(outputs[0]);
+
+	static_assert(sizeof(PolicyOutputs) == n_outputs * sizeof(float),
+		"PolicyOutputs should have one member per entry in outputs");
+
+	//! The compiled policies for every output
+	struct CompiledController {
+		CompiledPolicy outputs[n_outputs];
+	};
+
+	/**
+	 * compute the output of a sparse policy, without its bias. This costs a
+	 * multiply-add for each row and each quadratic term that is present.
+	 */
+	float computeSparse(const CompiledSparse& s, const float x[n_states]) {
 		float result = 0;
-		for(const field_pair* fp = fields; *fp; fp++) {
-			result += computePolicy(policy.*(fp->quad_field), state) * state.*(fp->state);
+		size_t t = 0;
+		for(size_t r = 0; r < s.n_rows; r++) {
+			float row = s.lin[r];
+			for(; t < s.row_ends[r]; t++) {
+				row += s.coeffs[t] * x[s.cols[t]];
+			}
+			result += row * x[s.rows[r]];
 		}
 		return result;
 	}
-	float computePolicy(const AffinePolicy& policy, const LogEntry& state) {
-		return policy.k_bias
-			+ computePolicy(policy.k_lin, state);
+
+#ifdef POLICY_FIXED_POINT
+	/**
+	 * compute the output of a fixed-point policy, saturated to [-1, 1] like
+	 * saturate(). Each term is a single 32x32 to 64-bit multiply-accumulate,
+	 * and each row rounds its sum back to 32 bits before multiplying it by its
+	 * state.
+	 */
+	float computeFixed(const FixedPolicy& f, const int32_t z[n_states]) {
+		using geometry::detail::saturate;
+		using geometry::detail::shift_round;
+
+		const SparseRows<int32_t>& s = f.terms;
+		int64_t result = f.bias;
+		size_t t = 0;
+		for(size_t r = 0; r < s.n_rows; r++) {
+			int64_t row = s.lin[r] * (int64_t(1) << state_bits);
+			for(; t < s.row_ends[r]; t++) {
+				row += int64_t(s.coeffs[t]) * z[s.cols[t]];
+			}
+			result += int64_t(saturate(shift_round(row, state_bits))) * z[s.rows[r]];
+		}
+
+		const int64_t one = int64_t(1) << f.out_bits;
+		result = result > one ? one : result < -one ? -one : result;
+		return geometry::detail::ldexp_float(int32_t(shift_round(result, f.out_bits - 30)), 30);
 	}
-	float computePolicy(const QuadraticPolicy& policy, const LogEntry& state) {
-		return policy.k_bias
-			+ computePolicy(policy.k_lin, state)
-			+ computePolicy(policy.k_quad, state);
+#endif
+
+	//! compute the policy output for a compiled policy and gathered state
+	float computePolicy(const CompiledPolicy& policy, const GatheredState& state) {
+		const float* x = state.x;
+#ifdef POLICY_FIXED_POINT
+		if (policy.kind == PolicyKind::Fixed) {
+			return computeFixed(policy.fixed, state.z);
+		}
+#endif
+		if (policy.kind == PolicyKind::Scheduled) {
+			return computeScheduled(policy.schedule, x);
+		}
+		if (policy.kind == PolicyKind::Rbf) {
+			return policy.bias + computeRbf(policy.rbf, x);
+		}
+		if (policy.kind == PolicyKind::Sparse) {
+			return policy.bias + computeSparse(policy.sparse, x);
+		}
+		float result = policy.bias;
+		if (policy.kind == PolicyKind::Quadratic) {
+			const float* q = policy.quad;
+			for(size_t i = 0; i < n_states; i++) {
+				float row = policy.lin[i];
+				for(size_t j = i; j < n_states; j++) {
+					row += *q++ * x[j];
+				}
+				result += row * x[i];
+			}
+		}
+		else {
+			for(size_t i = 0; i < n_states; i++) {
+				result += policy.lin[i] * x[i];
+			}
+		}
+		return result;
 	}
 
-	//! Dispatch from a generic policy to a specific one
-	float computePolicy(const Policy& policy, const LogEntry& state) {
-		switch (policy.which_msg) {
-			case Policy_lin_tag:    return computePolicy(policy.msg.lin, state);
-			case Policy_affine_tag: return computePolicy(policy.msg.affine, state);
-			case Policy_quad_tag:   return computePolicy(policy.msg.quad, state);
-			default:                return 0;
+	/**
+	 * compute every output of a controller from a single gathered state. The
+	 * outputs may each be of a different type.
+	 */
+	void computePolicies(const CompiledController& c, const GatheredState& x, float u[n_outputs]) {
+		for(size_t k = 0; k < n_outputs; k++) {
+			u[k] = computePolicy(c.outputs[k], x);
+		}
+	}
+
+	/**
+	 * Two slots, so that setPolicy can compile a new controller into the
+	 * inactive one while the control loop is reading the active one. Only
+	 * applyPendingPolicy flips between them, at the start of a tick, so the
+	 * control loop never sees a half-written policy.
+	 */
+	CompiledController slots[2] = {};
+	volatile uint8_t active = 0;       //!< the slot read by the control loop
+	volatile bool pending = false;     //!< the inactive slot holds a new policy
+	volatile uint32_t version = 0;     //!< the number of policies that have taken effect
+	uint32_t sources[2] = {};          //!< the bank slot each slot was selected from, or 0
+
+	inline const CompiledController& activePolicy() {
+		return slots[active];
+	}
+
+	//! stop the control loop flipping to the inactive slot, and return it to be written
+	CompiledController& beginPending() {
+		pending = false;
+		__sync_synchronize();
+		return slots[1 - active];
+	}
+
+	//! let the control loop flip to the inactive slot on its next tick
+	void endPending(uint32_t source) {
+		sources[1 - active] = source;
+		__sync_synchronize();
+		pending = true;
+	}
+
+	/**
+	 * The policy bank, filled by storePolicy. selectPolicy copies from here
+	 * into the inactive slot, so the control loop never reads the bank, and
+	 * a slot can be replaced even while the policy selected from it runs.
+	 *
+	 * Each policy is stored in only its compiledSize bytes, and the slots are
+	 * packed end to end in order, so that the bank fits one controller of the
+	 * largest type, or several smaller ones.
+	 */
+	const size_t n_bank = 4;
+	alignas(CompiledPolicy) uint8_t bank[sizeof(CompiledController)];
+	uint16_t bank_sizes[n_bank][n_outputs] = {};  //!< the bytes of each policy in each slot
+	bool stored[n_bank] = {};
+
+	//! The number of bytes of the bank used by the slots before this one
+	size_t bankOffset(size_t slot) {
+		size_t offset = 0;
+		for(size_t s = 0; s < slot; s++) {
+			for(size_t k = 0; k < n_outputs; k++) {
+				offset += bank_sizes[s][k];
+			}
+		}
+		return offset;
+	}
+
+	//! The policy last set by setPolicy or patchPolicy, which patches apply to
+	PatchablePolicy sent[n_outputs] = {};
+	uint32_t sent_id = 0;        //!< the id of the last patch of sent, or 0 if none
+	bool sent_in_use = false;    //!< sent has been set since the last selectPolicy, and can be patched
+
+	//! compile a controller into the inactive slot, to take effect on the next tick
+	template<typename P>
+	void compilePending(const P& policies) {
+		CompiledController& next = beginPending();
+		for(size_t k = 0; k < n_outputs; k++) {
+			compilePolicy(policies[k], next.outputs[k]);
 		}
+		endPending(0);
 	}
 
-	//! Turntable policy
-	Policy policyTTParams = { 0 };
+	//! The policies of a controller, in the order of outputs
+	struct ControllerPolicies {
+		const Controller& c;
+		const Policy& operator[](size_t k) const { return c.*(outputs[k]); }
+	};
 
-	//! Wheel policy
-	Policy policyWheelParams = { 0 };
+	/**
+	 * The coefficient of a policy with the given id, numbered as in
+	 * PolicyCoefficient, or nullptr if it has none.
+	 */
+	float* coefficient(PatchablePolicy& p, uint32_t id) {
+		LinearPolicy* lin = nullptr;
+		float* bias = nullptr;
+		switch (p.which_msg) {
+			case Policy_lin_tag:
+				lin = &p.msg.lin;
+				break;
+			case Policy_affine_tag:
+				lin = &p.msg.affine.k_lin;
+				bias = &p.msg.affine.k_bias;
+				break;
+			case Policy_quad_tag:
+				lin = &p.msg.quad.k_lin;
+				bias = &p.msg.quad.k_bias;
+				if (id > n_states && id <= n_states + n_states * n_states) {
+					size_t a = (id - n_states - 1) / n_states;
+					size_t b = (id - n_states - 1) % n_states;
+					return &((p.msg.quad.k_quad.*fields[a].quad_field).*fields[b].lin_field);
+				}
+				break;
+			case Policy_sparse_tag:
+				if (id == 0) {
+					return &p.msg.sparse.k_bias;
+				}
+				return id <= p.msg.sparse.coeffs_count ? &p.msg.sparse.coeffs[id - 1] : nullptr;
+		}
+		if (id == 0) {
+			return bias;
+		}
+		if (lin && id <= n_states) {
+			return &(lin->*fields[id - 1].lin_field);
+		}
+		return nullptr;
+	}
+
+	//! The coefficient of the sent controller that a patch changes, or nullptr
+	float* patchTarget(const PolicyCoefficient& c) {
+		if (c.policy < 1 || c.policy > n_outputs) {
+			return nullptr;
+		}
+		return coefficient(sent[c.policy - 1], c.id);
+	}
 }
 
-//! Set the policy from an incoming message
+/**
+ * Set the policy from an incoming message, compiling it for evaluation. This
+ * is safe to call while the control loop is running, and the policy takes
+ * effect from the next call to applyPendingPolicy.
+ */
 void setPolicy(const Controller& new_controller)
 {
-	policyWheelParams = new_controller.wheel;
-	policyTTParams = new_controller.turntable;
+	bool patchable = true;
+	for(size_t k = 0; k < n_outputs; k++) {
+		patchable = toPatchable(new_controller.*(outputs[k]), sent[k]) && patchable;
+	}
+	sent_id = 0;
+	sent_in_use = patchable;
+	compilePending(ControllerPolicies{new_controller});
 }
 
-float saturate(float p){
-	// TODO: implement the same saturation as in simulation
-	if (p > 1) {
-		return 1;
+/**
+ * Change some coefficients of the controller last set, recompiling it to take
+ * effect from the next call to applyPendingPolicy, as setPolicy does. Returns
+ * false, leaving the policy unchanged, if any coefficient does not exist, if
+ * the patch was made from a different controller, if any output of it is a
+ * scheduled or RBF policy, or if a policy from the bank has been selected
+ * since, as patching would then switch back to it.
+ */
+bool patchPolicy(const PatchPolicy& patch)
+{
+	if (!sent_in_use || patch.base != sent_id) {
+		return false;
 	}
-	else if (p < -1) {
-		return -1;
+	for(size_t t = 0; t < patch.coeffs_count; t++) {
+		if (!patchTarget(patch.coeffs[t])) {
+			return false;
+		}
 	}
-	else {
-		return p;
+	for(size_t t = 0; t < patch.coeffs_count; t++) {
+		*patchTarget(patch.coeffs[t]) = patch.coeffs[t].value;
+	}
+	sent_id = patch.id;
+	compilePending(sent);
+	return true;
+}
+
+/**
+ * Compile a policy from an incoming message into a slot of the bank, where it
+ * stays until replaced. Returns false, leaving the bank unchanged, if the slot
+ * does not exist, or the other slots leave no room for the policy.
+ */
+bool storePolicy(const StorePolicy& msg)
+{
+	if (msg.slot < 1 || msg.slot > n_bank) {
+		return false;
+	}
+	const size_t slot = msg.slot - 1;
+	size_t sizes[n_outputs], size = 0, old_size = 0;
+	for(size_t k = 0; k < n_outputs; k++) {
+		sizes[k] = compiledSize(msg.controller.*(outputs[k]));
+		size += sizes[k];
+		old_size += bank_sizes[slot][k];
+	}
+	const size_t offset = bankOffset(slot), used = bankOffset(n_bank);
+	if (used - old_size + size > sizeof(bank)) {
+		return false;
+	}
+
+	// move the later slots to fit the new size, then compile into the gap
+	memmove(bank + offset + size, bank + offset + old_size, used - offset - old_size);
+	uint8_t* p = bank + offset;
+	for(size_t k = 0; k < n_outputs; k++) {
+		compilePolicy(msg.controller.*(outputs[k]), *reinterpret_cast<CompiledPolicy*>(p));
+		bank_sizes[slot][k] = sizes[k];
+		p += sizes[k];
+	}
+	stored[slot] = true;
+	return true;
+}
+
+/**
+ * Set the policy to the one stored in a slot of the bank. Like setPolicy, this
+ * takes effect from the next call to applyPendingPolicy. Returns false if
+ * nothing has been stored in the slot.
+ */
+bool selectPolicy(uint32_t slot)
+{
+	if (slot < 1 || slot > n_bank || !stored[slot - 1]) {
+		return false;
 	}
+	sent_in_use = false;
+	CompiledController& next = beginPending();
+	const uint8_t* p = bank + bankOffset(slot - 1);
+	for(size_t k = 0; k < n_outputs; k++) {
+		memcpy(&next.outputs[k], p, bank_sizes[slot - 1][k]);
+		p += bank_sizes[slot - 1][k];
+	}
+	endPending(slot);
+	return true;
 }
 
-//! compute the turntable output from the current policy, given the state
-float policyTurntable(const LogEntry& state)
+/**
+ * The bank slot that the policy in effect was selected from, or 0 if it was
+ * set by setPolicy. Like the version, this changes at applyPendingPolicy.
+ */
+uint32_t activePolicySlot()
 {
-	return saturate(computePolicy(policyTTParams, state));
+	return sources[active];
 }
 
-//! compute the wheel output from the current policy, given the state
-float policyWheel(const LogEntry& state)
+/**
+ * Called by the control loop at the start of each tick, to switch to any new
+ * policy. Returns the number of policies that have taken effect, which
+ * changes on the tick that a new one does.
+ */
+uint32_t applyPendingPolicy()
 {
-	return saturate(computePolicy(policyWheelParams, state));
+	if (pending) {
+		active = 1 - active;
+		pending = false;
+		version = version + 1;
+	}
+	return version;
+}
+
+//! compute every output from the current policy, given the state
+PolicyOutputs computePolicies(const LogEntry& state)
+{
+	GatheredState x;
+	gatherState(state, x);
+
+	float u[n_outputs];
+	computePolicies(activePolicy(), x, u);
+
+	PolicyOutputs result;
+	result.wheel = saturate(u[0]);
+	result.turntable = saturate(u[1]);
+	return result;
 }
+#endif
@@ -1,8 +1,46 @@
 #pragma once
 
+#include <stdint.h>
+
 struct _LogEntry; typedef _LogEntry LogEntry;
 struct _Controller; typedef _Controller Controller;
+struct _StorePolicy; typedef _StorePolicy StorePolicy;
+struct _PatchPolicy; typedef _PatchPolicy PatchPolicy;
+
+//! The saturated output of the policy for each actuator
+struct PolicyOutputs {
+	float wheel;
+	float turntable;
+};
+
+// Computes every output in one pass over the state
+PolicyOutputs computePolicies(const LogEntry& state);
 
-float policyTurntable(const LogEntry& state);
-float policyWheel(const LogEntry& state);
+// Sets the policy used from the next tick. Safe while the control loop runs
 void setPolicy(const Controller& new_controller);
+
+// Changes some coefficients of the policy last set, as setPolicy does. Returns
+// false if any of them does not exist, or the patch does not apply to the
+// policy last set, or that policy has a scheduled or RBF output, or a policy
+// has been selected from the bank since
+bool patchPolicy(const PatchPolicy& patch);
+
+// Compiles a policy into a slot of the bank, without using it yet. Returns
+// false if there is no such slot, or the policies in the other slots leave no
+// room for it
+bool storePolicy(const StorePolicy& msg);
+
+// Sets the policy stored in a slot of the bank, as setPolicy does. Returns
+// false if nothing is stored in the slot
+bool selectPolicy(uint32_t slot);
+
+// The bank slot the current policy was selected from, or 0 if it was set by
+// setPolicy
+uint32_t activePolicySlot();
+
+// Called at the start of each tick. Returns the number of policies that have
+// taken effect so far
+uint32_t applyPendingPolicy();
+
+// Limits a policy output to the range accepted by the motors
+float saturate(float p);
@@ -0,0 +1,44 @@
+/**
+ * Forward prediction of the state over the latency from reading the sensors
+ * to writing the motors, so that the policy acts on the state at the time its
+ * output takes effect.
+ *
+ * This has no hardware dependencies, so that the host tools can apply the same
+ * prediction to recorded logs.
+ */
+#pragma once
+
+#include <math.h>
+
+#include <messages.pb.h>
+#include <trig.h>
+
+const float WHEEL_CIRC = 0.222;       // circumference of the unicycle wheel (measured)
+const float W_RADIUS = WHEEL_CIRC / (2 * M_PI);
+
+/**
+ * Advance every angle and position in l by `lead` seconds, to first order,
+ * holding every rate in it constant.
+ *
+ * The origin is in the self-centered frame, so it moves both as the wheel
+ * rolls forward along x, and as the robot yaws about it. The world position
+ * moves along the current heading. Only the states are changed, so the log
+ * keeps them as measured, and bench/replay recomputes the prediction from
+ * them and the logged lead.
+ */
+inline void predictState(LogEntry& l, float lead) {
+  float v = W_RADIUS * l.dAngleW;  // ground speed
+  float xOrigin = l.xOrigin;
+  float yOrigin = l.yOrigin;
+
+  l.x += v * geometry::trig::cos(l.yaw) * lead;
+  l.y += v * geometry::trig::sin(l.yaw) * lead;
+  l.AngleW  += l.dAngleW * lead;
+  l.AngleTT += l.dAngleTT * lead;
+
+  l.roll  += l.droll * lead;
+  l.yaw   += l.dyaw * lead;
+  l.pitch += l.dpitch * lead;
+  l.xOrigin += (l.dyaw * yOrigin - v) * lead;
+  l.yOrigin -= l.dyaw * xOrigin * lead;
+}
@@ -1,9 +1,11 @@
 import asyncio
 import collections
+import math
 
 import serial
 import serial.tools.list_ports
 from cobs import cobs
+from google.protobuf.descriptor import FieldDescriptor
 from google.protobuf.message import DecodeError
 from serial import SerialException
 
@@ -81,16 +83,219 @@ class COBSStream(StreamWrapper):
         self._conn.flush()
 
 
+# the LogEntry fields, in the order of their field numbers
+_log_fields = sorted(messages_pb2.LogEntry.DESCRIPTOR.fields, key=lambda f: f.number)
+
+# the max_count of Go.log_rates in messages.options
+max_log_rates = 8
+
+
+def set_log_fields(go, rates):
+    """
+    Choose the fields of LogEntry sent during the run started by go, from a
+    dict of field names to the number of ticks between each time it is sent
+
+    >>> go = messages_pb2.Go()
+    >>> set_log_fields(go, {'pitch': 1, 'yaw': 5})
+    >>> bin(go.log_fields), [(r.field, r.every) for r in go.log_rates]
+    ('0b1100000000', [(9, 5)])
+    >>> set_log_fields(go, {'speed': 1})
+    Traceback (most recent call last):
+    ...
+    ValueError: LogEntry has no field 'speed'
+    """
+    go.log_fields = 0
+    del go.log_rates[:]
+    for name, every in rates.items():
+        try:
+            f = messages_pb2.LogEntry.DESCRIPTOR.fields_by_name[name]
+        except KeyError:
+            raise ValueError('LogEntry has no field {!r}'.format(name)) from None
+        go.log_fields |= 1 << (f.number - 1)
+        if every > 1:
+            go.log_rates.add(field=f.number, every=every)
+    if len(go.log_rates) > max_log_rates:
+        raise ValueError('At most {} fields can be sent less than every tick'.format(max_log_rates))
+
+
+class LogFieldSelection:
+    """
+    The fields of LogEntry sent on each tick of a run, as chosen by the
+    log_fields and log_rates of its Go. This must match sendLog in
+    lib/messages/messaging.cpp
+
+    >>> go = messages_pb2.Go()
+    >>> set_log_fields(go, {'pitch': 1, 'yaw': 5})
+    >>> s = LogFieldSelection(go)
+    >>> sorted(s.sent(10)), sorted(s.sent(11))
+    (['pitch', 'tick', 'yaw'], ['pitch', 'tick'])
+    >>> len(LogFieldSelection().sent(11))
+    24
+    >>> set_log_fields(go, {'yaw': 5})
+    >>> LogFieldSelection(go).sent(11)
+    set()
+    >>> e = messages_pb2.LogEntry(tick=11, pitch=1, yaw=0)
+    >>> s.mark_unsent(e)
+    >>> e.pitch, e.yaw, e.roll
+    (1.0, nan, nan)
+    """
+    def __init__(self, go=None):
+        self._fields = go.log_fields if go is not None and go.log_fields else ~0
+        self._every = {r.field: r.every for r in go.log_rates} if go is not None else {}
+
+    def sent(self, tick):
+        """ The names of the fields sent on a tick, which is empty if no entry is """
+        names = {
+            f.name for f in _log_fields
+            if f.name != 'tick'
+            and self._fields >> (f.number - 1) & 1
+            and tick % max(self._every.get(f.number, 1), 1) == 0
+        }
+        if names:
+            names.add('tick')
+        return names
+
+    def mark_unsent(self, entry):
+        """ Set the float fields of an entry that were not sent to NaN """
+        sent = self.sent(entry.tick)
+        for f in _log_fields:
+            if f.name not in sent and f.cpp_type == FieldDescriptor.CPPTYPE_FLOAT:
+                setattr(entry, f.name, math.nan)
+
+
+# the fields of LogEntry which keep only their low bits in a CompactLogEntry,
+# and are unwrapped from one entry to the next, as in lib/messages/compact_log.cpp
+_compact_unwrapped = {'AngleW', 'AngleTT', 'tick', 'policy_version'}
+
+# the fields of LogEntry in the order they are packed, with the tick first, as
+# tuples of the name, the number of bits, and the step of float fields
+_compact_layout = [
+    (f.name,
+     messages_pb2.CompactLogBits.Value('BITS_' + f.name),
+     2.0 ** -messages_pb2.CompactLogStep.Value('STEP_' + f.name)
+        if f.cpp_type == FieldDescriptor.CPPTYPE_FLOAT else None)
+    for f in sorted(_log_fields, key=lambda f: f.name != 'tick')
+]
+_compact_bits = {name: bits for name, bits, step in _compact_layout}
+
+
+class CompactLogDecoder:
+    """
+    Expands the CompactLogEntry of a run back into LogEntry, unwrapping the
+    fields which wrap around from the entry before. Reset this at the start of
+    each run.
+
+    The words below are of entries encoded by lib/messages/compact_log.cpp
+
+    >>> d = CompactLogDecoder()
+    >>> e = d.decode(messages_pb2.CompactLogEntry(packed=[
+    ...     0x00017530, 0x0ff00000, 0x00000000, 0x00000000, 0x01c00000,
+    ...     0x19000000, 0x00000000, 0x00000001, 0x30008404]))
+    >>> e.droll, e.dAngleW, e.pitch, e.WheelInput, e.lead
+    (0.001953125, -1.0, -1.0, -8.0, 0.0040283203125)
+    >>> e.AngleW, e.tick, e.policy_version, e.policy_slot
+    (100.0, 30000, 1, 3)
+    >>> e = d.decode(messages_pb2.CompactLogEntry(packed=[
+    ...     0x0000ea60, 0, 0, 0, 0, 0x32000000, 0, 0, 0]))
+    >>> e.AngleW, e.tick
+    (200.0, 60000)
+    >>> e = d.decode(messages_pb2.CompactLogEntry(packed=[
+    ...     0x00005f90, 0, 0, 0, 0, 0x0b000000, 0, 0, 0]))
+    >>> e.AngleW, e.tick
+    (300.0, 90000)
+
+    Streamed entries hold only the fields their run sends on their tick
+
+    >>> go = messages_pb2.Go()
+    >>> set_log_fields(go, {'pitch': 1, 'yaw': 5})
+    >>> s = LogFieldSelection(go)
+    >>> d.reset()
+    >>> e = d.decode(messages_pb2.CompactLogEntry(packed=[0x0200000a, 0x00000380]), s)
+    >>> e.tick, e.yaw, e.pitch
+    (10, 0.5, -1.0)
+    >>> e = d.decode(messages_pb2.CompactLogEntry(packed=[0x1c00000b]), s)
+    >>> e.tick, e.pitch
+    (11, -1.0)
+    """
+    def __init__(self):
+        self.reset()
+
+    def reset(self):
+        self._last = {name: 0 for name in _compact_unwrapped}
+
+    def _unwrap(self, name, v, bits):
+        """ Take the change in a field since the last entry as the smallest one """
+        last = self._last[name]
+        d = (v - last) & ((1 << bits) - 1)
+        if d >> (bits - 1):
+            d -= 1 << bits
+        self._last[name] = last + d
+        return last + d
+
+    def decode(self, compact, selection=None):
+        """
+        The LogEntry packed into compact. Given the LogFieldSelection of the
+        run, only the fields it sends on the tick are unpacked, as only those
+        were packed. Otherwise, it is taken to hold every field, as in a
+        LogBundle.
+        """
+        packed = 0
+        for word in reversed(compact.packed):
+            packed = packed << 32 | word
+
+        bits = _compact_bits['tick']
+        entry = messages_pb2.LogEntry()
+        entry.tick = self._unwrap('tick', packed & ((1 << bits) - 1), bits)
+        packed >>= bits
+        sent = selection.sent(entry.tick) if selection is not None else None
+        for name, bits, step in _compact_layout:
+            if name == 'tick' or sent is not None and name not in sent:
+                continue
+            v = packed & ((1 << bits) - 1)
+            packed >>= bits
+            if name in _compact_unwrapped:
+                v = self._unwrap(name, v, bits)
+            elif step is not None and v >> (bits - 1):
+                v -= 1 << bits
+            setattr(entry, name, v * step if step is not None else v)
+        return entry
+
+
 class ProtobufStream(StreamWrapper):
+    """
+    Sends PCMessage, and receives RobotMessage, with any CompactLogEntry in
+    them expanded back into LogEntry. The fields of each single_log that were
+    not sent, as chosen by the last Go, are NaN.
+    """
+    def __init__(self, conn):
+        super().__init__(conn)
+        self._compact_logs = CompactLogDecoder()
+        self._log_fields = LogFieldSelection()
+
     async def read(self) -> messages_pb2.RobotMessage:
         data = await self._conn.read_packet()
         try:
-            return messages_pb2.RobotMessage.FromString(data)
+            msg = messages_pb2.RobotMessage.FromString(data)
         except DecodeError as e:
             raise CommsError('Could not decode {!r}'.format(data)) from e
 
+        which = msg.WhichOneof('msg')
+        if which == 'compact_log':
+            msg.single_log.CopyFrom(self._compact_logs.decode(msg.compact_log, self._log_fields))
+            which = 'single_log'
+        if which == 'single_log':
+            self._log_fields.mark_unsent(msg.single_log)
+        elif which == 'log_bundle' and msg.log_bundle.compact_entry:
+            bundle = CompactLogDecoder()
+            msg.log_bundle.entry.extend(bundle.decode(e) for e in msg.log_bundle.compact_entry)
+            del msg.log_bundle.compact_entry[:]
+        return msg
+
     def write(self, msg: messages_pb2.PCMessage):
         assert isinstance(msg, messages_pb2.PCMessage)
+        if msg.WhichOneof('msg') == 'go':
+            self._compact_logs.reset()
+            self._log_fields = LogFieldSelection(msg.go)
         self._conn.write_packet(msg.SerializeToString())
 
 
@@ -42,6 +42,17 @@ def repeated_submessage_to_np(type, msg):
         for e in msg
     ], dtype=dtype_for(type))
 
+def compact_log_steps():
+    """
+    The step that each float field of LogEntry is quantized to in a
+    CompactLogEntry, as declared by CompactLogStep in messages.proto
+    """
+    return {
+        f.name: 2.0 ** -messages_pb2.CompactLogStep.Value('STEP_' + f.name)
+        for f in messages_pb2.LogEntry.DESCRIPTOR.fields
+        if f.cpp_type == FieldDescriptor.CPPTYPE_FLOAT
+    }
+
 base = Path('..')
 
 class LogSaver:
@@ -53,14 +64,25 @@ class LogSaver:
         )
         self.log_count = 0
 
-    def save(self, logs):
+    def save(self, logs, compact=False):
+        """
+        Save a list of LogEntry. If they were sent as CompactLogEntry, then the
+        step each field was quantized to is saved alongside as `quantization`
+        """
         fpath = (self.logs_dir / '{}.mat'.format(self.log_count))
         log = repeated_submessage_to_np(messages_pb2.LogEntry, logs)
+        data = dict(msg=log, tstamp=datetime.now().isoformat())
+        if compact:
+            data['quantization'] = compact_log_steps()
 
         if self.log_count == 0:
             self.logs_dir.mkdir()
         with fpath.open('wb') as f:
-            scipy.io.savemat(f, dict(msg=log, tstamp=datetime.now().isoformat()))
+            scipy.io.savemat(f, data)
+
+        # and the raw messages, for bench/replay
+        bundle = messages_pb2.LogBundle(entry=logs)
+        fpath.with_suffix('.pb').write_bytes(bundle.SerializeToString())
 
         self.log_count += 1
         return fpath
@@ -74,14 +96,20 @@ def _apply_to_msg(msg, np_array):
     The fieldnames should match exactly, and the file must have been loaded with
     squeeze_me=True.
 
-    Only works for scalar structs right now - no arrays
+    Repeated message fields are filled from struct arrays. Repeated scalar
+    fields are not supported.
     """
     for field_name in np_array.dtype.fields:
         field_val = np_array[field_name]
         field_val = field_val[()]  # squeeze_me doesn't squeeze 0d to scalar
+        field = msg.DESCRIPTOR.fields_by_name[field_name]
 
+        # one message per element of a struct array
+        if field.label == FieldDescriptor.LABEL_REPEATED:
+            for elem in np.atleast_1d(field_val):
+                _apply_to_msg(getattr(msg, field_name).add(), elem)
         # recurse nested fields
-        if isinstance(field_val, np.ndarray):
+        elif isinstance(field_val, np.ndarray):
             _apply_to_msg(getattr(msg, field_name), field_val)
         # directly set other ones
         else:
@@ -91,3 +119,28 @@ def _apply_to_msg(msg, np_array):
 def load_policy(mat_file_name):
     msg = scipy.io.loadmat(mat_file_name, squeeze_me=True)['msg']
     return _apply_to_msg(messages_pb2.Controller(), msg)
+
+def _apply_sensor_calibration(msg, cal):
+    """
+    Fill a SensorCalibration message from a struct with a 3x3 matrix `M` and a
+    3-vector `bias`
+    """
+    M = np.asarray(cal['M'][()], dtype=np.float32).reshape(3, 3)
+    bias = np.asarray(cal['bias'][()], dtype=np.float32).reshape(3)
+    for row, m in zip((msg.m_x, msg.m_y, msg.m_z), M):
+        row.x, row.y, row.z = m
+    msg.bias.x, msg.bias.y, msg.bias.z = bias
+
+def load_imu_calibration(mat_file_name):
+    """
+    Load a SetImuCalibration message from a mat file containing the structs
+    `gyro` and `accel`, each with fields `M` and `bias`. These correct the
+    readings as `M * reading - bias`. A missing struct leaves that sensor
+    uncorrected.
+    """
+    mat = scipy.io.loadmat(mat_file_name, squeeze_me=True)
+    msg = messages_pb2.SetImuCalibration()
+    for name in ('gyro', 'accel'):
+        if name in mat:
+            _apply_sensor_calibration(getattr(msg, name), mat[name])
+    return msg
@@ -1,14 +1,11 @@
+# -*- coding: utf-8 -*-
 # Generated by the protocol buffer compiler.  DO NOT EDIT!
 # source: messages.proto
-
-import sys
-_b=sys.version_info[0]<3 and (lambda x:x) or (lambda x:x.encode('latin1'))
-from google.protobuf.internal import enum_type_wrapper
+"""Generated protocol buffer code."""
+from google.protobuf.internal import builder as _builder
 from google.protobuf import descriptor as _descriptor
-from google.protobuf import message as _message
-from google.protobuf import reflection as _reflection
+from google.protobuf import descriptor_pool as _descriptor_pool
 from google.protobuf import symbol_database as _symbol_database
-from google.protobuf import descriptor_pb2
 # @@protoc_insertion_point(imports)
 
 _sym_db = _symbol_database.Default()
@@ -17,746 +14,69 @@ _sym_db = _symbol_database.Default()
 import policies_pb2 as policies__pb2
 
 
-DESCRIPTOR = _descriptor.FileDescriptor(
-  name='messages.proto',
-  package='',
-  syntax='proto3',
-  serialized_pb=_b('\n\x0emessages.proto\x1a\x0epolicies.proto\"\x13\n\x02Go\x12\r\n\x05steps\x18\x01 \x01(\x05\"\x06\n\x04Stop\"\t\n\x07GetLogs\"\x0f\n\rCalibrateGyro\"\x12\n\x10GetAccelerometer\"-\n\tSetMotors\x12\r\n\x05wheel\x18\x01 \x01(\x02\x12\x11\n\tturntable\x18\x02 \x01(\x02\"@\n\nController\x12\x16\n\x05wheel\x18\x01 \x01(\x0b\x32\x07.Policy\x12\x1a\n\tturntable\x18\x02 \x01(\x0b\x32\x07.Policy\"\xea\x01\n\tPCMessage\x12\x11\n\x02go\x18\x01 \x01(\x0b\x32\x03.GoH\x00\x12\x15\n\x04stop\x18\x02 \x01(\x0b\x32\x05.StopH\x00\x12!\n\ncontroller\x18\x03 \x01(\x0b\x32\x0b.ControllerH\x00\x12\x1c\n\x08get_logs\x18\x04 \x01(\x0b\x32\x08.GetLogsH\x00\x12#\n\tcalibrate\x18\x05 \x01(\x0b\x32\x0e.CalibrateGyroH\x00\x12$\n\x07get_acc\x18\x06 \x01(\x0b\x32\x11.GetAccelerometerH\x00\x12 \n\nset_motors\x18\x07 \x01(\x0b\x32\n.SetMotorsH\x00\x42\x05\n\x03msg\"\xb0\x02\n\x08LogEntry\x12\r\n\x05\x64roll\x18\x01 \x01(\x02\x12\x0c\n\x04\x64yaw\x18\x02 \x01(\x02\x12\x0f\n\x07\x64\x41ngleW\x18\x03 \x01(\x02\x12\x0e\n\x06\x64pitch\x18\x04 \x01(\x02\x12\x10\n\x08\x64\x41ngleTT\x18\x05 \x01(\x02\x12\x0f\n\x07xOrigin\x18\x06 \x01(\x02\x12\x0f\n\x07yOrigin\x18\x07 \x01(\x02\x12\x0c\n\x04roll\x18\x08 \x01(\x02\x12\x0b\n\x03yaw\x18\t \x01(\x02\x12\r\n\x05pitch\x18\n \x01(\x02\x12\t\n\x01x\x18\x0f \x01(\x02\x12\t\n\x01y\x18\x10 \x01(\x02\x12\x0e\n\x06\x41ngleW\x18\x11 \x01(\x02\x12\x0f\n\x07\x41ngleTT\x18\x12 \x01(\x02\x12\x16\n\x0eTurntableInput\x18\x13 \x01(\x02\x12\x12\n\nWheelInput\x18\x14 \x01(\x02\x12\x0b\n\x03\x64\x64x\x18\x15 \x01(\x02\x12\x0b\n\x03\x64\x64y\x18\x16 \x01(\x02\x12\x0b\n\x03\x64\x64z\x18\x17 \x01(\x02\"%\n\tLogBundle\x12\x18\n\x05\x65ntry\x18\x01 \x03(\x0b\x32\t.LogEntry\"5\n\x0c\x44\x65\x62ugMessage\x12\t\n\x01s\x18\x01 \x01(\t\x12\x1a\n\x05level\x18\x02 \x01(\x0e\x32\x0b.DebugLevel\"x\n\x0cRobotMessage\x12 \n\nlog_bundle\x18\x01 \x01(\x0b\x32\n.LogBundleH\x00\x12\x1e\n\x05\x64\x65\x62ug\x18\x02 \x01(\x0b\x32\r.DebugMessageH\x00\x12\x1f\n\nsingle_log\x18\x03 \x01(\x0b\x32\t.LogEntryH\x00\x42\x05\n\x03msg*6\n\nDebugLevel\x12\t\n\x05\x44\x45\x42UG\x10\x00\x12\x08\n\x04INFO\x10\x01\x12\x08\n\x04WARN\x10\x02\x12\t\n\x05\x45RROR\x10\x03\x62\x06proto3')
-  ,
-  dependencies=[policies__pb2.DESCRIPTOR,])
-_sym_db.RegisterFileDescriptor(DESCRIPTOR)
-
-_DEBUGLEVEL = _descriptor.EnumDescriptor(
-  name='DebugLevel',
-  full_name='DebugLevel',
-  filename=None,
-  file=DESCRIPTOR,
-  values=[
-    _descriptor.EnumValueDescriptor(
-      name='DEBUG', index=0, number=0,
-      options=None,
-      type=None),
-    _descriptor.EnumValueDescriptor(
-      name='INFO', index=1, number=1,
-      options=None,
-      type=None),
-    _descriptor.EnumValueDescriptor(
-      name='WARN', index=2, number=2,
-      options=None,
-      type=None),
-    _descriptor.EnumValueDescriptor(
-      name='ERROR', index=3, number=3,
-      options=None,
-      type=None),
-  ],
-  containing_type=None,
-  options=None,
-  serialized_start=984,
-  serialized_end=1038,
-)
-_sym_db.RegisterEnumDescriptor(_DEBUGLEVEL)
-
-DebugLevel = enum_type_wrapper.EnumTypeWrapper(_DEBUGLEVEL)
-DEBUG = 0
-INFO = 1
-WARN = 2
-ERROR = 3
-
-
-
-_GO = _descriptor.Descriptor(
-  name='Go',
-  full_name='Go',
-  filename=None,
-  file=DESCRIPTOR,
-  containing_type=None,
-  fields=[
-    _descriptor.FieldDescriptor(
-      name='steps', full_name='Go.steps', index=0,
-      number=1, type=5, cpp_type=1, label=1,
-      has_default_value=False, default_value=0,
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      options=None),
-  ],
-  extensions=[
-  ],
-  nested_types=[],
-  enum_types=[
-  ],
-  options=None,
-  is_extendable=False,
-  syntax='proto3',
-  extension_ranges=[],
-  oneofs=[
-  ],
-  serialized_start=34,
-  serialized_end=53,
-)
-
-
-_STOP = _descriptor.Descriptor(
-  name='Stop',
-  full_name='Stop',
-  filename=None,
-  file=DESCRIPTOR,
-  containing_type=None,
-  fields=[
-  ],
-  extensions=[
-  ],
-  nested_types=[],
-  enum_types=[
-  ],
-  options=None,
-  is_extendable=False,
-  syntax='proto3',
-  extension_ranges=[],
-  oneofs=[
-  ],
-  serialized_start=55,
-  serialized_end=61,
-)
-
-
-_GETLOGS = _descriptor.Descriptor(
-  name='GetLogs',
-  full_name='GetLogs',
-  filename=None,
-  file=DESCRIPTOR,
-  containing_type=None,
-  fields=[
-  ],
-  extensions=[
-  ],
-  nested_types=[],
-  enum_types=[
-  ],
-  options=None,
-  is_extendable=False,
-  syntax='proto3',
-  extension_ranges=[],
-  oneofs=[
-  ],
-  serialized_start=63,
-  serialized_end=72,
-)
-
-
-_CALIBRATEGYRO = _descriptor.Descriptor(
-  name='CalibrateGyro',
-  full_name='CalibrateGyro',
-  filename=None,
-  file=DESCRIPTOR,
-  containing_type=None,
-  fields=[
-  ],
-  extensions=[
-  ],
-  nested_types=[],
-  enum_types=[
-  ],
-  options=None,
-  is_extendable=False,
-  syntax='proto3',
-  extension_ranges=[],
-  oneofs=[
-  ],
-  serialized_start=74,
-  serialized_end=89,
-)
-
-
-_GETACCELEROMETER = _descriptor.Descriptor(
-  name='GetAccelerometer',
-  full_name='GetAccelerometer',
-  filename=None,
-  file=DESCRIPTOR,
-  containing_type=None,
-  fields=[
-  ],
-  extensions=[
-  ],
-  nested_types=[],
-  enum_types=[
-  ],
-  options=None,
-  is_extendable=False,
-  syntax='proto3',
-  extension_ranges=[],
-  oneofs=[
-  ],
-  serialized_start=91,
-  serialized_end=109,
-)
-
-
-_SETMOTORS = _descriptor.Descriptor(
-  name='SetMotors',
-  full_name='SetMotors',
-  filename=None,
-  file=DESCRIPTOR,
-  containing_type=None,
-  fields=[
-    _descriptor.FieldDescriptor(
-      name='wheel', full_name='SetMotors.wheel', index=0,
-      number=1, type=2, cpp_type=6, label=1,
-      has_default_value=False, default_value=float(0),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      options=None),
-    _descriptor.FieldDescriptor(
-      name='turntable', full_name='SetMotors.turntable', index=1,
-      number=2, type=2, cpp_type=6, label=1,
-      has_default_value=False, default_value=float(0),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      options=None),
-  ],
-  extensions=[
-  ],
-  nested_types=[],
-  enum_types=[
-  ],
-  options=None,
-  is_extendable=False,
-  syntax='proto3',
-  extension_ranges=[],
-  oneofs=[
-  ],
-  serialized_start=111,
-  serialized_end=156,
-)
-
-
-_CONTROLLER = _descriptor.Descriptor(
-  name='Controller',
-  full_name='Controller',
-  filename=None,
-  file=DESCRIPTOR,
-  containing_type=None,
-  fields=[
-    _descriptor.FieldDescriptor(
-      name='wheel', full_name='Controller.wheel', index=0,
-      number=1, type=11, cpp_type=10, label=1,
-      has_default_value=False, default_value=None,
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      options=None),
-    _descriptor.FieldDescriptor(
-      name='turntable', full_name='Controller.turntable', index=1,
-      number=2, type=11, cpp_type=10, label=1,
-      has_default_value=False, default_value=None,
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      options=None),
-  ],
-  extensions=[
-  ],
-  nested_types=[],
-  enum_types=[
-  ],
-  options=None,
-  is_extendable=False,
-  syntax='proto3',
-  extension_ranges=[],
-  oneofs=[
-  ],
-  serialized_start=158,
-  serialized_end=222,
-)
-
-
-_PCMESSAGE = _descriptor.Descriptor(
-  name='PCMessage',
-  full_name='PCMessage',
-  filename=None,
-  file=DESCRIPTOR,
-  containing_type=None,
-  fields=[
-    _descriptor.FieldDescriptor(
-      name='go', full_name='PCMessage.go', index=0,
-      number=1, type=11, cpp_type=10, label=1,
-      has_default_value=False, default_value=None,
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      options=None),
-    _descriptor.FieldDescriptor(
-      name='stop', full_name='PCMessage.stop', index=1,
-      number=2, type=11, cpp_type=10, label=1,
-      has_default_value=False, default_value=None,
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      options=None),
-    _descriptor.FieldDescriptor(
-      name='controller', full_name='PCMessage.controller', index=2,
-      number=3, type=11, cpp_type=10, label=1,
-      has_default_value=False, default_value=None,
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      options=None),
-    _descriptor.FieldDescriptor(
-      name='get_logs', full_name='PCMessage.get_logs', index=3,
-      number=4, type=11, cpp_type=10, label=1,
-      has_default_value=False, default_value=None,
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      options=None),
-    _descriptor.FieldDescriptor(
-      name='calibrate', full_name='PCMessage.calibrate', index=4,
-      number=5, type=11, cpp_type=10, label=1,
-      has_default_value=False, default_value=None,
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      options=None),
-    _descriptor.FieldDescriptor(
-      name='get_acc', full_name='PCMessage.get_acc', index=5,
-      number=6, type=11, cpp_type=10, label=1,
-      has_default_value=False, default_value=None,
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      options=None),
-    _descriptor.FieldDescriptor(
-      name='set_motors', full_name='PCMessage.set_motors', index=6,
-      number=7, type=11, cpp_type=10, label=1,
-      has_default_value=False, default_value=None,
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      options=None),
-  ],
-  extensions=[
-  ],
-  nested_types=[],
-  enum_types=[
-  ],
-  options=None,
-  is_extendable=False,
-  syntax='proto3',
-  extension_ranges=[],
-  oneofs=[
-    _descriptor.OneofDescriptor(
-      name='msg', full_name='PCMessage.msg',
-      index=0, containing_type=None, fields=[]),
-  ],
-  serialized_start=225,
-  serialized_end=459,
-)
-
-
-_LOGENTRY = _descriptor.Descriptor(
-  name='LogEntry',
-  full_name='LogEntry',
-  filename=None,
-  file=DESCRIPTOR,
-  containing_type=None,
-  fields=[
-    _descriptor.FieldDescriptor(
-      name='droll', full_name='LogEntry.droll', index=0,
-      number=1, type=2, cpp_type=6, label=1,
-      has_default_value=False, default_value=float(0),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      options=None),
-    _descriptor.FieldDescriptor(
-      name='dyaw', full_name='LogEntry.dyaw', index=1,
-      number=2, type=2, cpp_type=6, label=1,
-      has_default_value=False, default_value=float(0),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      options=None),
-    _descriptor.FieldDescriptor(
-      name='dAngleW', full_name='LogEntry.dAngleW', index=2,
-      number=3, type=2, cpp_type=6, label=1,
-      has_default_value=False, default_value=float(0),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      options=None),
-    _descriptor.FieldDescriptor(
-      name='dpitch', full_name='LogEntry.dpitch', index=3,
-      number=4, type=2, cpp_type=6, label=1,
-      has_default_value=False, default_value=float(0),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      options=None),
-    _descriptor.FieldDescriptor(
-      name='dAngleTT', full_name='LogEntry.dAngleTT', index=4,
-      number=5, type=2, cpp_type=6, label=1,
-      has_default_value=False, default_value=float(0),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      options=None),
-    _descriptor.FieldDescriptor(
-      name='xOrigin', full_name='LogEntry.xOrigin', index=5,
-      number=6, type=2, cpp_type=6, label=1,
-      has_default_value=False, default_value=float(0),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      options=None),
-    _descriptor.FieldDescriptor(
-      name='yOrigin', full_name='LogEntry.yOrigin', index=6,
-      number=7, type=2, cpp_type=6, label=1,
-      has_default_value=False, default_value=float(0),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      options=None),
-    _descriptor.FieldDescriptor(
-      name='roll', full_name='LogEntry.roll', index=7,
-      number=8, type=2, cpp_type=6, label=1,
-      has_default_value=False, default_value=float(0),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      options=None),
-    _descriptor.FieldDescriptor(
-      name='yaw', full_name='LogEntry.yaw', index=8,
-      number=9, type=2, cpp_type=6, label=1,
-      has_default_value=False, default_value=float(0),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      options=None),
-    _descriptor.FieldDescriptor(
-      name='pitch', full_name='LogEntry.pitch', index=9,
-      number=10, type=2, cpp_type=6, label=1,
-      has_default_value=False, default_value=float(0),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      options=None),
-    _descriptor.FieldDescriptor(
-      name='x', full_name='LogEntry.x', index=10,
-      number=15, type=2, cpp_type=6, label=1,
-      has_default_value=False, default_value=float(0),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      options=None),
-    _descriptor.FieldDescriptor(
-      name='y', full_name='LogEntry.y', index=11,
-      number=16, type=2, cpp_type=6, label=1,
-      has_default_value=False, default_value=float(0),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      options=None),
-    _descriptor.FieldDescriptor(
-      name='AngleW', full_name='LogEntry.AngleW', index=12,
-      number=17, type=2, cpp_type=6, label=1,
-      has_default_value=False, default_value=float(0),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      options=None),
-    _descriptor.FieldDescriptor(
-      name='AngleTT', full_name='LogEntry.AngleTT', index=13,
-      number=18, type=2, cpp_type=6, label=1,
-      has_default_value=False, default_value=float(0),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      options=None),
-    _descriptor.FieldDescriptor(
-      name='TurntableInput', full_name='LogEntry.TurntableInput', index=14,
-      number=19, type=2, cpp_type=6, label=1,
-      has_default_value=False, default_value=float(0),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      options=None),
-    _descriptor.FieldDescriptor(
-      name='WheelInput', full_name='LogEntry.WheelInput', index=15,
-      number=20, type=2, cpp_type=6, label=1,
-      has_default_value=False, default_value=float(0),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      options=None),
-    _descriptor.FieldDescriptor(
-      name='ddx', full_name='LogEntry.ddx', index=16,
-      number=21, type=2, cpp_type=6, label=1,
-      has_default_value=False, default_value=float(0),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      options=None),
-    _descriptor.FieldDescriptor(
-      name='ddy', full_name='LogEntry.ddy', index=17,
-      number=22, type=2, cpp_type=6, label=1,
-      has_default_value=False, default_value=float(0),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      options=None),
-    _descriptor.FieldDescriptor(
-      name='ddz', full_name='LogEntry.ddz', index=18,
-      number=23, type=2, cpp_type=6, label=1,
-      has_default_value=False, default_value=float(0),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      options=None),
-  ],
-  extensions=[
-  ],
-  nested_types=[],
-  enum_types=[
-  ],
-  options=None,
-  is_extendable=False,
-  syntax='proto3',
-  extension_ranges=[],
-  oneofs=[
-  ],
-  serialized_start=462,
-  serialized_end=766,
-)
-
-
-_LOGBUNDLE = _descriptor.Descriptor(
-  name='LogBundle',
-  full_name='LogBundle',
-  filename=None,
-  file=DESCRIPTOR,
-  containing_type=None,
-  fields=[
-    _descriptor.FieldDescriptor(
-      name='entry', full_name='LogBundle.entry', index=0,
-      number=1, type=11, cpp_type=10, label=3,
-      has_default_value=False, default_value=[],
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      options=None),
-  ],
-  extensions=[
-  ],
-  nested_types=[],
-  enum_types=[
-  ],
-  options=None,
-  is_extendable=False,
-  syntax='proto3',
-  extension_ranges=[],
-  oneofs=[
-  ],
-  serialized_start=768,
-  serialized_end=805,
-)
-
-
-_DEBUGMESSAGE = _descriptor.Descriptor(
-  name='DebugMessage',
-  full_name='DebugMessage',
-  filename=None,
-  file=DESCRIPTOR,
-  containing_type=None,
-  fields=[
-    _descriptor.FieldDescriptor(
-      name='s', full_name='DebugMessage.s', index=0,
-      number=1, type=9, cpp_type=9, label=1,
-      has_default_value=False, default_value=_b("").decode('utf-8'),
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      options=None),
-    _descriptor.FieldDescriptor(
-      name='level', full_name='DebugMessage.level', index=1,
-      number=2, type=14, cpp_type=8, label=1,
-      has_default_value=False, default_value=0,
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      options=None),
-  ],
-  extensions=[
-  ],
-  nested_types=[],
-  enum_types=[
-  ],
-  options=None,
-  is_extendable=False,
-  syntax='proto3',
-  extension_ranges=[],
-  oneofs=[
-  ],
-  serialized_start=807,
-  serialized_end=860,
-)
-
-
-_ROBOTMESSAGE = _descriptor.Descriptor(
-  name='RobotMessage',
-  full_name='RobotMessage',
-  filename=None,
-  file=DESCRIPTOR,
-  containing_type=None,
-  fields=[
-    _descriptor.FieldDescriptor(
-      name='log_bundle', full_name='RobotMessage.log_bundle', index=0,
-      number=1, type=11, cpp_type=10, label=1,
-      has_default_value=False, default_value=None,
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      options=None),
-    _descriptor.FieldDescriptor(
-      name='debug', full_name='RobotMessage.debug', index=1,
-      number=2, type=11, cpp_type=10, label=1,
-      has_default_value=False, default_value=None,
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      options=None),
-    _descriptor.FieldDescriptor(
-      name='single_log', full_name='RobotMessage.single_log', index=2,
-      number=3, type=11, cpp_type=10, label=1,
-      has_default_value=False, default_value=None,
-      message_type=None, enum_type=None, containing_type=None,
-      is_extension=False, extension_scope=None,
-      options=None),
-  ],
-  extensions=[
-  ],
-  nested_types=[],
-  enum_types=[
-  ],
-  options=None,
-  is_extendable=False,
-  syntax='proto3',
-  extension_ranges=[],
-  oneofs=[
-    _descriptor.OneofDescriptor(
-      name='msg', full_name='RobotMessage.msg',
-      index=0, containing_type=None, fields=[]),
-  ],
-  serialized_start=862,
-  serialized_end=982,
-)
-
-_CONTROLLER.fields_by_name['wheel'].message_type = policies__pb2._POLICY
-_CONTROLLER.fields_by_name['turntable'].message_type = policies__pb2._POLICY
-_PCMESSAGE.fields_by_name['go'].message_type = _GO
-_PCMESSAGE.fields_by_name['stop'].message_type = _STOP
-_PCMESSAGE.fields_by_name['controller'].message_type = _CONTROLLER
-_PCMESSAGE.fields_by_name['get_logs'].message_type = _GETLOGS
-_PCMESSAGE.fields_by_name['calibrate'].message_type = _CALIBRATEGYRO
-_PCMESSAGE.fields_by_name['get_acc'].message_type = _GETACCELEROMETER
-_PCMESSAGE.fields_by_name['set_motors'].message_type = _SETMOTORS
-_PCMESSAGE.oneofs_by_name['msg'].fields.append(
-  _PCMESSAGE.fields_by_name['go'])
-_PCMESSAGE.fields_by_name['go'].containing_oneof = _PCMESSAGE.oneofs_by_name['msg']
-_PCMESSAGE.oneofs_by_name['msg'].fields.append(
-  _PCMESSAGE.fields_by_name['stop'])
-_PCMESSAGE.fields_by_name['stop'].containing_oneof = _PCMESSAGE.oneofs_by_name['msg']
-_PCMESSAGE.oneofs_by_name['msg'].fields.append(
-  _PCMESSAGE.fields_by_name['controller'])
-_PCMESSAGE.fields_by_name['controller'].containing_oneof = _PCMESSAGE.oneofs_by_name['msg']
-_PCMESSAGE.oneofs_by_name['msg'].fields.append(
-  _PCMESSAGE.fields_by_name['get_logs'])
-_PCMESSAGE.fields_by_name['get_logs'].containing_oneof = _PCMESSAGE.oneofs_by_name['msg']
-_PCMESSAGE.oneofs_by_name['msg'].fields.append(
-  _PCMESSAGE.fields_by_name['calibrate'])
-_PCMESSAGE.fields_by_name['calibrate'].containing_oneof = _PCMESSAGE.oneofs_by_name['msg']
-_PCMESSAGE.oneofs_by_name['msg'].fields.append(
-  _PCMESSAGE.fields_by_name['get_acc'])
-_PCMESSAGE.fields_by_name['get_acc'].containing_oneof = _PCMESSAGE.oneofs_by_name['msg']
-_PCMESSAGE.oneofs_by_name['msg'].fields.append(
-  _PCMESSAGE.fields_by_name['set_motors'])
-_PCMESSAGE.fields_by_name['set_motors'].containing_oneof = _PCMESSAGE.oneofs_by_name['msg']
-_LOGBUNDLE.fields_by_name['entry'].message_type = _LOGENTRY
-_DEBUGMESSAGE.fields_by_name['level'].enum_type = _DEBUGLEVEL
-_ROBOTMESSAGE.fields_by_name['log_bundle'].message_type = _LOGBUNDLE
-_ROBOTMESSAGE.fields_by_name['debug'].message_type = _DEBUGMESSAGE
-_ROBOTMESSAGE.fields_by_name['single_log'].message_type = _LOGENTRY
-_ROBOTMESSAGE.oneofs_by_name['msg'].fields.append(
-  _ROBOTMESSAGE.fields_by_name['log_bundle'])
-_ROBOTMESSAGE.fields_by_name['log_bundle'].containing_oneof = _ROBOTMESSAGE.oneofs_by_name['msg']
-_ROBOTMESSAGE.oneofs_by_name['msg'].fields.append(
-  _ROBOTMESSAGE.fields_by_name['debug'])
-_ROBOTMESSAGE.fields_by_name['debug'].containing_oneof = _ROBOTMESSAGE.oneofs_by_name['msg']
-_ROBOTMESSAGE.oneofs_by_name['msg'].fields.append(
-  _ROBOTMESSAGE.fields_by_name['single_log'])
-_ROBOTMESSAGE.fields_by_name['single_log'].containing_oneof = _ROBOTMESSAGE.oneofs_by_name['msg']
-DESCRIPTOR.message_types_by_name['Go'] = _GO
-DESCRIPTOR.message_types_by_name['Stop'] = _STOP
-DESCRIPTOR.message_types_by_name['GetLogs'] = _GETLOGS
-DESCRIPTOR.message_types_by_name['CalibrateGyro'] = _CALIBRATEGYRO
-DESCRIPTOR.message_types_by_name['GetAccelerometer'] = _GETACCELEROMETER
-DESCRIPTOR.message_types_by_name['SetMotors'] = _SETMOTORS
-DESCRIPTOR.message_types_by_name['Controller'] = _CONTROLLER
-DESCRIPTOR.message_types_by_name['PCMessage'] = _PCMESSAGE
-DESCRIPTOR.message_types_by_name['LogEntry'] = _LOGENTRY
-DESCRIPTOR.message_types_by_name['LogBundle'] = _LOGBUNDLE
-DESCRIPTOR.message_types_by_name['DebugMessage'] = _DEBUGMESSAGE
-DESCRIPTOR.message_types_by_name['RobotMessage'] = _ROBOTMESSAGE
-DESCRIPTOR.enum_types_by_name['DebugLevel'] = _DEBUGLEVEL
-
-Go = _reflection.GeneratedProtocolMessageType('Go', (_message.Message,), dict(
-  DESCRIPTOR = _GO,
-  __module__ = 'messages_pb2'
-  # @@protoc_insertion_point(class_scope:Go)
-  ))
-_sym_db.RegisterMessage(Go)
-
-Stop = _reflection.GeneratedProtocolMessageType('Stop', (_message.Message,), dict(
-  DESCRIPTOR = _STOP,
-  __module__ = 'messages_pb2'
-  # @@protoc_insertion_point(class_scope:Stop)
-  ))
-_sym_db.RegisterMessage(Stop)
-
-GetLogs = _reflection.GeneratedProtocolMessageType('GetLogs', (_message.Message,), dict(
-  DESCRIPTOR = _GETLOGS,
-  __module__ = 'messages_pb2'
-  # @@protoc_insertion_point(class_scope:GetLogs)
-  ))
-_sym_db.RegisterMessage(GetLogs)
-
-CalibrateGyro = _reflection.GeneratedProtocolMessageType('CalibrateGyro', (_message.Message,), dict(
-  DESCRIPTOR = _CALIBRATEGYRO,
-  __module__ = 'messages_pb2'
-  # @@protoc_insertion_point(class_scope:CalibrateGyro)
-  ))
-_sym_db.RegisterMessage(CalibrateGyro)
-
-GetAccelerometer = _reflection.GeneratedProtocolMessageType('GetAccelerometer', (_message.Message,), dict(
-  DESCRIPTOR = _GETACCELEROMETER,
-  __module__ = 'messages_pb2'
-  # @@protoc_insertion_point(class_scope:GetAccelerometer)
-  ))
-_sym_db.RegisterMessage(GetAccelerometer)
-
-SetMotors = _reflection.GeneratedProtocolMessageType('SetMotors', (_message.Message,), dict(
-  DESCRIPTOR = _SETMOTORS,
-  __module__ = 'messages_pb2'
-  # @@protoc_insertion_point(class_scope:SetMotors)
-  ))
-_sym_db.RegisterMessage(SetMotors)
-
-Controller = _reflection.GeneratedProtocolMessageType('Controller', (_message.Message,), dict(
-  DESCRIPTOR = _CONTROLLER,
-  __module__ = 'messages_pb2'
-  # @@protoc_insertion_point(class_scope:Controller)
-  ))
-_sym_db.RegisterMessage(Controller)
-
-PCMessage = _reflection.GeneratedProtocolMessageType('PCMessage', (_message.Message,), dict(
-  DESCRIPTOR = _PCMESSAGE,
-  __module__ = 'messages_pb2'
-  # @@protoc_insertion_point(class_scope:PCMessage)
-  ))
-_sym_db.RegisterMessage(PCMessage)
-
-LogEntry = _reflection.GeneratedProtocolMessageType('LogEntry', (_message.Message,), dict(
-  DESCRIPTOR = _LOGENTRY,
-  __module__ = 'messages_pb2'
-  # @@protoc_insertion_point(class_scope:LogEntry)
-  ))
-_sym_db.RegisterMessage(LogEntry)
-
-LogBundle = _reflection.GeneratedProtocolMessageType('LogBundle', (_message.Message,), dict(
-  DESCRIPTOR = _LOGBUNDLE,
-  __module__ = 'messages_pb2'
-  # @@protoc_insertion_point(class_scope:LogBundle)
-  ))
-_sym_db.RegisterMessage(LogBundle)
-
-DebugMessage = _reflection.GeneratedProtocolMessageType('DebugMessage', (_message.Message,), dict(
-  DESCRIPTOR = _DEBUGMESSAGE,
-  __module__ = 'messages_pb2'
-  # @@protoc_insertion_point(class_scope:DebugMessage)
-  ))
-_sym_db.RegisterMessage(DebugMessage)
-
-RobotMessage = _reflection.GeneratedProtocolMessageType('RobotMessage', (_message.Message,), dict(
-  DESCRIPTOR = _ROBOTMESSAGE,
-  __module__ = 'messages_pb2'
-  # @@protoc_insertion_point(class_scope:RobotMessage)
-  ))
-_sym_db.RegisterMessage(RobotMessage)
-
-
+DESCRIPTOR = _descriptor_pool.Default().AddSerializedFile(b'\n\x0emessages.proto\x1a\x0epolicies.proto\",\n\x0cLogFieldRate\x12\r\n\x05\x66ield\x18\x01 \x01(\r\x12\r\n\x05\x65very\x18\x02 \x01(\r\"\x92\x01\n\x02Go\x12\r\n\x05steps\x18\x01 \x01(\x05\x12\x13\n\x0bpolicy_slot\x18\x02 \x01(\r\x12\x0e\n\x06stream\x18\x03 \x01(\x08\x12\"\n\x0clog_encoding\x18\x04 \x01(\x0e\x32\x0c.LogEncoding\x12\x12\n\nlog_fields\x18\x05 \x01(\r\x12 \n\tlog_rates\x18\x06 \x03(\x0b\x32\r.LogFieldRate\"\x06\n\x04Stop\"\t\n\x07GetLogs\"\x0f\n\rCalibrateGyro\"\x12\n\x10GetAccelerometer\"-\n\tSetMotors\x12\r\n\x05wheel\x18\x01 \x01(\x02\x12\x11\n\tturntable\x18\x02 \x01(\x02\"\'\n\x04Vec3\x12\t\n\x01x\x18\x01 \x01(\x02\x12\t\n\x01y\x18\x02 \x01(\x02\x12\t\n\x01z\x18\x03 \x01(\x02\"d\n\x11SensorCalibration\x12\x12\n\x03m_x\x18\x01 \x01(\x0b\x32\x05.Vec3\x12\x12\n\x03m_y\x18\x02 \x01(\x0b\x32\x05.Vec3\x12\x12\n\x03m_z\x18\x03 \x01(\x0b\x32\x05.Vec3\x12\x13\n\x04\x62ias\x18\x04 \x01(\x0b\x32\x05.Vec3\"X\n\x11SetImuCalibration\x12 \n\x04gyro\x18\x01 \x01(\x0b\x32\x12.SensorCalibration\x12!\n\x05\x61\x63\x63\x65l\x18\x02 \x01(\x0b\x32\x12.SensorCalibration\"@\n\nController\x12\x16\n\x05wheel\x18\x01 \x01(\x0b\x32\x07.Policy\x12\x1a\n\tturntable\x18\x02 \x01(\x0b\x32\x07.Policy\"<\n\x0bStorePolicy\x12\x0c\n\x04slot\x18\x01 \x01(\r\x12\x1f\n\ncontroller\x18\x02 \x01(\x0b\x32\x0b.Controller\">\n\x11PolicyCoefficient\x12\x0e\n\x06policy\x18\x01 \x01(\r\x12\n\n\x02id\x18\x02 \x01(\r\x12\r\n\x05value\x18\x03 \x01(\x02\"K\n\x0bPatchPolicy\x12\"\n\x06\x63oeffs\x18\x01 \x03(\x0b\x32\x12.PolicyCoefficient\x12\x0c\n\x04\x62\x61se\x18\x02 \x01(\r\x12\n\n\x02id\x18\x03 \x01(\r\"\xe9\x02\n\tPCMessage\x12\x11\n\x02go\x18\x01 \x01(\x0b\x32\x03.GoH\x00\x12\x15\n\x04stop\x18\x02 \x01(\x0b\x32\x05.StopH\x00\x12!\n\ncontroller\x18\x03 \x01(\x0b\x32\x0b.ControllerH\x00\x12\x1c\n\x08get_logs\x18\x04 \x01(\x0b\x32\x08.GetLogsH\x00\x12#\n\tcalibrate\x18\x05 \x01(\x0b\x32\x0e.CalibrateGyroH\x00\x12$\n\x07get_acc\x18\x06 \x01(\x0b\x32\x11.GetAccelerometerH\x00\x12 \n\nset_motors\x18\x07 \x01(\x0b\x32\n.SetMotorsH\x00\x12\x31\n\x13set_imu_calibration\x18\x08 \x01(\x0b\x32\x12.SetImuCalibrationH\x00\x12$\n\x0cstore_policy\x18\t \x01(\x0b\x32\x0c.StorePolicyH\x00\x12$\n\x0cpatch_policy\x18\n \x01(\x0b\x32\x0c.PatchPolicyH\x00\x42\x05\n\x03msg\"\x8a\x03\n\x08LogEntry\x12\r\n\x05\x64roll\x18\x01 \x01(\x02\x12\x0c\n\x04\x64yaw\x18\x02 \x01(\x02\x12\x0f\n\x07\x64\x41ngleW\x18\x03 \x01(\x02\x12\x0e\n\x06\x64pitch\x18\x04 \x01(\x02\x12\x10\n\x08\x64\x41ngleTT\x18\x05 \x01(\x02\x12\x0f\n\x07xOrigin\x18\x06 \x01(\x02\x12\x0f\n\x07yOrigin\x18\x07 \x01(\x02\x12\x0c\n\x04roll\x18\x08 \x01(\x02\x12\x0b\n\x03yaw\x18\t \x01(\x02\x12\r\n\x05pitch\x18\n \x01(\x02\x12\t\n\x01x\x18\x0f \x01(\x02\x12\t\n\x01y\x18\x10 \x01(\x02\x12\x0e\n\x06\x41ngleW\x18\x11 \x01(\x02\x12\x0f\n\x07\x41ngleTT\x18\x12 \x01(\x02\x12\x16\n\x0eTurntableInput\x18\x13 \x01(\x02\x12\x12\n\nWheelInput\x18\x14 \x01(\x02\x12\x0b\n\x03\x64\x64x\x18\x15 \x01(\x02\x12\x0b\n\x03\x64\x64y\x18\x16 \x01(\x02\x12\x0b\n\x03\x64\x64z\x18\x17 \x01(\x02\x12\x0c\n\x04tick\x18\x18 \x01(\r\x12\x16\n\x0epolicy_version\x18\x19 \x01(\r\x12\x0c\n\x04lead\x18\x1a \x01(\x02\x12\x0f\n\x07latency\x18\x1b \x01(\x02\x12\x13\n\x0bpolicy_slot\x18\x1c \x01(\r\"N\n\tLogBundle\x12\x18\n\x05\x65ntry\x18\x01 \x03(\x0b\x32\t.LogEntry\x12\'\n\rcompact_entry\x18\x03 \x03(\x0b\x32\x10.CompactLogEntry\"%\n\x0f\x43ompactLogEntry\x12\x12\n\x06packed\x18\x01 \x03(\x07\x42\x02\x10\x01\"%\n\x06LogGap\x12\x0c\n\x04tick\x18\x01 \x01(\r\x12\r\n\x05\x63ount\x18\x02 \x01(\r\"+\n\tStreamEnd\x12\r\n\x05ticks\x18\x01 \x01(\r\x12\x0f\n\x07\x64ropped\x18\x02 \x01(\r\"5\n\x0c\x44\x65\x62ugMessage\x12\t\n\x01s\x18\x01 \x01(\t\x12\x1a\n\x05level\x18\x02 \x01(\x0e\x32\x0b.DebugLevel\"\xdf\x01\n\x0cRobotMessage\x12 \n\nlog_bundle\x18\x01 \x01(\x0b\x32\n.LogBundleH\x00\x12\x1e\n\x05\x64\x65\x62ug\x18\x02 \x01(\x0b\x32\r.DebugMessageH\x00\x12\x1f\n\nsingle_log\x18\x03 \x01(\x0b\x32\t.LogEntryH\x00\x12\x1a\n\x07log_gap\x18\x04 \x01(\x0b\x32\x07.LogGapH\x00\x12 \n\nstream_end\x18\x05 \x01(\x0b\x32\n.StreamEndH\x00\x12\'\n\x0b\x63ompact_log\x18\x06 \x01(\x0b\x32\x10.CompactLogEntryH\x00\x42\x05\n\x03msg*,\n\x0bLogEncoding\x12\x0c\n\x08\x46ULL_LOG\x10\x00\x12\x0f\n\x0b\x43OMPACT_LOG\x10\x01*\xbb\x03\n\x0e\x43ompactLogBits\x12\r\n\tBITS_NONE\x10\x00\x12\x0e\n\nBITS_droll\x10\x10\x12\r\n\tBITS_dyaw\x10\x10\x12\x10\n\x0c\x42ITS_dAngleW\x10\x0c\x12\x0f\n\x0b\x42ITS_dpitch\x10\x10\x12\x11\n\rBITS_dAngleTT\x10\x0c\x12\x10\n\x0c\x42ITS_xOrigin\x10\r\x12\x10\n\x0c\x42ITS_yOrigin\x10\r\x12\r\n\tBITS_roll\x10\r\x12\x0c\n\x08\x42ITS_yaw\x10\r\x12\x0e\n\nBITS_pitch\x10\r\x12\n\n\x06\x42ITS_x\x10\x0c\x12\n\n\x06\x42ITS_y\x10\x0c\x12\x0f\n\x0b\x42ITS_AngleW\x10\r\x12\x10\n\x0c\x42ITS_AngleTT\x10\r\x12\x17\n\x13\x42ITS_TurntableInput\x10\x0b\x12\x13\n\x0f\x42ITS_WheelInput\x10\x0b\x12\x0c\n\x08\x42ITS_ddx\x10\x0b\x12\x0c\n\x08\x42ITS_ddy\x10\x0b\x12\x0c\n\x08\x42ITS_ddz\x10\x0b\x12\r\n\tBITS_tick\x10\x10\x12\x17\n\x13\x42ITS_policy_version\x10\x04\x12\r\n\tBITS_lead\x10\x0b\x12\x10\n\x0c\x42ITS_latency\x10\x0b\x12\x14\n\x10\x42ITS_policy_slot\x10\x03\x1a\x02\x10\x01*\xfd\x02\n\x0e\x43ompactLogStep\x12\r\n\tSTEP_NONE\x10\x00\x12\x0e\n\nSTEP_droll\x10\t\x12\r\n\tSTEP_dyaw\x10\t\x12\x10\n\x0cSTEP_dAngleW\x10\x04\x12\x0f\n\x0bSTEP_dpitch\x10\t\x12\x11\n\rSTEP_dAngleTT\x10\x04\x12\x10\n\x0cSTEP_xOrigin\x10\x08\x12\x10\n\x0cSTEP_yOrigin\x10\x08\x12\r\n\tSTEP_roll\x10\n\x12\x0c\n\x08STEP_yaw\x10\n\x12\x0e\n\nSTEP_pitch\x10\n\x12\n\n\x06STEP_x\x10\x07\x12\n\n\x06STEP_y\x10\x07\x12\x0f\n\x0bSTEP_AngleW\x10\x05\x12\x10\n\x0cSTEP_AngleTT\x10\x05\x12\x17\n\x13STEP_TurntableInput\x10\x07\x12\x13\n\x0fSTEP_WheelInput\x10\x07\x12\x0c\n\x08STEP_ddx\x10\x05\x12\x0c\n\x08STEP_ddy\x10\x05\x12\x0c\n\x08STEP_ddz\x10\x05\x12\r\n\tSTEP_lead\x10\x11\x12\x10\n\x0cSTEP_latency\x10\x11\x1a\x02\x10\x01*6\n\nDebugLevel\x12\t\n\x05\x44\x45\x42UG\x10\x00\x12\x08\n\x04INFO\x10\x01\x12\x08\n\x04WARN\x10\x02\x12\t\n\x05\x45RROR\x10\x03\x62\x06proto3')
+
+_builder.BuildMessageAndEnumDescriptors(DESCRIPTOR, globals())
+_builder.BuildTopDescriptorsAndMessages(DESCRIPTOR, 'messages_pb2', globals())
+if _descriptor._USE_C_DESCRIPTORS == False:
+
+  DESCRIPTOR._options = None
+  _COMPACTLOGBITS._options = None
+  _COMPACTLOGBITS._serialized_options = b'\020\001'
+  _COMPACTLOGSTEP._options = None
+  _COMPACTLOGSTEP._serialized_options = b'\020\001'
+  _COMPACTLOGENTRY.fields_by_name['packed']._options = None
+  _COMPACTLOGENTRY.fields_by_name['packed']._serialized_options = b'\020\001'
+  _LOGENCODING._serialized_start=2079
+  _LOGENCODING._serialized_end=2123
+  _COMPACTLOGBITS._serialized_start=2126
+  _COMPACTLOGBITS._serialized_end=2569
+  _COMPACTLOGSTEP._serialized_start=2572
+  _COMPACTLOGSTEP._serialized_end=2953
+  _DEBUGLEVEL._serialized_start=2955
+  _DEBUGLEVEL._serialized_end=3009
+  _LOGFIELDRATE._serialized_start=34
+  _LOGFIELDRATE._serialized_end=78
+  _GO._serialized_start=81
+  _GO._serialized_end=227
+  _STOP._serialized_start=229
+  _STOP._serialized_end=235
+  _GETLOGS._serialized_start=237
+  _GETLOGS._serialized_end=246
+  _CALIBRATEGYRO._serialized_start=248
+  _CALIBRATEGYRO._serialized_end=263
+  _GETACCELEROMETER._serialized_start=265
+  _GETACCELEROMETER._serialized_end=283
+  _SETMOTORS._serialized_start=285
+  _SETMOTORS._serialized_end=330
+  _VEC3._serialized_start=332
+  _VEC3._serialized_end=371
+  _SENSORCALIBRATION._serialized_start=373
+  _SENSORCALIBRATION._serialized_end=473
+  _SETIMUCALIBRATION._serialized_start=475
+  _SETIMUCALIBRATION._serialized_end=563
+  _CONTROLLER._serialized_start=565
+  _CONTROLLER._serialized_end=629
+  _STOREPOLICY._serialized_start=631
+  _STOREPOLICY._serialized_end=691
+  _POLICYCOEFFICIENT._serialized_start=693
+  _POLICYCOEFFICIENT._serialized_end=755
+  _PATCHPOLICY._serialized_start=757
+  _PATCHPOLICY._serialized_end=832
+  _PCMESSAGE._serialized_start=835
+  _PCMESSAGE._serialized_end=1196
+  _LOGENTRY._serialized_start=1199
+  _LOGENTRY._serialized_end=1593
+  _LOGBUNDLE._serialized_start=1595
+  _LOGBUNDLE._serialized_end=1673
+  _COMPACTLOGENTRY._serialized_start=1675
+  _COMPACTLOGENTRY._serialized_end=1712
+  _LOGGAP._serialized_start=1714
+  _LOGGAP._serialized_end=1751
+  _STREAMEND._serialized_start=1753
+  _STREAMEND._serialized_end=1796
+  _DEBUGMESSAGE._serialized_start=1798
+  _DEBUGMESSAGE._serialized_end=1851
+  _ROBOTMESSAGE._serialized_start=1854
+  _ROBOTMESSAGE._serialized_end=2077
 # @@protoc_insertion_point(module_scope)
@@ -0,0 +1,112 @@
+"""
+PatchPolicy messages, which change only the coefficients of a controller that
+differ from the one the robot already has.
+
+The coefficients of each policy are numbered as in PolicyCoefficient in
+messages.proto, which must match patchPolicy in src/policy.cpp.
+"""
+import messages_pb2
+import policies_pb2
+
+# the LinearPolicy fields, in the order of their ids
+_state_fields = sorted(policies_pb2.LinearPolicy.DESCRIPTOR.fields, key=lambda f: f.number)
+_outputs = sorted(messages_pb2.Controller.DESCRIPTOR.fields, key=lambda f: f.number)
+
+# the max_count of PatchPolicy.coeffs in messages.options
+max_coeffs = 32
+
+
+def coefficients(policy):
+    """
+    The coefficients of a policy as a dict from id to value, or None if the
+    policy cannot be patched
+
+    >>> p = policies_pb2.Policy()
+    >>> p.affine.k_bias = 0.5
+    >>> p.affine.k_lin.k_roll = 2
+    >>> c = coefficients(p)
+    >>> len(c), c[0], c[8]
+    (11, 0.5, 2.0)
+    >>> p.quad.k_quad.k_roll.k_pitch = 3
+    >>> c = coefficients(p)
+    >>> len(c), c[11 + 10*7 + 9]
+    (111, 3.0)
+    >>> p.sparse.coeffs.extend([1, 2])
+    >>> coefficients(p)
+    {0: 0.0, 1: 1.0, 2: 2.0}
+    >>> p.rbf.k_bias = 1
+    >>> coefficients(p) is None
+    True
+    """
+    which = policy.WhichOneof('msg')
+    if which == 'sparse':
+        c = {0: policy.sparse.k_bias}
+        c.update((1 + t, v) for t, v in enumerate(policy.sparse.coeffs))
+        return c
+    if which == 'lin':
+        c, lin, quad = {}, policy.lin, None
+    elif which == 'affine':
+        c, lin, quad = {0: policy.affine.k_bias}, policy.affine.k_lin, None
+    elif which == 'quad':
+        c, lin, quad = {0: policy.quad.k_bias}, policy.quad.k_lin, policy.quad.k_quad
+    else:
+        return None
+
+    n = len(_state_fields)
+    for i, f in enumerate(_state_fields):
+        c[1 + i] = getattr(lin, f.name)
+    if quad is not None:
+        for a, fa in enumerate(_state_fields):
+            row = getattr(quad, fa.name)
+            for b, fb in enumerate(_state_fields):
+                c[1 + n + n*a + b] = getattr(row, fb.name)
+    return c
+
+
+def _same_shape(old, new):
+    """ Whether two policies have the same type, and the same sparse terms """
+    if old.WhichOneof('msg') != new.WhichOneof('msg'):
+        return False
+    if new.WhichOneof('msg') == 'sparse':
+        return (old.sparse.lin_mask == new.sparse.lin_mask and
+                old.sparse.quad_mask == new.sparse.quad_mask and
+                len(old.sparse.coeffs) == len(new.sparse.coeffs))
+    return True
+
+
+def patch(old, new):
+    """
+    A PatchPolicy that turns the Controller old into new, or None if that
+    cannot be done by changing at most max_coeffs coefficients
+
+    >>> old = messages_pb2.Controller()
+    >>> old.wheel.affine.k_lin.k_pitch = 1
+    >>> old.turntable.lin.k_yaw = 1
+    >>> new = messages_pb2.Controller()
+    >>> new.CopyFrom(old)
+    >>> new.turntable.lin.k_yaw = -2
+    >>> print(patch(old, new))
+    coeffs {
+      policy: 2
+      id: 9
+      value: -2
+    }
+    <BLANKLINE>
+    >>> new.wheel.lin.k_pitch = 1
+    >>> patch(old, new) is None
+    True
+    """
+    result = messages_pb2.PatchPolicy()
+    for f in _outputs:
+        p_old, p_new = getattr(old, f.name), getattr(new, f.name)
+        if not _same_shape(p_old, p_new):
+            return None
+        c_old, c_new = coefficients(p_old), coefficients(p_new)
+        if c_new is None:
+            return None
+        for i in sorted(c_new):
+            if c_new[i] != c_old[i]:
+                result.coeffs.add(policy=f.number, id=i, value=c_new[i])
+    if len(result.coeffs) > max_coeffs:
+        return None
+    return result
@@ -0,0 +1,71 @@
+"""
+Conversion of dense policies to SparsePolicy, dropping the small coefficients.
+
+This shrinks both the upload over the serial link, and the time the robot
+spends evaluating the policy, which only visits the terms that are present.
+"""
+import policies_pb2
+
+# the LinearPolicy fields, in the order of the SparsePolicy mask bits
+_state_fields = sorted(policies_pb2.LinearPolicy.DESCRIPTOR.fields, key=lambda f: f.number)
+
+
+def _dense_terms(policy):
+    """
+    The bias, linear coefficients, and upper triangle of Q + Q^T of a linear,
+    affine or quadratic policy, or None for other types
+    """
+    n = len(_state_fields)
+    which = policy.WhichOneof('msg')
+    if which == 'lin':
+        bias, lin, quad = 0.0, policy.lin, None
+    elif which == 'affine':
+        bias, lin, quad = policy.affine.k_bias, policy.affine.k_lin, None
+    elif which == 'quad':
+        bias, lin, quad = policy.quad.k_bias, policy.quad.k_lin, policy.quad.k_quad
+    else:
+        return None
+
+    lin_coeffs = [getattr(lin, f.name) for f in _state_fields]
+    quad_coeffs = []
+    for a in range(n):
+        for b in range(a, n):
+            if quad is None:
+                quad_coeffs.append(0.0)
+                continue
+            q_ab = getattr(getattr(quad, _state_fields[a].name), _state_fields[b].name)
+            q_ba = getattr(getattr(quad, _state_fields[b].name), _state_fields[a].name)
+            quad_coeffs.append(q_ab if a == b else q_ab + q_ba)
+    return bias, lin_coeffs, quad_coeffs
+
+
+def sparsify(policy, threshold=0.0):
+    """
+    Convert a linear, affine or quadratic Policy to a SparsePolicy, keeping
+    only the coefficients with a magnitude above threshold. Other types are
+    returned unchanged.
+    """
+    terms = _dense_terms(policy)
+    if terms is None:
+        return policy
+    bias, lin_coeffs, quad_coeffs = terms
+
+    result = policies_pb2.Policy()
+    sparse = result.sparse
+    sparse.k_bias = bias
+    for i, c in enumerate(lin_coeffs):
+        if abs(c) > threshold:
+            sparse.lin_mask |= 1 << i
+            sparse.coeffs.append(c)
+    for i, c in enumerate(quad_coeffs):
+        if abs(c) > threshold:
+            sparse.quad_mask |= 1 << i
+            sparse.coeffs.append(c)
+    return result
+
+
+def sparsify_controller(controller, threshold=0.0):
+    """ Sparsify both policies of a Controller in place, returning it """
+    for name in ('wheel', 'turntable'):
+        getattr(controller, name).CopyFrom(sparsify(getattr(controller, name), threshold))
+    return controller
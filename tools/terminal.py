@@ -3,12 +3,15 @@ import asyncio
 import os
 import sys
 import functools
+import itertools
 import time
 
 import messages_pb2
 import comms
 from async_helpers import async_race, intercept_ctrlc
 import matlabio
+import sparsify
+import policy_patch
 
 from prompt_toolkit.shortcuts import style_from_dict
 from simple_commands import CommandBase
@@ -48,6 +51,13 @@ class ProtobufLexer(RegexLexer):
     }
 
 
+# the control period of the robot, dt in src/main.cpp, in seconds
+dt = 50e-3
+
+# how long a streamed run can send nothing before the link is taken as lost
+stream_timeout = 5.0
+
+
 def requires_connection(method):
     """ Takes a method, and wraps it such that it errors if self.stream is None """
     @functools.wraps(method)
@@ -80,6 +90,16 @@ class Commands(CommandBase):
         self.awaited_log_bundle = None
         self.log_queue = None
 
+        self.awaited_stream_end = None
+        # when the last entry of a streamed run arrived, or None before the first
+        self.stream_last_entry = None
+
+        # the Controller last sent to the robot, which patches apply to, and
+        # the id of the last patch of it, which the next patch names as its base
+        self.robot_controller = None
+        self.robot_patch_id = 0
+        self.patch_ids = itertools.count(1)
+
     def _log(self, level, text, robot=False):
         text = str(text)
         if '\n' in text:
@@ -121,6 +141,9 @@ class Commands(CommandBase):
                 messages_pb2.ERROR: self.error
             }.get(val.debug.level, self.debug)
             log_func(val.debug.s, robot=True)
+            if val.debug.level == messages_pb2.ERROR:
+                # a patch may have been rejected, so send the next policy in full
+                self.robot_controller = None
 
         elif which == 'log_bundle':
             val = val.log_bundle
@@ -132,6 +155,7 @@ class Commands(CommandBase):
         elif which == 'single_log':
             val = val.single_log
 
+            self.stream_last_entry = time.time()
             if self.log_queue is not None:
                 self.log_queue.append(val)
 
@@ -143,6 +167,15 @@ class Commands(CommandBase):
             else:
                 self.warn("More log entries arrived after saving the file")
 
+        elif which == 'log_gap':
+            self.stream_last_entry = time.time()
+            self.warn('Entries from tick {} to {} were dropped'.format(
+                val.log_gap.tick, val.log_gap.tick + val.log_gap.count - 1), robot=True)
+
+        elif which == 'stream_end':
+            if self.awaited_stream_end and not self.awaited_stream_end.done():
+                self.awaited_stream_end.set_result(val.stream_end)
+
         else:
             self.print_pb_message(val)
 
@@ -163,6 +196,8 @@ class Commands(CommandBase):
             self.stream = None
             if self.awaited_log_bundle:
                 self.awaited_log_bundle.set_exception(e)
+            if self.awaited_stream_end and not self.awaited_stream_end.done():
+                self.awaited_stream_end.set_exception(e)
 
     # methods that perform the actions, with no command parsing
 
@@ -174,6 +209,7 @@ class Commands(CommandBase):
         ser = comms.connect()
 
         print("Connected!")
+        self.robot_controller = None
 
         self.stream = comms.ProtobufStream(comms.COBSStream(ser))
         self.incoming_task = asyncio.ensure_future(self._recv_incoming_task())
@@ -194,17 +230,29 @@ class Commands(CommandBase):
         self.stream = None
         await self.incoming_task
 
-    async def run_go(self, steps=50, forever=False):
+    async def run_go(self, steps=50, forever=False, slot=0, stream=False, compact=False,
+                     fields=None):
         # send the initial message to set things going
         msg = messages_pb2.PCMessage()
         msg.go.SetInParent()
         msg.go.steps = steps if not forever else -1
+        msg.go.policy_slot = slot
+        msg.go.stream = stream
+        if slot:
+            # the robot rejects patches to a policy that is no longer in use
+            self.robot_controller = None
+        if compact:
+            msg.go.log_encoding = messages_pb2.COMPACT_LOG
+        if fields:
+            comms.set_log_fields(msg.go, fields)
         self.send(msg)
 
-        if forever:
-            fname, actual_steps = await self.handle_go_forever_response()
+        if stream:
+            fname, actual_steps = await self.handle_go_stream_response(compact, fields)
+        elif forever:
+            fname, actual_steps = await self.handle_go_forever_response(compact)
         else:
-            fname, actual_steps = await self.handle_go_response()
+            fname, actual_steps = await self.handle_go_response(compact)
 
         if not forever and steps > actual_steps:
             self.warn('Rollout was shorter than expected')
@@ -212,7 +260,8 @@ class Commands(CommandBase):
         self.info('Saved rollout of {} steps to {}'.format(actual_steps, fname))
 
 
-    async def handle_go_forever_response(self):
+    async def handle_go_forever_response(self, compact=False):
+        # only the latest entry is sent each time, so some may be missing
         self.log_queue = q = []
 
         try:
@@ -221,10 +270,58 @@ class Commands(CommandBase):
             self.log_queue = None
             await self.run_stop()
 
-        target = self.log_saver.save(q)
+        target = self.log_saver.save(q, compact)
         return target, len(q)
 
-    async def handle_go_response(self):
+    async def await_stream_end(self, end, timeout):
+        """
+        Wait for the StreamEnd, raising asyncio.TimeoutError once nothing of
+        the run has arrived for timeout seconds. Before the first entry, this
+        waits for as long as the robot waits for its button.
+        """
+        while not end.done():
+            last = self.stream_last_entry
+            if last is not None and time.time() - last > timeout:
+                raise asyncio.TimeoutError
+            await asyncio.wait([end], timeout=0.5)
+        return end.result()
+
+    async def handle_go_stream_response(self, compact=False, fields=None):
+        self.log_queue = q = []
+        self.awaited_stream_end = end = asyncio.Future()
+        self.stream_last_entry = None
+        # allow for fields sent only every so many ticks
+        timeout = stream_timeout + dt * max(fields.values() if fields else [1])
+
+        try:
+            try:
+                await async_race(self.await_stream_end(end, timeout), intercept_ctrlc())
+            except KeyboardInterrupt:
+                await self.run_stop()
+                # the robot sends what it has buffered before the StreamEnd,
+                # so wait for that, but no longer than for an entry
+                self.info('Waiting for the rest of the entries')
+                self.stream_last_entry = time.time()
+                await async_race(self.await_stream_end(end, timeout), intercept_ctrlc())
+        except KeyboardInterrupt:
+            self.warn('Saving without the rest of the entries')
+        except asyncio.TimeoutError:
+            self.warn('Nothing arrived for {:.1f} s, so saving without the rest of the entries'.format(timeout))
+        except comms.SerialException:
+            self.warn('Saving without the rest of the entries')
+        finally:
+            self.log_queue = None
+            self.awaited_stream_end = None
+
+        ended = end.done() and not end.exception()
+        if ended and end.result().dropped:
+            self.warn('{} of {} entries were dropped, as the link could not keep up'.format(
+                end.result().dropped, end.result().ticks))
+        target = self.log_saver.save(q, compact)
+        # entries are not sent on ticks where no selected field is due
+        return target, end.result().ticks if ended else len(q)
+
+    async def handle_go_response(self, compact=False):
         # prepare to recieve the logs
         msg = messages_pb2.PCMessage()
         msg.get_logs.SetInParent()
@@ -275,7 +372,7 @@ class Commands(CommandBase):
             raise
 
         self.info('Success')
-        target = self.log_saver.save(val)
+        target = self.log_saver.save(val, compact)
         return target, len(val)
 
     async def run_stop(self):
@@ -285,13 +382,47 @@ class Commands(CommandBase):
         msg.stop.SetInParent()
         self.send(msg)
 
-    async def run_policy(self, matfile):
-        msg = messages_pb2.PCMessage()
-        msg.controller.SetInParent()
+    def load_controller(self, controller, matfile, prune=None):
+        controller.SetInParent()
         if matfile != '!none':
-            msg.controller.CopyFrom(matlabio.load_policy(matfile))
+            controller.CopyFrom(matlabio.load_policy(matfile))
+            if prune is not None:
+                dense_size = controller.ByteSize()
+                sparsify.sparsify_controller(controller, prune)
+                self.info('Pruned the policy from {} to {} bytes'.format(dense_size, controller.ByteSize()))
+
+    async def run_policy(self, matfile, prune=None):
+        msg = messages_pb2.PCMessage()
+        self.load_controller(msg.controller, matfile, prune)
+        self.print_pb_message(msg)
+
+        controller = msg.controller
+
+        # send only the coefficients that changed, if that is smaller
+        delta = None
+        if self.robot_controller is not None:
+            delta = policy_patch.patch(self.robot_controller, controller)
+        if delta is not None:
+            delta.base = self.robot_patch_id
+            delta.id = next(self.patch_ids)
+            patch_msg = messages_pb2.PCMessage()
+            patch_msg.patch_policy.CopyFrom(delta)
+            if patch_msg.ByteSize() < msg.ByteSize():
+                self.info('Patching {} coefficients, in {} rather than {} bytes'.format(
+                    len(delta.coeffs), patch_msg.ByteSize(), msg.ByteSize()))
+                msg = patch_msg
+        self.send(msg)
+        self.robot_controller = controller
+        self.robot_patch_id = msg.patch_policy.id if msg.WhichOneof('msg') == 'patch_policy' else 0
+
+    async def run_store(self, slot, matfile, prune=None):
+        msg = messages_pb2.PCMessage()
+        msg.store_policy.slot = slot
+        self.load_controller(msg.store_policy.controller, matfile, prune)
         self.print_pb_message(msg)
         self.send(msg)
+        # a `go` to this slot would leave no policy to patch
+        self.robot_controller = None
 
     async def run_calibrate(self):
         msg = messages_pb2.PCMessage()
@@ -303,6 +434,14 @@ class Commands(CommandBase):
         msg.get_acc.SetInParent()
         self.send(msg)
 
+    async def run_imu_calibration(self, matfile):
+        msg = messages_pb2.PCMessage()
+        msg.set_imu_calibration.SetInParent()
+        if matfile != '!none':
+            msg.set_imu_calibration.CopyFrom(matlabio.load_imu_calibration(matfile))
+        self.print_pb_message(msg)
+        self.send(msg)
+
     async def run_motor(self, wheel, turntable):
         msg = messages_pb2.PCMessage()
         msg.set_motors.SetInParent()
@@ -347,23 +486,76 @@ class Commands(CommandBase):
         """
         Start a test run.
 
-        Optionally takes an argument, the number of iterations to run for
+        Optionally takes an argument, the number of iterations to run for,
+        and the slot of a policy sent with `store` to run. With `stream`,
+        the entries are sent during the run, so that it can be longer than
+        the robot can store. With `compact`, the entries are quantized to
+        about a third of the size, as CompactLogEntry.
+
+        A run until stopped sends only the latest entry whenever the link
+        allows, unless it streams them too.
+
+        With `fields`, the entries sent during a run have only the LogEntry
+        fields listed, each sent every tick, or every <m> ticks as
+        `<field>/<m>`. Those not sent are saved as NaN
         ::
             go
             go <n>
             go forever
+            go forever stream
+            go <n> stream
+            go forever fields pitch,roll,yaw/10
+            go [<n> | forever] [stream] [compact] [fields <field>[/<m>],...] slot <k>
         """
-        if arg == 'forever':
-            await self.run_go(forever=True)
-        elif arg:
+        args = arg.split()
+        slot = 0
+        stream = False
+        compact = False
+        fields = None
+        if len(args) >= 2 and args[-2] == 'slot':
             try:
-                steps = int(arg)
+                slot = int(args[-1])
+            except ValueError:
+                self.error("Invalid slot {!r}".format(args[-1]))
+                return
+            args = args[:-2]
+        if len(args) >= 2 and args[-2] == 'fields':
+            fields = {}
+            for spec in args[-1].split(','):
+                name, _, every = spec.partition('/')
+                try:
+                    fields[name] = int(every) if every else 1
+                except ValueError:
+                    self.error("Invalid rate {!r}".format(spec))
+                    return
+            try:
+                comms.set_log_fields(messages_pb2.Go(), fields)
+            except ValueError as e:
+                self.error(e)
+                return
+            args = args[:-2]
+        if args and args[-1] == 'compact':
+            compact = True
+            args = args[:-1]
+        if args and args[-1] == 'stream':
+            stream = True
+            args = args[:-1]
+        if fields and not stream and args != ['forever']:
+            self.warn("The fields are only chosen for runs that stream their entries")
+
+        if args == ['forever']:
+            await self.run_go(forever=True, slot=slot, stream=stream, compact=compact, fields=fields)
+        elif len(args) == 1:
+            try:
+                steps = int(args[0])
             except ValueError:
                 self.error("Invalid argument {!r}".format(arg))
             else:
-                await self.run_go(steps)
+                await self.run_go(steps, slot=slot, stream=stream, compact=compact, fields=fields)
+        elif not args:
+            await self.run_go(slot=slot, stream=stream, compact=compact, fields=fields)
         else:
-            await self.run_go()
+            self.error("Invalid argument {!r}".format(arg))
 
     @requires_connection
     @no_argument
@@ -378,15 +570,48 @@ class Commands(CommandBase):
     @requires_connection
     async def do_policy(self, arg):
         """
-        Set the policy, from a mat file
+        Set the policy, from a mat file. Given a threshold, linear, affine and
+        quadratic policies are sent as sparse policies, without the
+        coefficients that are no larger than it. When only some coefficients
+        differ from the last policy sent, only those are sent
         ::
-            policy <file>
+            policy <file> [<threshold>]
             policy !none
         """
         if not arg:
             self.error('No file specified')
             return
-        await self.run_policy(matfile=arg)
+        matfile, _, prune = arg.rpartition(' ')
+        try:
+            prune = float(prune)
+        except ValueError:
+            matfile, prune = arg, None
+        await self.run_policy(matfile=matfile, prune=prune)
+
+    @requires_connection
+    async def do_store(self, arg):
+        """
+        Store a policy from a mat file in a slot of the robot's policy bank,
+        numbered from 1, without using it yet. `go ... slot <k>` then runs it.
+        The threshold prunes it as for `policy`
+        ::
+            store <k> <file> [<threshold>]
+        """
+        slot, _, arg = arg.partition(' ')
+        try:
+            slot = int(slot)
+        except ValueError:
+            self.error('Invalid slot {!r}'.format(slot))
+            return
+        if not arg:
+            self.error('No file specified')
+            return
+        matfile, _, prune = arg.rpartition(' ')
+        try:
+            prune = float(prune)
+        except ValueError:
+            matfile, prune = arg, None
+        await self.run_store(slot, matfile=matfile, prune=prune)
 
     @requires_connection
     @no_argument
@@ -406,6 +631,21 @@ class Commands(CommandBase):
         """
         await self.run_get_acc()
 
+    @requires_connection
+    async def do_imu_cal(self, arg):
+        """
+        Set the correction matrix and bias of the gyro and accelerometer, from
+        a mat file with structs `gyro` and `accel`, each with fields `M` and
+        `bias`. `!none` removes the correction
+        ::
+            imu_cal <file>
+            imu_cal !none
+        """
+        if not arg:
+            self.error('No file specified')
+            return
+        await self.run_imu_calibration(matfile=arg)
+
     async def do_motor(self, arg):
         """
         Set the motor speeds
@@ -5,6 +5,8 @@ import doctest
 def load_tests(loader, tests, ignore):
     tests.addTests(doctest.DocTestSuite('async_helpers.shared'))
     tests.addTests(doctest.DocTestSuite('async_helpers.pipe'))
+    tests.addTests(doctest.DocTestSuite('policy_patch'))
+    tests.addTests(doctest.DocTestSuite('comms'))
     return tests
 
 